@@ -0,0 +1,113 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Checks that the controllers do not allocate on the control thread, against MockFrankaHW:
+//   roscore &
+//   rosrun franka_interactive_controllers franka_rt_allocation_check [ticks]
+// Each controller is initialized with the parameters of franka_interactive_controllers_bench and
+// switched on and off once, so that one-time setup (e.g. the first log message) is not counted.
+// It is then driven through starting(), `ticks` update()s (default 10000) over the synthetic
+// robot states and stopping() with the thread armed in libfranka_allocation_counter, which this
+// executable links. Exits with 1 if any controller allocated or failed to initialize.
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <ros/ros.h>
+
+#include <allocation_counter.h>
+#include <cartesian_force_controller.h>
+#include <cartesian_pose_impedance_controller.h>
+#include <cartesian_twist_impedance_controller.h>
+#include <joint_gravity_compensation_controller.h>
+#include <joint_impedance_franka_controller.h>
+
+#include "controller_parameters.h"
+#include "mock_franka_hw.h"
+#include "synthetic_states.h"
+
+namespace franka_interactive_controllers {
+namespace bench {
+namespace {
+
+constexpr size_t kSyntheticSamples = 10000;
+std::vector<MockSample> g_samples;
+
+// Returns false if init() fails or any allocation was counted.
+template <class Controller>
+bool checkController(const std::string& name, const ParameterSetup& setup, size_t ticks) {
+  MockFrankaHW robot_hw;
+  robot_hw.setSample(g_samples.front());
+
+  ros::NodeHandle node_handle("~/" + name);
+  setup(node_handle);
+  Controller controller;
+  if (!controller.init(&robot_hw, node_handle)) {
+    std::cout << name << ": init() failed" << std::endl;
+    return false;
+  }
+  const ros::Time time(0.0);
+  const ros::Duration period(0.001);
+  controller.starting(time);
+  controller.update(time, period);
+  controller.stopping(time);
+
+  RealtimeAllocationCheck allocation_check;
+  allocation_check.start();
+  controller.starting(time);
+  for (size_t tick = 0; tick < ticks; ++tick) {
+    robot_hw.setSample(g_samples[tick % g_samples.size()]);
+    controller.update(time, period);
+  }
+  controller.stopping(time);
+  const std::size_t allocations = allocation_check.stop();
+
+  std::cout << name << ": " << allocations << " allocations in " << ticks << " ticks"
+            << std::endl;
+  return allocations == 0;
+}
+
+}  // namespace
+}  // namespace bench
+}  // namespace franka_interactive_controllers
+
+int main(int argc, char** argv) {
+  using namespace franka_interactive_controllers;
+  using namespace franka_interactive_controllers::bench;
+
+  ros::init(argc, argv, "franka_rt_allocation_check", ros::init_options::NoSigintHandler);
+  if (argc > 2) {
+    std::cerr << "Usage: " << argv[0] << " [ticks]" << std::endl;
+    return -1;
+  }
+  const size_t ticks = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+  if (!RealtimeAllocationCheck::available()) {
+    std::cerr << "libfranka_allocation_counter is not loaded" << std::endl;
+    return -1;
+  }
+  if (!ros::master::check()) {
+    std::cerr << "No ROS master, start roscore first" << std::endl;
+    return -1;
+  }
+  g_samples = syntheticSamples(kSyntheticSamples);
+
+  bool passed = true;
+  for (const char* method : {"svd", "ldlt", "cod"}) {
+    passed &= checkController<CartesianPoseImpedanceController>(
+        "cartesian_pose_impedance_" + std::string(method), impedanceParameters(method), ticks);
+  }
+  passed &= checkController<CartesianTwistImpedanceController>(
+      "cartesian_twist_impedance", impedanceParameters("svd"), ticks);
+  passed &= checkController<JointGravityCompensationController>(
+      "joint_gravity_compensation", impedanceParameters("svd"), ticks);
+  passed &= checkController<CartesianForceController>(
+      "cartesian_force", ParameterSetup(setCommonParameters), ticks);
+  passed &= checkController<JointImpedanceFrankaController>(
+      "joint_impedance", ParameterSetup(jointImpedanceParameters), ticks);
+
+  ros::shutdown();
+  std::cout << (passed ? "OK" : "FAILED") << std::endl;
+  return passed ? 0 : 1;
+}
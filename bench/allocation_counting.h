@@ -0,0 +1,56 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Heap allocations of a benchmark loop as counted by libfranka_allocation_counter, which is
+// linked into franka_interactive_controllers_bench. Reported as a counter averaged over the
+// iterations, so it reads as allocations per tick/call.
+//
+// Usage:
+//   AllocationCounting allocations;  // arms the counter for the calling thread
+//   for (auto _ : state) { ... }
+//   allocations.report(state, "allocs_per_call");
+#pragma once
+
+#include <cstddef>
+
+#include <benchmark/benchmark.h>
+
+// Provided by libfranka_allocation_counter.so, linked into the benchmark.
+extern "C" {
+void franka_allocation_counter_arm() __attribute__((weak));
+void franka_allocation_counter_disarm() __attribute__((weak));
+std::size_t franka_allocation_counter_count() __attribute__((weak));
+}
+
+namespace franka_interactive_controllers {
+namespace bench {
+
+class AllocationCounting {
+ public:
+  static bool available() { return franka_allocation_counter_arm != nullptr; }
+
+  AllocationCounting() {
+    if (available()) {
+      count_at_start_ = franka_allocation_counter_count();
+      franka_allocation_counter_arm();
+    }
+  }
+
+  // Disarms the counter and adds the allocations since construction to state.counters[name];
+  // nothing without the counter library.
+  void report(benchmark::State& state, const char* name) {
+    if (!available()) {
+      return;
+    }
+    franka_allocation_counter_disarm();
+    const std::size_t allocations = franka_allocation_counter_count() - count_at_start_;
+    state.counters[name] =
+        benchmark::Counter(static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+  }
+
+ private:
+  std::size_t count_at_start_{0};
+};
+
+}  // namespace bench
+}  // namespace franka_interactive_controllers
@@ -0,0 +1,168 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Hardware-free benchmarks of the controllers' update(), run against MockFrankaHW.
+//
+//   roscore &
+//   rosrun franka_interactive_controllers franka_interactive_controllers_bench
+//       [--states=<recorded.csv>] [google benchmark flags]
+//
+// Each controller is initialized from parameters set here (a master is needed for its node
+// handles, parameters and dynamic reconfigure servers), started, and update() is timed over a
+// loop of robot state samples: synthetic by default, or a CSV of q1..q7,dq1..dq7 per line.
+// Besides the time per update() every benchmark reports allocs_per_tick, the heap allocations
+// made by the loop as counted by libfranka_allocation_counter.
+//
+// Results are also written as JSON (franka_interactive_controllers_bench.json unless
+// --benchmark_out is given); compare two runs with compare.py from Google Benchmark's tools.
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <ros/ros.h>
+
+#include <cartesian_force_controller.h>
+#include <cartesian_pose_impedance_controller.h>
+#include <cartesian_twist_impedance_controller.h>
+#include <joint_gravity_compensation_controller.h>
+#include <joint_impedance_franka_controller.h>
+
+#include "allocation_counting.h"
+#include "controller_parameters.h"
+#include "mock_franka_hw.h"
+#include "synthetic_states.h"
+
+namespace franka_interactive_controllers {
+namespace bench {
+namespace {
+
+constexpr size_t kSyntheticSamples = 10000;
+std::vector<MockSample> g_samples;
+
+template <class Controller>
+void controllerUpdate(benchmark::State& state,
+                      const std::string& name,
+                      const ParameterSetup& setup) {
+  MockFrankaHW robot_hw;
+  robot_hw.setSample(g_samples.front());
+
+  ros::NodeHandle node_handle("~/" + name);
+  setup(node_handle);
+  Controller controller;
+  if (!controller.init(&robot_hw, node_handle)) {
+    state.SkipWithError("controller init() failed");
+    return;
+  }
+  const ros::Time time(0.0);
+  const ros::Duration period(0.001);
+  controller.starting(time);
+
+  AllocationCounting allocations;
+  size_t sample = 0;
+  for (auto _ : state) {
+    robot_hw.setSample(g_samples[sample]);
+    if (++sample == g_samples.size()) {
+      sample = 0;
+    }
+    controller.update(time, period);
+    benchmark::DoNotOptimize(robot_hw.effortCommand());
+  }
+  allocations.report(state, "allocs_per_tick");
+  controller.stopping(time);
+}
+
+// Cost of switching the mock to the next sample, included in every controller benchmark.
+void mockSetSample(benchmark::State& state) {
+  MockFrankaHW robot_hw;
+  size_t sample = 0;
+  for (auto _ : state) {
+    robot_hw.setSample(g_samples[sample]);
+    if (++sample == g_samples.size()) {
+      sample = 0;
+    }
+    benchmark::ClobberMemory();
+  }
+}
+
+void registerControllerBenchmarks() {
+  benchmark::RegisterBenchmark("MockFrankaHW/setSample", mockSetSample);
+  for (const char* method : {"svd", "ldlt", "cod"}) {
+    const std::string suffix = std::string("/") + method;
+    benchmark::RegisterBenchmark(
+        ("CartesianPoseImpedanceController/update" + suffix).c_str(),
+        controllerUpdate<CartesianPoseImpedanceController>,
+        "cartesian_pose_impedance_" + std::string(method), impedanceParameters(method));
+  }
+  benchmark::RegisterBenchmark("CartesianTwistImpedanceController/update",
+                               controllerUpdate<CartesianTwistImpedanceController>,
+                               "cartesian_twist_impedance", impedanceParameters("svd"));
+  benchmark::RegisterBenchmark("JointGravityCompensationController/update",
+                               controllerUpdate<JointGravityCompensationController>,
+                               "joint_gravity_compensation", impedanceParameters("svd"));
+  benchmark::RegisterBenchmark("CartesianForceController/update",
+                               controllerUpdate<CartesianForceController>, "cartesian_force",
+                               ParameterSetup(setCommonParameters));
+  benchmark::RegisterBenchmark("JointImpedanceFrankaController/update",
+                               controllerUpdate<JointImpedanceFrankaController>, "joint_impedance",
+                               ParameterSetup(jointImpedanceParameters));
+}
+
+}  // namespace
+}  // namespace bench
+}  // namespace franka_interactive_controllers
+
+int main(int argc, char** argv) {
+  using namespace franka_interactive_controllers::bench;
+
+  ros::init(argc, argv, "franka_interactive_controllers_bench",
+            ros::init_options::NoSigintHandler);
+
+  // Own flags, removed before Google Benchmark parses the rest
+  std::string states_file;
+  bool has_output = false;
+  std::vector<char*> arguments;
+  for (int i = 0; i < argc; ++i) {
+    if (std::strncmp(argv[i], "--states=", 9) == 0) {
+      states_file = argv[i] + 9;
+      continue;
+    }
+    if (std::strncmp(argv[i], "--benchmark_out=", 16) == 0) {
+      has_output = true;
+    }
+    arguments.push_back(argv[i]);
+  }
+  std::string output_flag("--benchmark_out=franka_interactive_controllers_bench.json");
+  std::string format_flag("--benchmark_out_format=json");
+  if (!has_output) {
+    arguments.push_back(&output_flag[0]);
+    arguments.push_back(&format_flag[0]);
+  }
+
+  if (states_file.empty()) {
+    g_samples = syntheticSamples(kSyntheticSamples);
+  } else if (!recordedSamples(states_file, &g_samples)) {
+    ROS_ERROR_STREAM("franka_interactive_controllers_bench: Could not read robot states from "
+                     << states_file << " (expected 14 values q1..q7,dq1..dq7 per line)");
+    return 1;
+  }
+
+  if (ros::master::check()) {
+    registerControllerBenchmarks();
+  } else {
+    ROS_WARN("franka_interactive_controllers_bench: No ROS master, running the micro benchmarks "
+             "only. Start roscore to benchmark the controllers.");
+  }
+  if (!AllocationCounting::available()) {
+    ROS_WARN("franka_interactive_controllers_bench: libfranka_allocation_counter not loaded, "
+             "allocations per tick and call are not reported.");
+  }
+
+  int argument_count = static_cast<int>(arguments.size());
+  benchmark::Initialize(&argument_count, arguments.data());
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  ros::shutdown();
+  return 0;
+}
@@ -0,0 +1,47 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Parameters the hardware-free runs of the controllers (benchmarks, allocation check) load into
+// a controller's node handle before init(), in place of the YAML files of the launch files.
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <ros/node_handle.h>
+
+namespace franka_interactive_controllers {
+namespace bench {
+
+using ParameterSetup = std::function<void(ros::NodeHandle&)>;
+
+inline void setCommonParameters(ros::NodeHandle& node_handle) {
+  node_handle.setParam("arm_id", std::string("panda"));
+  std::vector<std::string> joint_names;
+  for (int i = 1; i <= 7; ++i) {
+    joint_names.push_back("panda_joint" + std::to_string(i));
+  }
+  node_handle.setParam("joint_names", joint_names);
+  node_handle.setParam("external_tool_compensation", std::vector<double>(6, 0.0));
+}
+
+inline ParameterSetup impedanceParameters(const std::string& pseudo_inverse_method) {
+  return [pseudo_inverse_method](ros::NodeHandle& node_handle) {
+    setCommonParameters(node_handle);
+    node_handle.setParam("cartesian_stiffness_target",
+                         std::vector<double>{600, 600, 600, 50, 50, 50});
+    node_handle.setParam("nullspace_stiffness_target",
+                         std::vector<double>{5, 10, 0.0001, 0.05, 5, 0.05, 1});
+    node_handle.setParam("pseudo_inverse_method", pseudo_inverse_method);
+  };
+}
+
+inline void jointImpedanceParameters(ros::NodeHandle& node_handle) {
+  setCommonParameters(node_handle);
+  node_handle.setParam("k_gains", std::vector<double>{600, 600, 600, 600, 250, 150, 50});
+  node_handle.setParam("d_gains", std::vector<double>{50, 50, 50, 20, 20, 20, 10});
+}
+
+}  // namespace bench
+}  // namespace franka_interactive_controllers
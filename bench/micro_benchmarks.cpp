@@ -0,0 +1,317 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Micro benchmarks of the building blocks of the torque laws; these need no ROS master.
+//   PseudoInverse/*   damped pseudo inverse of the 7x6 Jacobian transpose, per solver, with the
+//                     heap allocations per solve as allocs_per_call
+//   ImpedanceGain/*   K * e for each gain structure (argument: diagonal 0, block diagonal 1,
+//                     full 2) against a plain dense product
+//   TripleBuffer/*    RT side read of a controller target
+//   CycleTimer/*      histogram update done by CycleTimer every tick
+//   PandaKinematics/* pose and zero Jacobian per configuration: closed-form kernel, batch of
+//                     PandaKinematics::kLanes configurations and a generic 4x4 DH chain
+//   PandaDynamics/*   RNEA, CRBA mass matrix (against one RNEA per column), Coriolis matrix
+//                     and gravity with the Franka Hand as load
+#include <benchmark/benchmark.h>
+#include <Eigen/Dense>
+
+#include <cycle_timing.h>
+#include <impedance_gain.h>
+#include <panda_dynamics.h>
+#include <panda_kinematics.h>
+#include <pseudo_inversion.h>
+#include <triple_buffer.h>
+
+#include "allocation_counting.h"
+#include "synthetic_states.h"
+
+namespace franka_interactive_controllers {
+namespace bench {
+namespace {
+
+constexpr size_t kJacobians = 1024;
+
+std::vector<Eigen::Matrix<double, 7, 6>> jacobianTransposes() {
+  std::vector<Eigen::Matrix<double, 7, 6>> result;
+  for (const MockSample& sample : syntheticSamples(kJacobians)) {
+    result.push_back(Eigen::Map<const Eigen::Matrix<double, 6, 7>>(sample.zero_jacobian.data())
+                         .transpose());
+  }
+  return result;
+}
+
+void pseudoInverseSolver(benchmark::State& state, PseudoInverseMethod method) {
+  const auto jacobians = jacobianTransposes();
+  const DampedPseudoInverse<7, 6> solver(method);
+  Eigen::Matrix<double, 6, 7> pinv;
+  size_t i = 0;
+  AllocationCounting allocations;
+  for (auto _ : state) {
+    solver.compute(jacobians[i], pinv);
+    benchmark::DoNotOptimize(pinv.data());
+    i = (i + 1) % kJacobians;
+  }
+  allocations.report(state, "allocs_per_call");
+}
+BENCHMARK_CAPTURE(pseudoInverseSolver, svd, PseudoInverseMethod::kSVD)
+    ->Name("PseudoInverse/svd");
+BENCHMARK_CAPTURE(pseudoInverseSolver, ldlt, PseudoInverseMethod::kLDLT)
+    ->Name("PseudoInverse/ldlt");
+BENCHMARK_CAPTURE(pseudoInverseSolver, cod, PseudoInverseMethod::kCOD)
+    ->Name("PseudoInverse/cod");
+
+// Previous dynamic-size implementation, for reference
+void pseudoInverseDynamic(benchmark::State& state) {
+  const auto jacobians = jacobianTransposes();
+  Eigen::MatrixXd pinv;
+  size_t i = 0;
+  AllocationCounting allocations;
+  for (auto _ : state) {
+    pseudoInverse(jacobians[i], pinv);
+    benchmark::DoNotOptimize(pinv.data());
+    i = (i + 1) % kJacobians;
+  }
+  allocations.report(state, "allocs_per_call");
+}
+BENCHMARK(pseudoInverseDynamic)->Name("PseudoInverse/dynamic_svd");
+
+template <int N>
+typename ImpedanceGain<N>::MatrixType spdMatrix(GainStructure structure) {
+  using MatrixType = typename ImpedanceGain<N>::MatrixType;
+  MatrixType random = MatrixType::Random();
+  MatrixType matrix = random * random.transpose() + N * MatrixType::Identity();
+  if (structure == GainStructure::kDiagonal) {
+    return matrix.diagonal().asDiagonal();
+  }
+  if (structure == GainStructure::kBlockDiagonal) {
+    matrix.template topRightCorner<3, N - 3>().setZero();
+    matrix.template bottomLeftCorner<N - 3, 3>().setZero();
+  }
+  return matrix;
+}
+
+template <int N>
+void impedanceGain(benchmark::State& state) {
+  const GainStructure structure = static_cast<GainStructure>(state.range(0));
+  const ImpedanceGain<N> gain = ImpedanceGain<N>::fromMatrix(spdMatrix<N>(structure));
+  typename ImpedanceGain<N>::VectorType error = ImpedanceGain<N>::VectorType::Random();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(error.data());
+    typename ImpedanceGain<N>::VectorType result = gain * error;
+    benchmark::DoNotOptimize(result.data());
+  }
+  state.SetLabel(gainStructureName(gain.structure()));
+}
+
+template <int N>
+void denseGain(benchmark::State& state) {
+  const typename ImpedanceGain<N>::MatrixType matrix = spdMatrix<N>(GainStructure::kFull);
+  typename ImpedanceGain<N>::VectorType error = ImpedanceGain<N>::VectorType::Random();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(error.data());
+    typename ImpedanceGain<N>::VectorType result = matrix * error;
+    benchmark::DoNotOptimize(result.data());
+  }
+}
+
+constexpr int kDiagonal = static_cast<int>(GainStructure::kDiagonal);
+constexpr int kBlockDiagonal = static_cast<int>(GainStructure::kBlockDiagonal);
+constexpr int kFull = static_cast<int>(GainStructure::kFull);
+
+BENCHMARK_TEMPLATE(impedanceGain, 6)
+    ->Name("ImpedanceGain/6")
+    ->Arg(kDiagonal)
+    ->Arg(kBlockDiagonal)
+    ->Arg(kFull);
+BENCHMARK_TEMPLATE(denseGain, 6)->Name("ImpedanceGain/6/dense_matrix");
+BENCHMARK_TEMPLATE(impedanceGain, 7)
+    ->Name("ImpedanceGain/7")
+    ->Arg(kDiagonal)
+    ->Arg(kBlockDiagonal)
+    ->Arg(kFull);
+BENCHMARK_TEMPLATE(denseGain, 7)->Name("ImpedanceGain/7/dense_matrix");
+
+struct Target {
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  Eigen::Vector3d position;
+  Eigen::Quaterniond orientation;
+  Eigen::Matrix<double, 6, 6> stiffness;
+};
+
+void tripleBufferRead(benchmark::State& state) {
+  TripleBuffer<Target> buffer;
+  Target target;
+  target.position.setZero();
+  target.orientation.setIdentity();
+  target.stiffness.setIdentity();
+  buffer.reset(target);
+  for (auto _ : state) {
+    const Target& current = buffer.readFromRT();
+    benchmark::DoNotOptimize(current.position.data());
+  }
+}
+BENCHMARK(tripleBufferRead)->Name("TripleBuffer/readFromRT");
+
+void latencyHistogramRecord(benchmark::State& state) {
+  LatencyHistogram histogram;
+  int64_t value = 1000;
+  for (auto _ : state) {
+    histogram.record(value);
+    value = (value * 7 + 13) & 0xfffff;
+  }
+  benchmark::DoNotOptimize(histogram.count());
+}
+BENCHMARK(latencyHistogramRecord)->Name("CycleTimer/histogram_record");
+
+constexpr size_t kConfigurations = 1024;
+
+Eigen::Matrix<double, 7, Eigen::Dynamic> configurations() {
+  const std::vector<MockSample> samples = syntheticSamples(kConfigurations);
+  Eigen::Matrix<double, 7, Eigen::Dynamic> q(7, samples.size());
+  for (size_t i = 0; i < samples.size(); ++i) {
+    q.col(i) = Eigen::Map<const Eigen::Matrix<double, 7, 1>>(samples[i].state.q.data());
+  }
+  return q;
+}
+
+Eigen::Matrix4d handTransform() {
+  const MockSample sample = makeSample({}, {});
+  return Eigen::Map<const Eigen::Matrix4d>(sample.state.F_T_EE.data());
+}
+
+void pandaKinematicsCompute(benchmark::State& state) {
+  const Eigen::Matrix<double, 7, Eigen::Dynamic> q = configurations();
+  const Eigen::Matrix4d F_T_EE = handTransform();
+  PandaKinematics<>::Result result;
+  Eigen::Index i = 0;
+  for (auto _ : state) {
+    PandaKinematics<>::compute(q.col(i), F_T_EE, Eigen::Matrix4d::Identity(), &result);
+    benchmark::DoNotOptimize(result.zero_jacobian.data());
+    i = (i + 1) % q.cols();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(pandaKinematicsCompute)->Name("PandaKinematics/compute");
+
+void pandaKinematicsBatch(benchmark::State& state) {
+  const Eigen::Matrix<double, 7, Eigen::Dynamic> q = configurations();
+  const Eigen::Matrix4d F_T_EE = handTransform();
+  constexpr int kLanes = PandaKinematics<>::kLanes;
+  Eigen::Matrix<double, 16, kLanes> poses;
+  Eigen::Matrix<double, 42, kLanes> jacobians;
+  Eigen::Index i = 0;
+  for (auto _ : state) {
+    PandaKinematics<>::computeBatch(q.middleCols<kLanes>(i), F_T_EE, Eigen::Matrix4d::Identity(),
+                                    &poses, &jacobians);
+    benchmark::DoNotOptimize(jacobians.data());
+    i = (i + kLanes) % q.cols();
+  }
+  state.SetItemsProcessed(state.iterations() * kLanes);
+}
+BENCHMARK(pandaKinematicsBatch)->Name("PandaKinematics/batch");
+
+// Generic chain of 4x4 modified DH transforms as it was used before, for reference
+void pandaKinematicsDhChain(benchmark::State& state) {
+  static const double kA[7] = {0.0, 0.0, 0.0, 0.0825, -0.0825, 0.0, 0.088};
+  static const double kD[7] = {0.333, 0.0, 0.316, 0.0, 0.384, 0.0, 0.0};
+  static const double kAlpha[7] = {0.0, -M_PI_2, M_PI_2, M_PI_2, -M_PI_2, M_PI_2, M_PI_2};
+  const Eigen::Matrix<double, 7, Eigen::Dynamic> q = configurations();
+  Eigen::Matrix4d flange_to_ee = handTransform();
+  flange_to_ee(2, 3) += 0.107;
+  Eigen::Matrix<double, 6, 7> jacobian;
+  Eigen::Index i = 0;
+  for (auto _ : state) {
+    Eigen::Matrix4d transform = Eigen::Matrix4d::Identity();
+    Eigen::Matrix<double, 3, 7> axes, origins;
+    for (int j = 0; j < 7; ++j) {
+      const double ca = std::cos(kAlpha[j]), sa = std::sin(kAlpha[j]);
+      const double ct = std::cos(q(j, i)), st = std::sin(q(j, i));
+      Eigen::Matrix4d link;
+      link << ct, -st, 0.0, kA[j],
+              st * ca, ct * ca, -sa, -kD[j] * sa,
+              st * sa, ct * sa, ca, kD[j] * ca,
+              0.0, 0.0, 0.0, 1.0;
+      transform = transform * link;
+      axes.col(j) = transform.block<3, 1>(0, 2);
+      origins.col(j) = transform.block<3, 1>(0, 3);
+    }
+    transform = transform * flange_to_ee;
+    const Eigen::Vector3d position = transform.block<3, 1>(0, 3);
+    for (int j = 0; j < 7; ++j) {
+      jacobian.block<3, 1>(0, j) = axes.col(j).cross(position - origins.col(j));
+      jacobian.block<3, 1>(3, j) = axes.col(j);
+    }
+    benchmark::DoNotOptimize(jacobian.data());
+    i = (i + 1) % q.cols();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(pandaKinematicsDhChain)->Name("PandaKinematics/dh_chain_reference");
+
+PandaDynamics handDynamics() {
+  PandaDynamics::Load hand;
+  hand.mass = 0.73;
+  hand.center_of_mass << -0.01, 0.0, 0.03;
+  hand.inertia.diagonal() << 0.001, 0.0025, 0.0017;
+  return PandaDynamics(hand);
+}
+
+enum class DynamicsQuantity {
+  kInverseDynamics,
+  kMassMatrix,
+  kMassMatrixRnea,
+  kCoriolisMatrix,
+  kGravity
+};
+
+void pandaDynamics(benchmark::State& state, DynamicsQuantity quantity) {
+  const Eigen::Matrix<double, 7, Eigen::Dynamic> q = configurations();
+  const PandaDynamics dynamics = handDynamics();
+  const Eigen::Vector3d gravity_earth(0.0, 0.0, -9.81);
+  const PandaDynamics::Vector7d dq = PandaDynamics::Vector7d::Constant(0.5);
+  const PandaDynamics::Vector7d ddq = PandaDynamics::Vector7d::Constant(0.1);
+  PandaDynamics::Vector7d tau;
+  PandaDynamics::Matrix7d matrix;
+  Eigen::Index i = 0;
+  for (auto _ : state) {
+    switch (quantity) {
+      case DynamicsQuantity::kInverseDynamics:
+        dynamics.inverseDynamics(q.col(i), dq, ddq, gravity_earth, &tau);
+        break;
+      case DynamicsQuantity::kMassMatrix:
+        dynamics.massMatrix(q.col(i), &matrix);
+        break;
+      case DynamicsQuantity::kMassMatrixRnea:
+        for (int j = 0; j < PandaDynamics::kJoints; ++j) {
+          dynamics.inverseDynamics(q.col(i), PandaDynamics::Vector7d::Zero(),
+                                   PandaDynamics::Vector7d::Unit(j), Eigen::Vector3d::Zero(),
+                                   &tau);
+          matrix.col(j) = tau;
+        }
+        break;
+      case DynamicsQuantity::kCoriolisMatrix:
+        dynamics.coriolisMatrix(q.col(i), dq, &matrix);
+        break;
+      case DynamicsQuantity::kGravity:
+        dynamics.gravityVector(q.col(i), gravity_earth, &tau);
+        break;
+    }
+    benchmark::DoNotOptimize(tau.data());
+    benchmark::DoNotOptimize(matrix.data());
+    i = (i + 1) % q.cols();
+  }
+}
+BENCHMARK_CAPTURE(pandaDynamics, rnea, DynamicsQuantity::kInverseDynamics)
+    ->Name("PandaDynamics/inverse_dynamics");
+BENCHMARK_CAPTURE(pandaDynamics, crba, DynamicsQuantity::kMassMatrix)
+    ->Name("PandaDynamics/mass_matrix");
+BENCHMARK_CAPTURE(pandaDynamics, rnea_columns, DynamicsQuantity::kMassMatrixRnea)
+    ->Name("PandaDynamics/mass_matrix_rnea_columns");
+BENCHMARK_CAPTURE(pandaDynamics, coriolis, DynamicsQuantity::kCoriolisMatrix)
+    ->Name("PandaDynamics/coriolis_matrix");
+BENCHMARK_CAPTURE(pandaDynamics, gravity, DynamicsQuantity::kGravity)
+    ->Name("PandaDynamics/gravity");
+
+}  // namespace
+}  // namespace bench
+}  // namespace franka_interactive_controllers
@@ -0,0 +1,144 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// RobotHW exposing the interfaces and handle names franka_hw provides (panda_robot, panda_model,
+// panda_joint1..7), backed by MockSample data instead of a robot. setSample() switches every
+// handle to the next state in place, so a benchmark loop does no work besides the controller's.
+#pragma once
+
+#include <array>
+#include <string>
+
+#include <franka_hw/franka_cartesian_command_interface.h>
+#include <franka_hw/franka_model_interface.h>
+#include <franka_hw/franka_state_interface.h>
+#include <hardware_interface/joint_command_interface.h>
+#include <hardware_interface/joint_state_interface.h>
+#include <hardware_interface/robot_hw.h>
+
+#include "synthetic_states.h"
+
+namespace franka_interactive_controllers {
+namespace bench {
+
+// Returns the model quantities precomputed for the current sample.
+class MockFrankaModel : public franka_hw::ModelBase {
+ public:
+  void setSample(const MockSample* sample) { sample_ = sample; }
+
+  std::array<double, 16> pose(franka::Frame /*frame*/,
+                              const std::array<double, 7>& /*q*/,
+                              const std::array<double, 16>& /*F_T_EE*/,
+                              const std::array<double, 16>& /*EE_T_K*/) const override {
+    return sample_->state.O_T_EE;
+  }
+  std::array<double, 42> bodyJacobian(franka::Frame /*frame*/,
+                                      const std::array<double, 7>& /*q*/,
+                                      const std::array<double, 16>& /*F_T_EE*/,
+                                      const std::array<double, 16>& /*EE_T_K*/) const override {
+    return sample_->zero_jacobian;
+  }
+  std::array<double, 42> zeroJacobian(franka::Frame /*frame*/,
+                                      const std::array<double, 7>& /*q*/,
+                                      const std::array<double, 16>& /*F_T_EE*/,
+                                      const std::array<double, 16>& /*EE_T_K*/) const override {
+    return sample_->zero_jacobian;
+  }
+  std::array<double, 49> mass(const std::array<double, 7>& /*q*/,
+                              const std::array<double, 9>& /*I_total*/,
+                              double /*m_total*/,
+                              const std::array<double, 3>& /*F_x_Ctotal*/) const override {
+    return sample_->mass;
+  }
+  std::array<double, 7> coriolis(const std::array<double, 7>& /*q*/,
+                                 const std::array<double, 7>& /*dq*/,
+                                 const std::array<double, 9>& /*I_total*/,
+                                 double /*m_total*/,
+                                 const std::array<double, 3>& /*F_x_Ctotal*/) const override {
+    return sample_->coriolis;
+  }
+  std::array<double, 7> gravity(const std::array<double, 7>& /*q*/,
+                                double /*m_total*/,
+                                const std::array<double, 3>& /*F_x_Ctotal*/,
+                                const std::array<double, 3>& /*gravity_earth*/) const override {
+    return sample_->gravity;
+  }
+
+ private:
+  const MockSample* sample_{nullptr};
+};
+
+class MockFrankaHW : public hardware_interface::RobotHW {
+ public:
+  explicit MockFrankaHW(const std::string& arm_id = "panda") {
+    for (size_t i = 0; i < 7; ++i) {
+      const std::string joint_name = arm_id + "_joint" + std::to_string(i + 1);
+      hardware_interface::JointStateHandle joint_state_handle(joint_name, &position_[i],
+                                                              &velocity_[i], &effort_[i]);
+      joint_state_interface_.registerHandle(joint_state_handle);
+      effort_joint_interface_.registerHandle(
+          hardware_interface::JointHandle(joint_state_handle, &effort_command_[i]));
+      position_joint_interface_.registerHandle(
+          hardware_interface::JointHandle(joint_state_handle, &position_command_[i]));
+      velocity_joint_interface_.registerHandle(
+          hardware_interface::JointHandle(joint_state_handle, &velocity_command_[i]));
+    }
+
+    franka_hw::FrankaStateHandle franka_state_handle(arm_id + "_robot", robot_state_);
+    franka_state_interface_.registerHandle(franka_state_handle);
+    franka_model_interface_.registerHandle(
+        franka_hw::FrankaModelHandle(arm_id + "_model", model_, robot_state_));
+    franka_pose_cartesian_interface_.registerHandle(franka_hw::FrankaCartesianPoseHandle(
+        franka_state_handle, pose_command_, elbow_command_));
+    franka_velocity_cartesian_interface_.registerHandle(franka_hw::FrankaCartesianVelocityHandle(
+        franka_state_handle, velocity_cartesian_command_, elbow_command_));
+
+    registerInterface(&joint_state_interface_);
+    registerInterface(&effort_joint_interface_);
+    registerInterface(&position_joint_interface_);
+    registerInterface(&velocity_joint_interface_);
+    registerInterface(&franka_state_interface_);
+    registerInterface(&franka_model_interface_);
+    registerInterface(&franka_pose_cartesian_interface_);
+    registerInterface(&franka_velocity_cartesian_interface_);
+  }
+
+  // Makes sample the current robot state. sample must outlive its use by the controllers.
+  void setSample(const MockSample& sample) {
+    robot_state_ = sample.state;
+    model_.setSample(&sample);
+    for (size_t i = 0; i < 7; ++i) {
+      position_[i] = sample.state.q[i];
+      velocity_[i] = sample.state.dq[i];
+      effort_[i] = sample.state.tau_J[i];
+    }
+  }
+
+  const std::array<double, 7>& effortCommand() const { return effort_command_; }
+
+ private:
+  franka::RobotState robot_state_;
+  MockFrankaModel model_;
+
+  std::array<double, 7> position_{};
+  std::array<double, 7> velocity_{};
+  std::array<double, 7> effort_{};
+  std::array<double, 7> effort_command_{};
+  std::array<double, 7> position_command_{};
+  std::array<double, 7> velocity_command_{};
+  std::array<double, 16> pose_command_{};
+  std::array<double, 6> velocity_cartesian_command_{};
+  std::array<double, 2> elbow_command_{};
+
+  hardware_interface::JointStateInterface joint_state_interface_;
+  hardware_interface::EffortJointInterface effort_joint_interface_;
+  hardware_interface::PositionJointInterface position_joint_interface_;
+  hardware_interface::VelocityJointInterface velocity_joint_interface_;
+  franka_hw::FrankaStateInterface franka_state_interface_;
+  franka_hw::FrankaModelInterface franka_model_interface_;
+  franka_hw::FrankaPoseCartesianInterface franka_pose_cartesian_interface_;
+  franka_hw::FrankaVelocityCartesianInterface franka_velocity_cartesian_interface_;
+};
+
+}  // namespace bench
+}  // namespace franka_interactive_controllers
@@ -0,0 +1,115 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Robot state samples for the benchmarks: a synthetic joint trajectory around the home pose, or
+// joint positions/velocities recorded to CSV (14 columns q1..q7, dq1..dq7 per line). The pose
+// and zero Jacobian of each sample come from PandaKinematics, the remaining model quantities
+// are smooth synthetic values; the benchmarks measure the controllers, not libfranka's model.
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <franka/robot_state.h>
+#include <Eigen/Dense>
+
+#include <panda_kinematics.h>
+
+namespace franka_interactive_controllers {
+namespace bench {
+
+struct MockSample {
+  franka::RobotState state;
+  std::array<double, 42> zero_jacobian;
+  std::array<double, 49> mass;
+  std::array<double, 7> coriolis;
+  std::array<double, 7> gravity;
+};
+
+inline MockSample makeSample(const std::array<double, 7>& q, const std::array<double, 7>& dq) {
+  MockSample sample;
+  franka::RobotState& state = sample.state;
+  state.q = q;
+  state.q_d = q;
+  state.dq = dq;
+  Eigen::Matrix4d F_T_EE = Eigen::Matrix4d::Identity();
+  F_T_EE.block<2, 2>(0, 0) << M_SQRT1_2, M_SQRT1_2, -M_SQRT1_2, M_SQRT1_2;
+  F_T_EE(2, 3) = 0.1034;
+  Eigen::Map<Eigen::Matrix4d>(state.F_T_EE.data()) = F_T_EE;
+  Eigen::Map<Eigen::Matrix4d>(state.EE_T_K.data()).setIdentity();
+  PandaKinematics<>::Result kinematics;
+  PandaKinematics<>::compute(Eigen::Map<const Eigen::Matrix<double, 7, 1>>(q.data()), F_T_EE,
+                             Eigen::Matrix4d::Identity(), &kinematics);
+  Eigen::Map<Eigen::Matrix4d>(state.O_T_EE.data()) = kinematics.O_T_EE;
+  Eigen::Map<Eigen::Matrix<double, 6, 7>>(sample.zero_jacobian.data()) = kinematics.zero_jacobian;
+  state.O_T_EE_d = state.O_T_EE;
+
+  Eigen::Map<Eigen::Matrix<double, 7, 7>> mass(sample.mass.data());
+  mass.setIdentity();
+  for (int i = 0; i < 7; ++i) {
+    mass(i, i) = 0.5 + 0.1 * std::cos(q[i]);
+    sample.gravity[i] = 5.0 * std::sin(q[i]);
+    sample.coriolis[i] = 0.1 * dq[i] * std::cos(q[i]);
+    state.tau_J[i] = sample.gravity[i] + 0.05 * std::sin(3.0 * q[i]);
+    state.tau_J_d[i] = sample.gravity[i];
+  }
+  return sample;
+}
+
+// Slow sinusoid on every joint around the home configuration, sampled at 1 kHz.
+inline std::vector<MockSample> syntheticSamples(size_t count) {
+  const std::array<double, 7> q_home = {{0, -M_PI_4, 0, -3 * M_PI_4, 0, M_PI_2, M_PI_4}};
+  std::vector<MockSample> samples;
+  samples.reserve(count);
+  for (size_t k = 0; k < count; ++k) {
+    const double t = 0.001 * static_cast<double>(k);
+    std::array<double, 7> q, dq;
+    for (int i = 0; i < 7; ++i) {
+      const double omega = 0.5 + 0.1 * i;
+      q[i] = q_home[i] + 0.2 * std::sin(omega * t);
+      dq[i] = 0.2 * omega * std::cos(omega * t);
+    }
+    samples.push_back(makeSample(q, dq));
+  }
+  return samples;
+}
+
+// Returns false if the file cannot be read or a line does not hold 14 numbers.
+inline bool recordedSamples(const std::string& path, std::vector<MockSample>* samples) {
+  std::ifstream file(path);
+  if (!file) {
+    return false;
+  }
+  samples->clear();
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    for (char& character : line) {
+      if (character == ',') {
+        character = ' ';
+      }
+    }
+    std::istringstream values(line);
+    std::array<double, 7> q, dq;
+    for (int i = 0; i < 7; ++i) {
+      values >> q[i];
+    }
+    for (int i = 0; i < 7; ++i) {
+      values >> dq[i];
+    }
+    if (values.fail()) {
+      return false;
+    }
+    samples->push_back(makeSample(q, dq));
+  }
+  return !samples->empty();
+}
+
+}  // namespace bench
+}  // namespace franka_interactive_controllers
@@ -0,0 +1,230 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Stress test of the target handoff from the ROS callbacks to the RT loop, see triple_buffer.h:
+//   rosrun franka_interactive_controllers franka_target_handoff_stress [seconds]
+// Writer threads do what the subscriber callbacks of the Cartesian impedance controllers do, as
+// fast as they can: push desired poses into a PoseInterpolator (desiredPoseCallback) and publish
+// gains and tool compensation into a TripleBuffer<CartesianImpedanceTarget>
+// (desired*StiffnessCallback, desiredExternalToolCompensationCallback). A simulated control loop
+// reads both every tick, without sleeping, and checks that it only ever sees whole updates:
+//   - the orientation is a unit quaternion and belongs to the position pushed with it,
+//   - stiffness and damping are symmetric and from the same update (D = 2 sqrt(K)),
+//   - the tool compensation wrench is the one vector that was published.
+// Exits with 1 on the first violation, after `seconds` (default 5) otherwise. Needs no master;
+// build with -fsanitize=thread to have the handoff checked for data races as well.
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include <cartesian_impedance_core.h>
+#include <pose_interpolator.h>
+
+namespace franka_interactive_controllers {
+namespace bench {
+namespace {
+
+constexpr double kTolerance = 1e-9;
+
+using Clock = std::chrono::steady_clock;
+
+std::atomic<bool> g_running{true};
+std::atomic<size_t> g_pose_updates{0};
+std::atomic<size_t> g_target_updates{0};
+
+// Random symmetric positive definite gain as a row-major parameter list, as on the topics
+template <int N>
+std::vector<double> randomGainValues(std::mt19937* random) {
+  std::uniform_real_distribution<double> uniform(-10.0, 10.0);
+  Eigen::Matrix<double, N, N> a;
+  for (int i = 0; i < N * N; ++i) {
+    a(i) = uniform(*random);
+  }
+  const Eigen::Matrix<double, N, N> matrix =
+      a * a.transpose() + N * Eigen::Matrix<double, N, N>::Identity();
+  return std::vector<double>(matrix.data(), matrix.data() + N * N);
+}
+
+// desiredCartesianStiffnessCallback / desiredNullspaceStiffnessCallback
+void gainWriter(TripleBuffer<CartesianImpedanceTarget>* target_buffer, unsigned seed) {
+  std::mt19937 random(seed);
+  while (g_running.load(std::memory_order_relaxed)) {
+    ImpedanceGain<6> cartesian_stiffness;
+    ImpedanceGain<7> nullspace_stiffness;
+    if (!ImpedanceGain<6>::fromVector(randomGainValues<6>(&random), &cartesian_stiffness) ||
+        !ImpedanceGain<7>::fromVector(randomGainValues<7>(&random), &nullspace_stiffness)) {
+      continue;
+    }
+    const ImpedanceGain<6> cartesian_damping = cartesian_stiffness.criticalDamping();
+    const ImpedanceGain<7> nullspace_damping = nullspace_stiffness.criticalDamping();
+    target_buffer->modify([&](CartesianImpedanceTarget& target) {
+      target.cartesian_stiffness = cartesian_stiffness;
+      target.cartesian_damping = cartesian_damping;
+    });
+    target_buffer->modify([&](CartesianImpedanceTarget& target) {
+      target.nullspace_stiffness = nullspace_stiffness;
+      target.nullspace_damping = nullspace_damping;
+    });
+    g_target_updates.fetch_add(2, std::memory_order_relaxed);
+  }
+}
+
+// desiredExternalToolCompensationCallback, with all six components equal
+void toolCompensationWriter(TripleBuffer<CartesianImpedanceTarget>* target_buffer) {
+  double value = 0.0;
+  while (g_running.load(std::memory_order_relaxed)) {
+    value += 1.0;
+    const Eigen::Matrix<double, 6, 1> tool_compensation_force =
+        Eigen::Matrix<double, 6, 1>::Constant(value);
+    target_buffer->modify([&](CartesianImpedanceTarget& target) {
+      target.tool_compensation_force = tool_compensation_force;
+    });
+    g_target_updates.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+// desiredPoseCallback; the position is the vector part of the orientation so that the reader can
+// tell whether both come from the same message
+void poseWriter(PoseInterpolator* interpolator, const Clock::time_point& start, unsigned seed) {
+  std::mt19937 random(seed);
+  std::normal_distribution<double> normal;
+  while (g_running.load(std::memory_order_relaxed)) {
+    Eigen::Quaterniond orientation(normal(random), normal(random), normal(random),
+                                   normal(random));
+    orientation.normalize();
+    const double stamp = std::chrono::duration<double>(Clock::now() - start).count();
+    interpolator->push(stamp, orientation.vec(), orientation);
+    g_pose_updates.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+template <int N>
+bool checkGain(const ImpedanceGain<N>& stiffness, const ImpedanceGain<N>& damping,
+               const char* name, std::string* error) {
+  const Eigen::Matrix<double, N, N>& k = stiffness.matrix();
+  const Eigen::Matrix<double, N, N>& d = damping.matrix();
+  std::ostringstream message;
+  if (!k.allFinite() || !d.allFinite()) {
+    message << name << " gains are not finite";
+  } else if ((k - k.transpose()).norm() > kTolerance * k.norm() ||
+             (d - d.transpose()).norm() > kTolerance * d.norm()) {
+    message << name << " stiffness or damping is not symmetric";
+  } else if ((0.25 * d * d - k).norm() > 1e-6 * k.norm()) {
+    message << name << " damping does not belong to the stiffness (torn update)";
+  } else {
+    return true;
+  }
+  message << std::endl << "stiffness:" << std::endl << k << std::endl
+          << "damping:" << std::endl << d;
+  *error = message.str();
+  return false;
+}
+
+bool checkTarget(const CartesianImpedanceTarget& target, std::string* error) {
+  if (!checkGain(target.cartesian_stiffness, target.cartesian_damping, "Cartesian", error) ||
+      !checkGain(target.nullspace_stiffness, target.nullspace_damping, "Nullspace", error)) {
+    return false;
+  }
+  const Eigen::Matrix<double, 6, 1>& force = target.tool_compensation_force;
+  if ((force.array() != force(0)).any()) {
+    std::ostringstream message;
+    message << "Tool compensation is a mix of updates: " << force.transpose();
+    *error = message.str();
+    return false;
+  }
+  return true;
+}
+
+bool checkPose(const Eigen::Vector3d& position, const Eigen::Quaterniond& orientation,
+               std::string* error) {
+  std::ostringstream message;
+  if (!position.allFinite() || !orientation.coeffs().allFinite()) {
+    message << "Pose is not finite";
+  } else if (std::abs(orientation.norm() - 1.0) > kTolerance) {
+    message << "Orientation is not a unit quaternion, norm " << orientation.norm();
+  } else if ((position - orientation.vec()).norm() > kTolerance &&
+             (position + orientation.vec()).norm() > kTolerance) {
+    // push() may flip the sign of the quaternion into the previous hemisphere
+    message << "Orientation does not belong to the position (torn update)";
+  } else {
+    return true;
+  }
+  message << std::endl << "position: " << position.transpose() << std::endl
+          << "orientation: " << orientation.coeffs().transpose();
+  *error = message.str();
+  return false;
+}
+
+}  // namespace
+}  // namespace bench
+}  // namespace franka_interactive_controllers
+
+int main(int argc, char** argv) {
+  using namespace franka_interactive_controllers;
+  using namespace franka_interactive_controllers::bench;
+
+  if (argc > 2) {
+    std::cerr << "Usage: " << argv[0] << " [seconds]" << std::endl;
+    return -1;
+  }
+  const double seconds = argc > 1 ? std::atof(argv[1]) : 5.0;
+
+  CartesianImpedanceTarget initial_target;
+  initial_target.cartesian_damping = initial_target.cartesian_stiffness.criticalDamping();
+  initial_target.nullspace_damping = initial_target.nullspace_stiffness.criticalDamping();
+  TripleBuffer<CartesianImpedanceTarget> target_buffer(initial_target);
+  // No delay and no extrapolation: every evaluate() returns the newest waypoint as pushed
+  PoseInterpolator interpolator;
+  interpolator.configure(0.0, 0.0);
+  interpolator.reset();
+
+  const Clock::time_point start = Clock::now();
+  std::vector<std::thread> writers;
+  writers.emplace_back(gainWriter, &target_buffer, 1u);
+  writers.emplace_back(gainWriter, &target_buffer, 2u);
+  writers.emplace_back(toolCompensationWriter, &target_buffer);
+  writers.emplace_back(poseWriter, &interpolator, std::cref(start), 3u);
+
+  // Simulated control loop
+  const Clock::time_point end =
+      start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+  size_t ticks = 0;
+  size_t snapshots = 0;
+  std::string error;
+  Eigen::Vector3d position;
+  Eigen::Quaterniond orientation;
+  while (error.empty() && Clock::now() < end) {
+    ++ticks;
+    snapshots += target_buffer.hasNewData() ? 1 : 0;
+    if (!checkTarget(target_buffer.readFromRT(), &error)) {
+      break;
+    }
+    if (interpolator.evaluate(1e9, &position, &orientation)) {
+      checkPose(position, orientation, &error);
+    }
+  }
+
+  g_running = false;
+  for (std::thread& writer : writers) {
+    writer.join();
+  }
+  std::cout << ticks << " ticks, " << snapshots << " new snapshots read, "
+            << g_target_updates.load() << " target and " << g_pose_updates.load()
+            << " pose updates written" << std::endl;
+  if (!error.empty()) {
+    std::cerr << "Invariant violated after " << ticks << " ticks: " << error << std::endl;
+    std::cout << "FAILED" << std::endl;
+    return 1;
+  }
+  std::cout << "OK" << std::endl;
+  return 0;
+}
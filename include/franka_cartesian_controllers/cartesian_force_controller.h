@@ -18,6 +18,11 @@
 
 #include <franka_interactive_controllers/desired_mass_paramConfig.h>
 
+#include <cycle_timing.h>
+#include <filter_bank.h>
+#include <model_cache.h>
+#include <robot_state_view.h>
+
 namespace franka_interactive_controllers {
 
 class CartesianForceController : public controller_interface::MultiInterfaceController<
@@ -25,6 +30,8 @@ class CartesianForceController : public controller_interface::MultiInterfaceCont
                                    hardware_interface::EffortJointInterface,
                                    franka_hw::FrankaStateInterface> {
  public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
   bool init(hardware_interface::RobotHW* robot_hw, ros::NodeHandle& node_handle) override;
   void starting(const ros::Time&) override;
   void update(const ros::Time&, const ros::Duration& period) override;
@@ -36,7 +43,11 @@ class CartesianForceController : public controller_interface::MultiInterfaceCont
       const Eigen::Matrix<double, 7, 1>& tau_J_d);  // NOLINT (readability-identifier-naming)
 
   std::unique_ptr<franka_hw::FrankaModelHandle> model_handle_;
+  // Jacobian and gravity of the current tick, evaluated on first use
+  ModelCache model_cache_;
   std::unique_ptr<franka_hw::FrankaStateHandle> state_handle_;
+  // Robot state of the current tick, read in place from the state handle
+  RobotStateView state_view_;
   std::vector<hardware_interface::JointHandle> joint_handles_;
 
   double desired_mass_{0.0};
@@ -45,7 +56,10 @@ class CartesianForceController : public controller_interface::MultiInterfaceCont
   double k_i_{0.0};
   double target_k_p_{0.0};
   double target_k_i_{0.0};
-  double filter_gain_{0.001};
+  // Smoothing of desired_mass_, k_p_ and k_i_ towards the dynamic reconfigure targets,
+  // parameters filters/force_parameters/... (first order, 1s by default)
+  FilterBank<3> filter_bank_;
+  int force_parameters_{0};
   Eigen::Matrix<double, 7, 1> tau_ext_initial_;
   Eigen::Matrix<double, 7, 1> tau_error_;
   static constexpr double kDeltaTauMax{1.0};
@@ -56,6 +70,9 @@ class CartesianForceController : public controller_interface::MultiInterfaceCont
   ros::NodeHandle dynamic_reconfigure_desired_mass_param_node_;
   void desiredMassParamCallback(franka_interactive_controllers::desired_mass_paramConfig& config,
                                 uint32_t level);
+
+  // update() timing, published on <controller_ns>/cycle_timing
+  CycleTimer cycle_timer_;
 };
 
 }  // namespace franka_interactive_controllers
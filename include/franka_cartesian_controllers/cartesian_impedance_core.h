@@ -0,0 +1,740 @@
+// This code was derived from franka_example controllers
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+// Current development and modification of this code by Nadia Figueroa (MIT) 2021.
+//
+// CartesianImpedanceCore<TargetPolicy> holds everything the Cartesian impedance controllers share:
+// parameter parsing, goto-home joint DS, pose error and the CartesianImpedanceTorque pipeline
+// (task + nullspace + Coriolis - tool compensation, torque rate saturated). The TargetPolicy
+// decides how the equilibrium pose is produced (desired pose stream, integrated twist, ...). It
+// is a plain member, so the torque law is compiled once per policy with every policy call inlined
+// and no virtual dispatch.
+//
+// Everything the ROS callbacks set (gains, tool compensation) travels to the RT loop as one
+// CartesianImpedanceTarget through a TripleBuffer, so update() reads a consistent snapshot
+// without ever blocking; the equilibrium pose is owned by the TargetPolicy. Gains and tool
+// compensation can be smoothed towards that snapshot by a FilterBank (parameters
+// filters/{cartesian_gains,nullspace_gains,tool_compensation}/..., see filter_bank.h); by default
+// they are applied as received.
+//
+// A TargetPolicy derives from CartesianTargetPolicyBase and provides:
+//   static const char* name();            // controller name used in log messages
+//   bool init(ros::NodeHandle& node_handle, const franka_hw::FrankaStateHandle& state_handle,
+//             TripleBuffer<CartesianImpedanceTarget>* target_buffer);
+//   void starting(const Eigen::Vector3d& position, const Eigen::Quaterniond& orientation);
+//   void update(const ros::Time& time, const ros::Duration& period,
+//               const CartesianImpedanceTarget& target, const Eigen::Affine3d& transform,
+//               Eigen::Vector3d* position_d, Eigen::Quaterniond* orientation_d);
+// (transform is the measured O_T_EE of the tick)
+// and may set kFeedForwardWrench and provide feedForwardWrench() to add a Cartesian wrench
+// feed-forward on top of the impedance law, or provide adjustTarget() to replace parts of the
+// target (e.g. gains) before smoothing.
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <controller_interface/multi_interface_controller.h>
+#include <dynamic_reconfigure/server.h>
+#include <franka/robot_state.h>
+#include <hardware_interface/joint_command_interface.h>
+#include <hardware_interface/robot_hw.h>
+#include <ros/node_handle.h>
+#include <ros/ros.h>
+#include <ros/time.h>
+#include <std_msgs/Float64MultiArray.h>
+#include <Eigen/Dense>
+
+#include <franka_hw/franka_model_interface.h>
+#include <franka_hw/franka_state_interface.h>
+#include <franka_interactive_controllers/compliance_paramConfig.h>
+
+#include <allocation_counter.h>
+#include <cycle_timing.h>
+#include <ee_state_publisher.h>
+#include <filter_bank.h>
+#include <flight_recorder.h>
+#include <impedance_gain.h>
+#include <model_cache.h>
+#include <pseudo_inversion.h>
+#include <realtime_log.h>
+#include <robot_state_view.h>
+#include <torque_pipeline.h>
+#include <triple_buffer.h>
+
+namespace franka_interactive_controllers {
+
+// Values written by the ROS callbacks and consumed by update().
+struct CartesianImpedanceTarget {
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  ImpedanceGain<6> cartesian_stiffness;
+  ImpedanceGain<6> cartesian_damping;
+  ImpedanceGain<7> nullspace_stiffness;
+  ImpedanceGain<7> nullspace_damping;
+  Eigen::Matrix<double, 6, 1> tool_compensation_force{Eigen::Matrix<double, 6, 1>::Zero()};
+  bool activate_tool_compensation{true};
+};
+
+// Defaults for the optional parts of a target policy.
+struct CartesianTargetPolicyBase {
+  // Set to true in a policy to add J^T * feedForwardWrench() to the Cartesian task torque.
+  static constexpr bool kFeedForwardWrench = false;
+  Eigen::Matrix<double, 6, 1> feedForwardWrench() const {
+    return Eigen::Matrix<double, 6, 1>::Zero();
+  }
+  // RT: target the torque law uses this tick, given the one from the ROS callbacks.
+  const CartesianImpedanceTarget& adjustTarget(const CartesianImpedanceTarget& target) {
+    return target;
+  }
+};
+
+// Torque law shared by the Cartesian impedance controllers
+using CartesianImpedanceTorque =
+    TorquePipeline<TaskTorqueStage, NullspaceStage, CoriolisStage, ToolCompensationStage,
+                   TorqueRateSaturationStage>;
+
+template <class TargetPolicy>
+class CartesianImpedanceCore : public controller_interface::MultiInterfaceController<
+                                   franka_hw::FrankaModelInterface,
+                                   hardware_interface::EffortJointInterface,
+                                   franka_hw::FrankaStateInterface> {
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  bool init(hardware_interface::RobotHW* robot_hw, ros::NodeHandle& node_handle) override;
+  void starting(const ros::Time&) override;
+  void stopping(const ros::Time&) override;
+  void update(const ros::Time&, const ros::Duration& period) override;
+
+ protected:
+  TargetPolicy target_policy_;
+
+ private:
+  std::unique_ptr<franka_hw::FrankaStateHandle> state_handle_;
+  std::unique_ptr<franka_hw::FrankaModelHandle> model_handle_;
+  std::vector<hardware_interface::JointHandle> joint_handles_;
+
+  // Robot state of the current tick, read in place from the state handle
+  RobotStateView state_view_;
+
+  // Jacobian, nullspace projector and Coriolis of the current tick, evaluated on first use
+  ModelCache model_cache_;
+
+  // Torque terms computed in update(), kept here so the loop never allocates
+  Eigen::Matrix<double, 7, 1> tau_task_;
+  Eigen::Matrix<double, 7, 1> tau_d_;
+  RealtimeAllocationCheck allocation_check_;
+
+  // update() timing, published on <controller_ns>/cycle_timing
+  CycleTimer cycle_timer_;
+
+  // Optional <controller_ns>/ee_{pose,twist,wrench} from the control tick
+  EndEffectorStatePublisher ee_state_publisher_;
+
+  // Optional binary log of every tick, started and stopped through <controller_ns>/flight_recorder
+  FlightRecorder flight_recorder_;
+  void recordFlightSample(const CartesianImpedanceTarget& target, FlightSample* sample);
+
+  // double nullspace_stiffness_{20.0};
+
+  const double delta_tau_max_{1.0};
+  Eigen::Matrix<double, 7, 1> q_d_nullspace_;
+  // whether to load from yaml or use initial robot config
+  bool q_d_nullspace_initialized_ = false;
+  Eigen::Vector3d position_d_;
+  Eigen::Quaterniond orientation_d_;
+
+  // Variables for initialization and tool compensation
+  bool _goto_home;
+  double dt_ = 0.001;
+  double jointDS_epsilon_;
+  double dq_filter_params_;
+  Eigen::Matrix<double, 7, 1> q_home_;
+  Eigen::Matrix<double, 7, 7> A_jointDS_home_;
+  ImpedanceGain<7> k_joint_gains_;
+  ImpedanceGain<7> d_joint_gains_;
+  ImpedanceGain<7> d_ff_joint_gains_;
+
+  // Targets handed over from the ROS callbacks to update()
+  TripleBuffer<CartesianImpedanceTarget> target_buffer_;
+
+  // Smoothing of the gains and tool compensation of the target: 36 + 36 Cartesian stiffness and
+  // damping entries, 49 + 49 nullspace ones and the 6 tool wrench components
+  FilterBank<176> filter_bank_;
+  int cartesian_gains_{0};
+  int nullspace_gains_{0};
+  int tool_compensation_{0};
+  CartesianImpedanceTarget smoothed_target_;
+  void loadFilterTargets(const CartesianImpedanceTarget& target);
+  void readFilterValues(bool cartesian_gains, bool nullspace_gains);
+  const CartesianImpedanceTarget& smoothTarget(const CartesianImpedanceTarget& target,
+                                               const ros::Duration& period);
+
+  // Dynamic reconfigure
+  std::unique_ptr<dynamic_reconfigure::Server<franka_interactive_controllers::compliance_paramConfig>>
+      dynamic_server_compliance_param_;
+  ros::NodeHandle dynamic_reconfigure_compliance_param_node_;
+  void complianceParamCallback(franka_interactive_controllers::compliance_paramConfig& config,
+                               uint32_t level);
+
+  // Dynamic reconfigure from ROS message
+  ros::Subscriber sub_desired_cartesian_stiffness_;
+  void desiredCartesianStiffnessCallback(const std_msgs::Float64MultiArray& msg);
+
+  ros::Subscriber sub_desired_nullspace_stiffness_;
+  void desiredNullspaceStiffnessCallback(const std_msgs::Float64MultiArray& msg);
+
+  ros::Subscriber sub_desired_external_tool_compensation_;
+  void desiredExternalToolCompensationCallback(const std_msgs::Float64MultiArray& msg);
+};
+
+template <class TargetPolicy>
+bool CartesianImpedanceCore<TargetPolicy>::init(hardware_interface::RobotHW* robot_hw,
+                                                ros::NodeHandle& node_handle) {
+  const char* name = TargetPolicy::name();
+
+  // Create the RT log ring and its drain thread before the control loop runs
+  RealtimeLogger::instance();
+
+  // Getting ROSParams
+  std::string arm_id;
+  if (!node_handle.getParam("arm_id", arm_id)) {
+    ROS_ERROR_STREAM(name << ": Could not read parameter arm_id");
+    return false;
+  }
+  std::vector<std::string> joint_names;
+  if (!node_handle.getParam("joint_names", joint_names) || joint_names.size() != 7) {
+    ROS_ERROR_STREAM(name << ": Invalid or no joint_names parameters provided, "
+                     "aborting controller init!");
+    return false;
+  }
+
+  CartesianImpedanceTarget target;
+
+  // Initialize variables for tool compensation from yaml config file
+  std::vector<double> external_tool_compensation;
+  // tool_compensation_force << 0.46, -0.17, -1.64, 0, 0, 0;  //read from yaml
+  if (!node_handle.getParam("external_tool_compensation", external_tool_compensation) ||
+      external_tool_compensation.size() != 6) {
+    ROS_ERROR_STREAM(name << ": Invalid or no external_tool_compensation parameters provided, "
+                     "aborting controller init!");
+    return false;
+  }
+  for (size_t i = 0; i < 6; ++i)
+    target.tool_compensation_force[i] = external_tool_compensation.at(i);
+  ROS_INFO_STREAM("External tool compensation force: " << std::endl
+                  << target.tool_compensation_force);
+
+  // Initialize variables for nullspace control from yaml config file
+  q_d_nullspace_.setZero();
+  std::vector<double> q_nullspace;
+  if (node_handle.getParam("q_nullspace", q_nullspace)) {
+    q_d_nullspace_initialized_ = true;
+    if (q_nullspace.size() != 7) {
+      ROS_ERROR_STREAM(name << ": Invalid or no q_nullspace parameters provided, "
+                       "aborting controller init!");
+      return false;
+    }
+    for (size_t i = 0; i < 7; ++i)
+      q_d_nullspace_[i] = q_nullspace.at(i);
+    ROS_INFO_STREAM("Desired nullspace position (from YAML): " << std::endl << q_d_nullspace_);
+  }
+
+  // Stiffness targets: 7 (6) values for a diagonal gain or 49 (36) row-major values for a full
+  // SPD matrix. Damping ratio = 1
+  std::vector<double> nullspace_stiffness_target_yaml;
+  if (!node_handle.getParam("nullspace_stiffness_target", nullspace_stiffness_target_yaml) ||
+      !ImpedanceGain<7>::fromVector(nullspace_stiffness_target_yaml, &target.nullspace_stiffness)) {
+    ROS_ERROR_STREAM(name << ": Invalid or no nullspace_stiffness_target_yaml parameters "
+                     "provided, aborting controller init!");
+    return false;
+  }
+  target.nullspace_damping = target.nullspace_stiffness.criticalDamping();
+  ROS_INFO_STREAM("nullspace_stiffness_target: " << std::endl <<  target.nullspace_stiffness);
+  ROS_INFO_STREAM("nullspace_damping_target: " << std::endl <<  target.nullspace_damping);
+
+  // Initialize stiffness
+  std::vector<double> cartesian_stiffness_target_yaml;
+  if (!node_handle.getParam("cartesian_stiffness_target", cartesian_stiffness_target_yaml) ||
+      !ImpedanceGain<6>::fromVector(cartesian_stiffness_target_yaml, &target.cartesian_stiffness)) {
+    ROS_ERROR_STREAM(name << ": Invalid or no cartesian_stiffness_target_yaml parameters "
+                     "provided, aborting controller init!");
+    return false;
+  }
+  // Damping ratio = 1
+  target.cartesian_damping = target.cartesian_stiffness.criticalDamping();
+  ROS_INFO_STREAM("cartesian_stiffness_target: " << std::endl <<  target.cartesian_stiffness);
+  ROS_INFO_STREAM("cartesian_damping_target: " << std::endl <<  target.cartesian_damping);
+  target_buffer_.reset(target);
+
+  // Damped pseudo inverse used for the nullspace projector [svd|ldlt|cod]
+  std::string pseudo_inverse_method("svd");
+  if (!node_handle.getParam("pseudo_inverse_method", pseudo_inverse_method)) {
+    ROS_INFO_STREAM(name << ": No parameter pseudo_inverse_method, defaulting to: "
+                    << pseudo_inverse_method);
+  }
+  PseudoInverseMethod method;
+  if (!pseudoInverseMethodFromString(pseudo_inverse_method, &method)) {
+    ROS_ERROR_STREAM(name << ": Invalid pseudo_inverse_method " << pseudo_inverse_method
+                     << " (expected svd, ldlt or cod), aborting controller init!");
+    return false;
+  }
+  double pseudo_inverse_damping(0.2);
+  if (!node_handle.getParam("pseudo_inverse_damping", pseudo_inverse_damping)) {
+    ROS_INFO_STREAM(name << ": No parameter pseudo_inverse_damping, defaulting to: "
+                    << pseudo_inverse_damping);
+  }
+  model_cache_.setPseudoInverse(method, pseudo_inverse_damping);
+
+  // Getting libranka control interfaces
+  auto* model_interface = robot_hw->get<franka_hw::FrankaModelInterface>();
+  if (model_interface == nullptr) {
+    ROS_ERROR_STREAM(name << ": Error getting model interface from hardware");
+    return false;
+  }
+  try {
+    model_handle_ = std::make_unique<franka_hw::FrankaModelHandle>(
+        model_interface->getHandle(arm_id + "_model"));
+  } catch (hardware_interface::HardwareInterfaceException& ex) {
+    ROS_ERROR_STREAM(name << ": Exception getting model handle from interface: " << ex.what());
+    return false;
+  }
+  model_cache_.init(model_handle_.get());
+
+  auto* state_interface = robot_hw->get<franka_hw::FrankaStateInterface>();
+  if (state_interface == nullptr) {
+    ROS_ERROR_STREAM(name << ": Error getting state interface from hardware");
+    return false;
+  }
+  try {
+    state_handle_ = std::make_unique<franka_hw::FrankaStateHandle>(
+        state_interface->getHandle(arm_id + "_robot"));
+  } catch (hardware_interface::HardwareInterfaceException& ex) {
+    ROS_ERROR_STREAM(name << ": Exception getting state handle from interface: " << ex.what());
+    return false;
+  }
+  state_view_.init(*state_handle_, RobotStateView::kQ | RobotStateView::kDq |
+                                       RobotStateView::kTauJD | RobotStateView::kOTEE |
+                                       EndEffectorStatePublisher::kStateFields |
+                                       FlightRecorder::kStateFields);
+
+  auto* effort_joint_interface = robot_hw->get<hardware_interface::EffortJointInterface>();
+  if (effort_joint_interface == nullptr) {
+    ROS_ERROR_STREAM(name << ": Error getting effort joint interface from hardware");
+    return false;
+  }
+  for (size_t i = 0; i < 7; ++i) {
+    try {
+      joint_handles_.push_back(effort_joint_interface->getHandle(joint_names[i]));
+    } catch (const hardware_interface::HardwareInterfaceException& ex) {
+      ROS_ERROR_STREAM(name << ": Exception getting joint handles: " << ex.what());
+      return false;
+    }
+  }
+
+  sub_desired_cartesian_stiffness_ = node_handle.subscribe(
+      "/cartesian_impedance_controller/desired_cartesian_stiffness",
+      20, &CartesianImpedanceCore::desiredCartesianStiffnessCallback, this,
+      ros::TransportHints().reliable().tcpNoDelay());
+
+  sub_desired_nullspace_stiffness_ = node_handle.subscribe(
+      "/cartesian_impedance_controller/desired_nullspace_stiffness",
+      20, &CartesianImpedanceCore::desiredNullspaceStiffnessCallback, this,
+      ros::TransportHints().reliable().tcpNoDelay());
+
+  sub_desired_external_tool_compensation_ = node_handle.subscribe(
+      "/cartesian_impedance_controller/desired_external_tool_compensation",
+      20, &CartesianImpedanceCore::desiredExternalToolCompensationCallback, this,
+      ros::TransportHints().reliable().tcpNoDelay());
+
+  // Target policy (desired pose/twist subscribers)
+  if (!target_policy_.init(node_handle, *state_handle_, &target_buffer_)) {
+    return false;
+  }
+
+  // Getting Dynamic Reconfigure objects
+  dynamic_reconfigure_compliance_param_node_ =
+      ros::NodeHandle(node_handle.getNamespace() + "dynamic_reconfigure_compliance_param_node");
+
+  dynamic_server_compliance_param_ = std::make_unique<
+      dynamic_reconfigure::Server<franka_interactive_controllers::compliance_paramConfig>>(
+
+      dynamic_reconfigure_compliance_param_node_);
+  dynamic_server_compliance_param_->setCallback(
+      boost::bind(&CartesianImpedanceCore::complianceParamCallback, this, _1, _2));
+
+  // Initializing variables
+  position_d_.setZero();
+  orientation_d_.coeffs() << 0.0, 0.0, 0.0, 1.0;
+
+  // Parameters for goto_home at initialization!!
+  _goto_home = false;
+
+  // Parameters for jointDS controller (THIS SHOULD BE IN ANOTHER SCRIPT!! DS MOTION GENERATOR?)
+  q_home_ << 0, -M_PI_4, 0, -3 * M_PI_4, 0, M_PI_2, M_PI_4;
+  jointDS_epsilon_  = 0.05;
+  dq_filter_params_ = 0.555;
+
+  A_jointDS_home_ = Eigen::MatrixXd::Identity(7, 7);
+  A_jointDS_home_(0,0) = 10; A_jointDS_home_(1,1) = 10; A_jointDS_home_(2,2) = 10;
+  A_jointDS_home_(3,3) = 10; A_jointDS_home_(4,4) = 15; A_jointDS_home_(5,5) = 15;
+  A_jointDS_home_(6,6) = 15;
+  ROS_INFO_STREAM("A (jointDS): " << std::endl <<  A_jointDS_home_);
+
+  // Parameters for joint PD controller
+  // Ideal gains for Joint Impedance Controller
+  // k_gains: 600.0, 600.0, 600.0, 600.0, 250.0, 150.0, 50.0
+  // d_gains: 50.0, 50.0, 50.0, 20.0, 20.0, 20.0, 10.0
+
+  // Gains for P error stiffness term
+  Eigen::Matrix<double, 7, 1> joint_gains;
+  joint_gains << 500, 500, 500, 500, 500, 500, 200;
+  k_joint_gains_ = ImpedanceGain<7>::fromDiagonal(joint_gains);
+  ROS_INFO_STREAM("K (joint stiffness): " << std::endl <<  k_joint_gains_);
+
+  // Gains for D error damping term
+  joint_gains << 5, 5, 5, 2, 2, 2, 1;
+  d_joint_gains_ = ImpedanceGain<7>::fromDiagonal(joint_gains);
+  ROS_INFO_STREAM("D (joint damping): " << std::endl << d_joint_gains_);
+
+  // Gains for feed-forward damping term
+  d_ff_joint_gains_ = ImpedanceGain<7>::fromDiagonal(Eigen::Matrix<double, 7, 1>::Ones());
+
+  // Optional smoothing of gains and tool compensation
+  FilterConfig cartesian_gains_filter;
+  FilterConfig nullspace_gains_filter;
+  FilterConfig tool_compensation_filter;
+  if (!filterConfigFromParam(node_handle, name, "cartesian_gains", &cartesian_gains_filter) ||
+      !filterConfigFromParam(node_handle, name, "nullspace_gains", &nullspace_gains_filter) ||
+      !filterConfigFromParam(node_handle, name, "tool_compensation", &tool_compensation_filter)) {
+    return false;
+  }
+  filter_bank_.clear();
+  cartesian_gains_ = filter_bank_.addGroup(2 * 36, cartesian_gains_filter);
+  nullspace_gains_ = filter_bank_.addGroup(2 * 49, nullspace_gains_filter);
+  tool_compensation_ = filter_bank_.addGroup(6, tool_compensation_filter);
+
+  if (!cycle_timer_.init(node_handle, name, &model_cache_)) {
+    return false;
+  }
+  if (!ee_state_publisher_.init(node_handle, name)) {
+    return false;
+  }
+  if (!flight_recorder_.init(node_handle, name)) {
+    return false;
+  }
+
+  return true;
+}
+
+template <class TargetPolicy>
+void CartesianImpedanceCore<TargetPolicy>::starting(const ros::Time& /*time*/) {
+  cycle_timer_.starting();
+  ee_state_publisher_.starting();
+  flight_recorder_.starting();
+
+  // Get robot current/initial joint state
+  state_view_.beginTick();
+  const RobotStateView::Vector7dMap q_initial = state_view_.q();
+
+  // convert to eigen
+  Eigen::Affine3d initial_transform(state_view_.oTEE());
+
+  // set desired point to current state
+  position_d_    = initial_transform.translation();
+  orientation_d_ = Eigen::Quaterniond(initial_transform.linear());
+  target_policy_.starting(position_d_, orientation_d_);
+
+  // Smoothed gains start at the current targets
+  const CartesianImpedanceTarget& target = target_buffer_.readFromRT();
+  loadFilterTargets(target);
+  filter_bank_.settle();
+  smoothed_target_.activate_tool_compensation = target.activate_tool_compensation;
+  readFilterValues(true, true);
+
+  if (!q_d_nullspace_initialized_) {
+    q_d_nullspace_ = q_initial;
+    q_d_nullspace_initialized_ = true;
+    ROS_INFO_STREAM("Desired nullspace position (from q_initial): " << std::endl << q_d_nullspace_);
+  }
+
+  tau_task_.setZero();
+  tau_d_.setZero();
+
+  // Count heap allocations made on the control thread from here until stopping()
+  allocation_check_.start();
+}
+
+template <class TargetPolicy>
+void CartesianImpedanceCore<TargetPolicy>::stopping(const ros::Time& /*time*/) {
+  std::size_t allocations = allocation_check_.stop();
+  if (allocations > 0) {
+    RT_LOG_ERROR("%s: %zu heap allocations on the control thread while running",
+                 TargetPolicy::name(), allocations);
+  }
+}
+
+template <class TargetPolicy>
+void CartesianImpedanceCore<TargetPolicy>::update(const ros::Time& time,
+                                                  const ros::Duration& period) {
+  CycleTimer::Scope cycle_timing(&cycle_timer_, period);
+
+  // get state variables in place; model quantities are evaluated when first used below
+  state_view_.beginTick();
+  model_cache_.beginTick();
+  const ModelCache::Jacobian& jacobian = model_cache_.jacobian();
+
+  // Eigen views of the state
+  const RobotStateView::Vector7dMap q = state_view_.q();
+  const RobotStateView::Vector7dMap dq = state_view_.dq();
+  Eigen::Affine3d transform(state_view_.oTEE());
+  Eigen::Vector3d position(transform.translation());
+  Eigen::Quaterniond orientation(transform.linear());
+
+  // consistent snapshot of everything set by the ROS callbacks, gains smoothed if configured
+  const CartesianImpedanceTarget& target =
+      smoothTarget(target_policy_.adjustTarget(target_buffer_.readFromRT()), period);
+
+  //////////////////////////////////////////////////////////////////////////////////////////////////
+  // This is the if statement that should be made into two different controllers
+  if (_goto_home){
+    RT_LOG_INFO_THROTTLE(1.0, "Moving robot to home joint configuration.");
+
+    // Variables to control robot in joint space
+    Eigen::Matrix<double, 7, 1> q_error, dq_desired, dq_filtered, q_desired;
+
+    // Compute linear DS in joint-space
+    q_error = q - q_home_;
+    dq_desired = -A_jointDS_home_ * q_error;
+
+    // Filter desired velocity to avoid high accelerations!
+    dq_filtered = (1-dq_filter_params_)*dq + dq_filter_params_*dq_desired;
+
+    RT_LOG_INFO_THROTTLE(0.1, "Joint position error: %f", q_error.norm());
+
+    // Integrate to get desired position
+    q_desired = q + dq_desired*dt_;
+
+    // Desired torque: Joint PD control with damping ratio = 1
+    tau_task_ << -(k_joint_gains_*(q - q_desired)) - d_ff_joint_gains_*dq;
+
+    // Desired torque: Joint PD control
+    // tau_task_ << -0.50*k_joint_gains_ * q_delta - 2.0*d_joint_gains_*(dq - dq_desired) - d_ff_joint_gains_*dq;
+
+    if (q_error.norm() < jointDS_epsilon_){
+      RT_LOG_INFO("Finished moving to initial joint configuration. Continuing with desired Cartesian task!");
+      _goto_home = false;
+    }
+
+    // set desired point for Cartesian impedance controller to current state
+    position_d_  = position;
+
+  }
+  else{
+
+    // IF NOT GO_HOME -> DO CARTESIAN IMPEDANCE CONTROL
+    // compute error to desired pose
+    // position error
+    Eigen::Matrix<double, 6, 1> error;
+    error.head(3) << position - position_d_;
+
+    // orientation error
+    if (orientation_d_.coeffs().dot(orientation.coeffs()) < 0.0) {
+      orientation.coeffs() << -orientation.coeffs();
+    }
+    // "difference" quaternion
+    Eigen::Quaterniond error_quaternion(orientation.inverse() * orientation_d_);
+    error.tail(3) << error_quaternion.x(), error_quaternion.y(), error_quaternion.z();
+    // Transform to base frame
+    error.tail(3) << -transform.linear() * error.tail(3);
+
+    // Cartesian PD control with damping ratio = 1
+    tau_task_ << jacobian.transpose() *(-(target.cartesian_stiffness * error) - target.cartesian_damping * (jacobian * dq));
+
+    // Optional Cartesian wrench feed-forward from the target policy (compiled out when unused)
+    if (TargetPolicy::kFeedForwardWrench) {
+      tau_task_.noalias() += jacobian.transpose() * target_policy_.feedForwardWrench();
+    }
+  }
+  //////////////////////////////////////////////////////////////////////////////////////////////////
+
+  // Desired torque: task + nullspace PD (damping ratio = 1) + coriolis - tool compensation, with
+  // the torque rate saturated to avoid discontinuities
+  const TorqueContext<CartesianImpedanceTarget> torque_context{
+      state_view_, model_cache_, target, tau_task_, &q_d_nullspace_, delta_tau_max_};
+  CartesianImpedanceTorque::compute(torque_context, &tau_d_);
+
+  for (size_t i = 0; i < 7; ++i) {
+    joint_handles_[i].setCommand(tau_d_(i));
+  }
+
+  if (FlightSample* sample = flight_recorder_.claim(time, period, state_view_)) {
+    recordFlightSample(target, sample);
+    flight_recorder_.commit();
+  }
+
+  // Equilibrium pose for the next tick from the target policy
+  target_policy_.update(time, period, target, transform, &position_d_, &orientation_d_);
+
+  ee_state_publisher_.publish(time, state_view_, &model_cache_);
+}
+
+template <class TargetPolicy>
+void CartesianImpedanceCore<TargetPolicy>::recordFlightSample(
+    const CartesianImpedanceTarget& target, FlightSample* sample) {
+  using Vector7d = Eigen::Matrix<double, 7, 1>;
+  using Matrix6d = Eigen::Matrix<double, 6, 6>;
+  using Matrix7d = Eigen::Matrix<double, 7, 7>;
+  Eigen::Map<Vector7d>(sample->tau_task.data()) = tau_task_;
+  Eigen::Map<Vector7d>(sample->tau_coriolis.data()) = model_cache_.coriolis();
+  Eigen::Map<Vector7d>(sample->tau_d.data()) = tau_d_;
+  // Equilibrium pose this tick's torque was computed for
+  Eigen::Map<Eigen::Vector3d>(sample->position_d.data()) = position_d_;
+  Eigen::Map<Eigen::Vector4d>(sample->orientation_d.data()) = orientation_d_.coeffs();
+  Eigen::Map<Matrix6d>(sample->cartesian_stiffness.data()) = target.cartesian_stiffness.matrix();
+  Eigen::Map<Matrix6d>(sample->cartesian_damping.data()) = target.cartesian_damping.matrix();
+  Eigen::Map<Matrix7d>(sample->nullspace_stiffness.data()) = target.nullspace_stiffness.matrix();
+  Eigen::Map<Matrix7d>(sample->nullspace_damping.data()) = target.nullspace_damping.matrix();
+}
+
+template <class TargetPolicy>
+void CartesianImpedanceCore<TargetPolicy>::loadFilterTargets(
+    const CartesianImpedanceTarget& target) {
+  using Gain6 = Eigen::Array<double, 36, 1>;
+  using Gain7 = Eigen::Array<double, 49, 1>;
+  filter_bank_.target(cartesian_gains_, 36) =
+      Eigen::Map<const Gain6>(target.cartesian_stiffness.matrix().data());
+  filter_bank_.target(cartesian_gains_ + 36, 36) =
+      Eigen::Map<const Gain6>(target.cartesian_damping.matrix().data());
+  filter_bank_.target(nullspace_gains_, 49) =
+      Eigen::Map<const Gain7>(target.nullspace_stiffness.matrix().data());
+  filter_bank_.target(nullspace_gains_ + 49, 49) =
+      Eigen::Map<const Gain7>(target.nullspace_damping.matrix().data());
+  filter_bank_.target(tool_compensation_, 6) = target.tool_compensation_force.array();
+}
+
+template <class TargetPolicy>
+const CartesianImpedanceTarget& CartesianImpedanceCore<TargetPolicy>::smoothTarget(
+    const CartesianImpedanceTarget& target, const ros::Duration& period) {
+  if (!filter_bank_.filtering()) {
+    return target;
+  }
+  loadFilterTargets(target);
+  // Gains resting on their targets are left as they are, structure detection included
+  const bool cartesian_gains = !filter_bank_.atRest(cartesian_gains_, 2 * 36);
+  const bool nullspace_gains = !filter_bank_.atRest(nullspace_gains_, 2 * 49);
+  filter_bank_.update(period.toSec());
+
+  smoothed_target_.activate_tool_compensation = target.activate_tool_compensation;
+  readFilterValues(cartesian_gains, nullspace_gains);
+  return smoothed_target_;
+}
+
+template <class TargetPolicy>
+void CartesianImpedanceCore<TargetPolicy>::readFilterValues(bool cartesian_gains,
+                                                            bool nullspace_gains) {
+  using Matrix6d = Eigen::Matrix<double, 6, 6>;
+  using Matrix7d = Eigen::Matrix<double, 7, 7>;
+  if (cartesian_gains) {
+    smoothed_target_.cartesian_stiffness = ImpedanceGain<6>::fromMatrix(
+        Eigen::Map<const Matrix6d>(filter_bank_.value(cartesian_gains_, 36).data()));
+    smoothed_target_.cartesian_damping = ImpedanceGain<6>::fromMatrix(
+        Eigen::Map<const Matrix6d>(filter_bank_.value(cartesian_gains_ + 36, 36).data()));
+  }
+  if (nullspace_gains) {
+    smoothed_target_.nullspace_stiffness = ImpedanceGain<7>::fromMatrix(
+        Eigen::Map<const Matrix7d>(filter_bank_.value(nullspace_gains_, 49).data()));
+    smoothed_target_.nullspace_damping = ImpedanceGain<7>::fromMatrix(
+        Eigen::Map<const Matrix7d>(filter_bank_.value(nullspace_gains_ + 49, 49).data()));
+  }
+  smoothed_target_.tool_compensation_force =
+      filter_bank_.value(tool_compensation_, 6).matrix();
+}
+
+template <class TargetPolicy>
+void CartesianImpedanceCore<TargetPolicy>::complianceParamCallback(
+    franka_interactive_controllers::compliance_paramConfig& config,
+    uint32_t /*level*/) {
+  // cartesian_stiffness_target_.setIdentity();
+  // cartesian_stiffness_target_.topLeftCorner(3, 3)
+  //     << config.translational_stiffness * Eigen::Matrix3d::Identity();
+  // cartesian_stiffness_target_.bottomRightCorner(3, 3)
+  //     << config.rotational_stiffness * Eigen::Matrix3d::Identity();
+  // cartesian_damping_target_.setIdentity();
+
+  // Damping ratio = 1
+  // cartesian_damping_target_.topLeftCorner(3, 3)
+  //     << 2.0 * sqrt(config.translational_stiffness) * Eigen::Matrix3d::Identity();
+  // cartesian_damping_target_.bottomRightCorner(3, 3)
+  //     << 2.0 * sqrt(config.rotational_stiffness) * Eigen::Matrix3d::Identity();
+
+  // nullspace_stiffness_target_ = config.nullspace_stiffness;
+
+  target_buffer_.modify([&config](CartesianImpedanceTarget& target) {
+    target.activate_tool_compensation = config.activate_tool_compensation;
+  });
+}
+
+template <class TargetPolicy>
+void CartesianImpedanceCore<TargetPolicy>::desiredCartesianStiffnessCallback(
+    const std_msgs::Float64MultiArray& msg) {
+  // https://gist.github.com/alexsleat/1372845
+  ImpedanceGain<6> cartesian_stiffness_target;
+  if (!ImpedanceGain<6>::fromVector(msg.data, &cartesian_stiffness_target)) {
+    ROS_ERROR_STREAM(TargetPolicy::name()
+                     << ": Invalid ROS message for desiredCartesianStiffnessCallback provided");
+    throw std::invalid_argument("Aborting controller!");
+  }
+  // Damping ratio = 1
+  ImpedanceGain<6> cartesian_damping_target = cartesian_stiffness_target.criticalDamping();
+  target_buffer_.modify([&](CartesianImpedanceTarget& target) {
+    target.cartesian_stiffness = cartesian_stiffness_target;
+    target.cartesian_damping = cartesian_damping_target;
+  });
+  ROS_WARN_STREAM("[desiredCartesianStiffnessCallback]: cartesian_stiffness_target: " << std::endl <<  cartesian_stiffness_target);
+  ROS_WARN_STREAM("[desiredCartesianStiffnessCallback]: cartesian_damping_target: " << std::endl <<  cartesian_damping_target);
+}
+
+template <class TargetPolicy>
+void CartesianImpedanceCore<TargetPolicy>::desiredNullspaceStiffnessCallback(
+    const std_msgs::Float64MultiArray& msg) {
+  ImpedanceGain<7> nullspace_stiffness_target;
+  if (!ImpedanceGain<7>::fromVector(msg.data, &nullspace_stiffness_target)) {
+    ROS_ERROR_STREAM(TargetPolicy::name()
+                     << ": Invalid ROS message for desiredNullspaceStiffnessCallback provided");
+    throw std::invalid_argument("Aborting controller!");
+  }
+  // Damping ratio = 1
+  ImpedanceGain<7> nullspace_damping_target = nullspace_stiffness_target.criticalDamping();
+  target_buffer_.modify([&](CartesianImpedanceTarget& target) {
+    target.nullspace_stiffness = nullspace_stiffness_target;
+    target.nullspace_damping = nullspace_damping_target;
+  });
+  ROS_WARN_STREAM("[desiredNullspaceStiffnessCallback]: nullspace_stiffness_target: " << std::endl <<  nullspace_stiffness_target);
+  ROS_WARN_STREAM("[desiredNullspaceStiffnessCallback]: nullspace_damping_target: " << std::endl <<  nullspace_damping_target);
+}
+
+template <class TargetPolicy>
+void CartesianImpedanceCore<TargetPolicy>::desiredExternalToolCompensationCallback(
+    const std_msgs::Float64MultiArray& msg) {
+  if (msg.data.size() != 6) {
+    ROS_ERROR_STREAM(TargetPolicy::name()
+                     << ": Invalid ROS message for desiredExternalToolCompensationCallback provided");
+    throw std::invalid_argument("Aborting controller!");
+  }
+  Eigen::Matrix<double, 6, 1> tool_compensation_force;
+  for (int i = 0; i < 6; i ++) {
+    tool_compensation_force(i) = msg.data[i];
+  }
+  target_buffer_.modify([&](CartesianImpedanceTarget& target) {
+    target.tool_compensation_force = tool_compensation_force;
+  });
+  ROS_WARN_STREAM("[desiredExternalToolCompensationCallback]: tool_compensation_force: " << std::endl <<  tool_compensation_force);
+}
+
+}  // namespace franka_interactive_controllers
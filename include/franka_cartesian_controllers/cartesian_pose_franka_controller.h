@@ -14,6 +14,8 @@
 
 #include <franka_hw/franka_cartesian_command_interface.h>
 
+#include <cycle_timing.h>
+
 namespace franka_interactive_controllers {
 
 class CartesianPoseFrankaController
@@ -29,6 +31,9 @@ class CartesianPoseFrankaController
   std::unique_ptr<franka_hw::FrankaCartesianPoseHandle> cartesian_pose_handle_;
   ros::Duration elapsed_time_;
   std::array<double, 16> initial_pose_{};
+
+  // update() timing, published on <controller_ns>/cycle_timing
+  CycleTimer cycle_timer_;
 };
 
 }  // namespace franka_interactive_controllers
@@ -2,96 +2,61 @@
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
 #pragma once
 
-#include <memory>
-#include <string>
-#include <vector>
-
-#include <controller_interface/multi_interface_controller.h>
-#include <dynamic_reconfigure/server.h>
 #include <geometry_msgs/PoseStamped.h>
-#include <std_msgs/Float64MultiArray.h>
-#include <hardware_interface/joint_command_interface.h>
-#include <hardware_interface/robot_hw.h>
 #include <ros/node_handle.h>
 #include <ros/time.h>
 #include <Eigen/Dense>
 
-#include <franka_interactive_controllers/compliance_paramConfig.h>
-#include <franka_hw/franka_model_interface.h>
 #include <franka_hw/franka_state_interface.h>
 
+#include <cartesian_impedance_core.h>
+#include <pose_interpolator.h>
+
 namespace franka_interactive_controllers {
 
-class CartesianPoseImpedanceController : public controller_interface::MultiInterfaceController<
-                                                franka_hw::FrankaModelInterface,
-                                                hardware_interface::EffortJointInterface,
-                                                franka_hw::FrankaStateInterface> {
+// Equilibrium pose streamed on "/cartesian_impedance_controller/desired_pose", resampled at the
+// control rate: update() evaluates the stamped waypoints pose_interpolation_delay seconds in the
+// past (cubic Hermite position, SQUAD orientation) and extrapolates for at most
+// pose_extrapolation_limit seconds when the stream stalls. Until the first waypoint arrives the
+// pose at starting() is held.
+class PoseTargetPolicy : public CartesianTargetPolicyBase {
  public:
-  bool init(hardware_interface::RobotHW* robot_hw, ros::NodeHandle& node_handle) override;
-  void starting(const ros::Time&) override;
-  void update(const ros::Time&, const ros::Duration& period) override;
+  static const char* name() { return "CartesianPoseImpedanceController"; }
+
+  bool init(ros::NodeHandle& node_handle, const franka_hw::FrankaStateHandle& state_handle,
+            TripleBuffer<CartesianImpedanceTarget>* target_buffer);
+  void starting(const Eigen::Vector3d& position, const Eigen::Quaterniond& orientation) {
+    position_d_ = position;
+    orientation_d_ = orientation;
+    interpolator_.resetFromRT();
+  }
+  void update(const ros::Time& time,
+              const ros::Duration& /*period*/,
+              const CartesianImpedanceTarget& /*target*/,
+              const Eigen::Affine3d& /*transform*/,
+              Eigen::Vector3d* position_d,
+              Eigen::Quaterniond* orientation_d) {
+    interpolator_.evaluate(time.toSec(), &position_d_, &orientation_d_);
+    *position_d = position_d_;
+    *orientation_d = orientation_d_;
+  }
 
  private:
-  // Saturation
-  Eigen::Matrix<double, 7, 1> saturateTorqueRate(
-      const Eigen::Matrix<double, 7, 1>& tau_d_calculated,
-      const Eigen::Matrix<double, 7, 1>& tau_J_d);  // NOLINT (readability-identifier-naming)
-
-  std::unique_ptr<franka_hw::FrankaStateHandle> state_handle_;
-  std::unique_ptr<franka_hw::FrankaModelHandle> model_handle_;
-  std::vector<hardware_interface::JointHandle> joint_handles_;
-
-  // double filter_params_{0.005};
-  double filter_params_{0.002};
-  // double nullspace_stiffness_{20.0};
-  // double nullspace_stiffness_target_{20.0};
-  Eigen::Matrix<double, 7, 7> nullspace_stiffness_;
-  Eigen::Matrix<double, 7, 7> nullspace_stiffness_target_;
-  Eigen::Matrix<double, 7, 7> nullspace_damping_;
-  Eigen::Matrix<double, 7, 7> nullspace_damping_target_;
-
-  const double delta_tau_max_{1.0};
-  Eigen::Matrix<double, 6, 6> cartesian_stiffness_;
-  Eigen::Matrix<double, 6, 6> cartesian_stiffness_target_;
-  Eigen::Matrix<double, 6, 6> cartesian_damping_;
-  Eigen::Matrix<double, 6, 6> cartesian_damping_target_;
-  Eigen::Matrix<double, 7, 1> q_d_nullspace_;
-  // whether to load from yaml or use initial robot config
-  bool q_d_nullspace_initialized_ = false;
-  Eigen::Vector3d position_d_;
-  Eigen::Quaterniond orientation_d_;
-  Eigen::Vector3d position_d_target_;
-  Eigen::Quaterniond orientation_d_target_;
+  // Stamped waypoints from the subscriber, resampled by the RT loop
+  PoseInterpolator interpolator_;
 
-  // Variables for initialization and tool compensation
-  bool _goto_home;
-  double jointDS_epsilon_;
-  double dq_filter_params_;
-  Eigen::Matrix<double, 7, 1> q_home_;
-  Eigen::Matrix<double, 7, 7> A_jointDS_home_;
-  Eigen::Matrix<double, 7, 7> k_joint_gains_;
-  Eigen::Matrix<double, 7, 7> d_joint_gains_;
-  Eigen::Matrix<double, 7, 7> d_ff_joint_gains_;
-  Eigen::Matrix<double, 6, 1> tool_compensation_force_;
-  bool activate_tool_compensation_;
-  
-  // Dynamic reconfigure
-  std::unique_ptr<dynamic_reconfigure::Server<franka_interactive_controllers::compliance_paramConfig>>
-      dynamic_server_compliance_param_;
-  ros::NodeHandle dynamic_reconfigure_compliance_param_node_;
-  void complianceParamCallback(franka_interactive_controllers::compliance_paramConfig& config,
-                               uint32_t level);
-
-  // Dynamic reconfigure from ROS message
-  ros::Subscriber sub_desired_cartesian_stiffness_;
-  void desiredCartesianStiffnessCallback(const std_msgs::Float64MultiArray& msg);
-
-  ros::Subscriber sub_desired_nullspace_stiffness_;
-  void desiredNullspaceStiffnessCallback(const std_msgs::Float64MultiArray& msg);
+  // Current setpoint, owned by the RT loop
+  Eigen::Vector3d position_d_{Eigen::Vector3d::Zero()};
+  Eigen::Quaterniond orientation_d_{Eigen::Quaterniond::Identity()};
 
   // Desireds pose subscriber
   ros::Subscriber sub_desired_pose_;
   void desiredPoseCallback(const geometry_msgs::PoseStampedConstPtr& msg);
 };
 
+class CartesianPoseImpedanceController : public CartesianImpedanceCore<PoseTargetPolicy> {
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
 }  // namespace franka_interactive_controllers
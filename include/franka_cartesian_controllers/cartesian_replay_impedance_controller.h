@@ -0,0 +1,140 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <ros/node_handle.h>
+#include <ros/service_server.h>
+#include <ros/time.h>
+#include <std_srvs/Trigger.h>
+#include <Eigen/Dense>
+
+#include <franka_hw/franka_state_interface.h>
+#include <franka_interactive_controllers/ReplayLoad.h>
+#include <franka_interactive_controllers/ReplaySeek.h>
+#include <franka_interactive_controllers/ReplayStart.h>
+
+#include <cartesian_impedance_core.h>
+#include <flight_log.h>
+#include <triple_buffer.h>
+
+namespace franka_interactive_controllers {
+
+// Equilibrium pose replayed from a flight log (flight_recorder.h) inside update(): the log is
+// memory mapped when loaded and the RT loop advances through it by period * time_scale per tick,
+// interpolating between samples (linear position, slerp orientation), so the replay keeps the
+// recorded timing exactly and needs no topic. The pose comes from O_T_EE (e.g. a kinesthetic
+// demonstration recorded with the gravity compensation controller) or, with
+// replay_source: desired, from the equilibrium pose of a logged impedance controller. Optionally
+// the Cartesian stiffness and damping follow the log as well.
+//
+// Services in the controller namespace:
+//   replay/load   ReplayLoad   maps a log, stops a running replay
+//   replay/start  ReplayStart  plays from the current position at time_scale (rewinds at the end)
+//   replay/stop   Trigger      holds the current setpoint
+//   replay/seek   ReplaySeek   moves the position while stopped
+// start refuses to begin further than replay_max_start_distance (m) or replay_max_start_angle
+// (rad) from the current end-effector pose, 0 disables either check, and plays no faster than
+// replay_max_time_scale (0 disables the limit). load locks the log in memory. When the log ends
+// the last pose is held.
+class ReplayTargetPolicy : public CartesianTargetPolicyBase {
+ public:
+  static const char* name() { return "CartesianReplayImpedanceController"; }
+
+  bool init(ros::NodeHandle& node_handle, const franka_hw::FrankaStateHandle& state_handle,
+            TripleBuffer<CartesianImpedanceTarget>* target_buffer);
+  void starting(const Eigen::Vector3d& position, const Eigen::Quaterniond& orientation);
+  const CartesianImpedanceTarget& adjustTarget(const CartesianImpedanceTarget& target);
+  void update(const ros::Time& time,
+              const ros::Duration& period,
+              const CartesianImpedanceTarget& target,
+              const Eigen::Affine3d& transform,
+              Eigen::Vector3d* position_d,
+              Eigen::Quaterniond* orientation_d);
+
+ private:
+  // A mapped log and where its fields are
+  struct ReplayTrack {
+    FlightLog log;
+    const FlightLogField* time{nullptr};
+    const FlightLogField* position{nullptr};     // O_T_EE or position_d
+    const FlightLogField* orientation{nullptr};  // orientation_d, nullptr for O_T_EE
+    const FlightLogField* stiffness{nullptr};    // nullptr unless the gains are replayed
+    const FlightLogField* damping{nullptr};
+    double start_time{0.0};
+    double duration{0.0};
+    uint64_t generation{0};
+
+    double sampleTime(uint64_t index) const { return log.values(index, *time)[0] - start_time; }
+    void pose(uint64_t index, Eigen::Vector3d* position, Eigen::Quaterniond* orientation) const;
+  };
+
+  // Written by the services, applied by update(). Play/stop and seek are applied when their
+  // sequence changes, so a later command does not repeat them.
+  struct ReplayCommand {
+    const ReplayTrack* track{nullptr};
+    bool playing{false};
+    uint64_t play_sequence{0};
+    double time_scale{1.0};
+    double seek_time{0.0};
+    uint64_t seek_sequence{0};
+  };
+
+  void applyCommand(const ReplayCommand& command);
+  // RT: moves cursor_ to the last sample at or before time, by bisection (seek) or forward from
+  // the cursor, at most a few samples per tick while playing (advance)
+  void seek(double time);
+  void advance(double time);
+  void evaluate(double time, Eigen::Vector3d* position, Eigen::Quaterniond* orientation) const;
+
+  bool loadCallback(ReplayLoad::Request& request, ReplayLoad::Response& response);
+  bool startCallback(ReplayStart::Request& request, ReplayStart::Response& response);
+  bool stopCallback(std_srvs::Trigger::Request& request, std_srvs::Trigger::Response& response);
+  bool seekCallback(ReplaySeek::Request& request, ReplaySeek::Response& response);
+
+  const franka_hw::FrankaStateHandle* state_handle_{nullptr};
+  bool replay_desired_{false};
+  double max_start_distance_{0.05};
+  double max_start_angle_{0.2};
+  double max_time_scale_{2.0};
+
+  // Service side, under mutex_. Tracks stay mapped until update() has moved past them.
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<ReplayTrack>> tracks_;
+  uint64_t generation_{0};
+  TripleBuffer<ReplayCommand> command_buffer_;
+
+  // Owned by the RT loop
+  const ReplayTrack* track_{nullptr};
+  bool playing_{false};
+  double time_scale_{1.0};
+  double replay_time_{0.0};
+  uint64_t cursor_{0};
+  uint64_t play_sequence_{0};
+  uint64_t seek_sequence_{0};
+  Eigen::Vector3d position_d_{Eigen::Vector3d::Zero()};
+  Eigen::Quaterniond orientation_d_{Eigen::Quaterniond::Identity()};
+  CartesianImpedanceTarget replay_target_;
+
+  // Reported by the RT loop to the services
+  std::atomic<uint64_t> rt_generation_{0};
+  std::atomic<bool> rt_playing_{false};
+  std::atomic<double> rt_replay_time_{0.0};
+
+  ros::ServiceServer load_service_;
+  ros::ServiceServer start_service_;
+  ros::ServiceServer stop_service_;
+  ros::ServiceServer seek_service_;
+};
+
+class CartesianReplayImpedanceController : public CartesianImpedanceCore<ReplayTargetPolicy> {
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+}  // namespace franka_interactive_controllers
@@ -2,100 +2,104 @@
 // Use of this source code is governed by the Apache-2.0 license, see LICENSE
 #pragma once
 
-#include <memory>
-#include <string>
-#include <vector>
-
-#include <controller_interface/multi_interface_controller.h>
-#include <dynamic_reconfigure/server.h>
-#include <geometry_msgs/PoseStamped.h>
-#include <std_msgs/Float64MultiArray.h>
+#include <algorithm>
+#include <cmath>
+
 #include <geometry_msgs/Twist.h>
-#include <hardware_interface/joint_command_interface.h>
-#include <hardware_interface/robot_hw.h>
 #include <ros/node_handle.h>
 #include <ros/time.h>
 #include <Eigen/Dense>
 
-#include <franka_interactive_controllers/compliance_paramConfig.h>
-#include <franka_hw/franka_model_interface.h>
 #include <franka_hw/franka_state_interface.h>
 
+#include <cartesian_impedance_core.h>
+#include <triple_buffer.h>
+
 namespace franka_interactive_controllers {
 
-class CartesianTwistImpedanceController : public controller_interface::MultiInterfaceController<
-                                                franka_hw::FrankaModelInterface,
-                                                hardware_interface::EffortJointInterface,
-                                                franka_hw::FrankaStateInterface> {
+// Equilibrium pose obtained by integrating the twist streamed on
+// "/cartesian_impedance_controller/desired_twist" (base frame) inside update(), with the real
+// control period: the position with the linear velocity, the orientation on SO(3) with the
+// angular velocity. If no twist arrives for twist_timeout seconds the commanded twist decays
+// to zero with time constant twist_decay_time, so the setpoint comes to hold. The setpoint never
+// leads the measured O_T_EE by more than twist_max_position_lead [m] and
+// twist_max_orientation_lead [rad] (0 disables either), so it does not run away while the arm is
+// blocked.
+class TwistTargetPolicy : public CartesianTargetPolicyBase {
  public:
-  bool init(hardware_interface::RobotHW* robot_hw, ros::NodeHandle& node_handle) override;
-  void starting(const ros::Time&) override;
-  void update(const ros::Time&, const ros::Duration& period) override;
+  static const char* name() { return "CartesianTwistImpedanceController"; }
+
+  bool init(ros::NodeHandle& node_handle, const franka_hw::FrankaStateHandle& state_handle,
+            TripleBuffer<CartesianImpedanceTarget>* target_buffer);
+  void starting(const Eigen::Vector3d& position, const Eigen::Quaterniond& orientation);
+  void update(const ros::Time& /*time*/,
+              const ros::Duration& period,
+              const CartesianImpedanceTarget& /*target*/,
+              const Eigen::Affine3d& transform,
+              Eigen::Vector3d* position_d,
+              Eigen::Quaterniond* orientation_d) {
+    const double dt = std::max(period.toSec(), 0.0);
+    if (twist_buffer_.hasNewData()) {
+      twist_age_ = 0.0;
+    } else {
+      twist_age_ += dt;
+    }
+    const DesiredTwist& twist = twist_buffer_.readFromRT();
+
+    double scale = 1.0;
+    if (twist_age_ > twist_timeout_) {
+      scale = std::exp(-(twist_age_ - twist_timeout_) / twist_decay_time_);
+    }
+
+    position_d_ += (scale * dt) * twist.linear;
+    Eigen::Vector3d rotation = (scale * dt) * twist.angular;
+    const double angle = rotation.norm();
+    if (angle > 1e-12) {
+      orientation_d_ = Eigen::Quaterniond(Eigen::AngleAxisd(angle, rotation / angle)) *
+                       orientation_d_;
+      orientation_d_.normalize();
+    }
+
+    // Bounded lead over the measured pose
+    const Eigen::Vector3d position(transform.translation());
+    const Eigen::Vector3d lead = position_d_ - position;
+    const double distance = lead.norm();
+    if (max_position_lead_ > 0.0 && distance > max_position_lead_) {
+      position_d_ = position + (max_position_lead_ / distance) * lead;
+    }
+    const Eigen::Quaterniond orientation(transform.linear());
+    const double lead_angle = orientation.angularDistance(orientation_d_);
+    if (max_orientation_lead_ > 0.0 && lead_angle > max_orientation_lead_) {
+      orientation_d_ = orientation.slerp(max_orientation_lead_ / lead_angle, orientation_d_);
+    }
+
+    *position_d = position_d_;
+    *orientation_d = orientation_d_;
+  }
 
  private:
-  // Saturation
-  Eigen::Matrix<double, 7, 1> saturateTorqueRate(
-      const Eigen::Matrix<double, 7, 1>& tau_d_calculated,
-      const Eigen::Matrix<double, 7, 1>& tau_J_d);  // NOLINT (readability-identifier-naming)
-
-  std::unique_ptr<franka_hw::FrankaStateHandle> state_handle_;
-  std::unique_ptr<franka_hw::FrankaModelHandle> model_handle_;
-  std::vector<hardware_interface::JointHandle> joint_handles_;
-
-  double dt_ = 0.001;
-  double filter_params_{0.005};
-  // double nullspace_stiffness_{20.0};
-  // double nullspace_stiffness_target_{20.0};
-  Eigen::Matrix<double, 7, 7> nullspace_stiffness_; 
-  Eigen::Matrix<double, 7, 7> nullspace_stiffness_target_;  
-  Eigen::Matrix<double, 7, 7> nullspace_damping_; 
-  Eigen::Matrix<double, 7, 7> nullspace_damping_target_;  
-
-  const double delta_tau_max_{1.0};
-  Eigen::Matrix<double, 6, 6> cartesian_stiffness_;
-  Eigen::Matrix<double, 6, 6> cartesian_stiffness_target_;
-  Eigen::Matrix<double, 6, 6> cartesian_damping_;
-  Eigen::Matrix<double, 6, 6> cartesian_damping_target_;
-  Eigen::Matrix<double, 7, 1> q_d_nullspace_;
-  // whether to load from yaml or use initial robot config
-  bool q_d_nullspace_initialized_ = false;
-  Eigen::Vector3d position_d_;
-  Eigen::Quaterniond orientation_d_;
-  Eigen::Vector3d position_d_target_;
-  Eigen::Quaterniond orientation_d_target_;
-  Eigen::Vector3d velocity_d_;
-
-  // Variables for initialization and tool compensation
-  bool _goto_home;
-  double jointDS_epsilon_;
-  double dq_filter_params_;
-  Eigen::Matrix<double, 7, 1> q_home_;
-  Eigen::Matrix<double, 7, 7> A_jointDS_home_;
-  Eigen::Matrix<double, 7, 7> k_joint_gains_;
-  Eigen::Matrix<double, 7, 7> d_joint_gains_;
-  Eigen::Matrix<double, 7, 7> d_ff_joint_gains_;
-  Eigen::Matrix<double, 6, 1> tool_compensation_force_;
-  Eigen::Matrix<double, 6, 1> tool_compensation_force_target_;
-  bool activate_tool_compensation_;
-  
-  // Dynamic reconfigure
-  std::unique_ptr<dynamic_reconfigure::Server<franka_interactive_controllers::compliance_paramConfig>>
-      dynamic_server_compliance_param_;
-  ros::NodeHandle dynamic_reconfigure_compliance_param_node_;
-  void complianceParamCallback(franka_interactive_controllers::compliance_paramConfig& config,
-                               uint32_t level);
-  
-  // Dynamic reconfigure from ROS message 
-  ros::Subscriber sub_desired_cartesian_stiffness_;
-  void desiredCartesianStiffnessCallback(const std_msgs::Float64MultiArray& msg);
-  ros::Subscriber sub_desired_nullspace_stiffness_;
-  void desiredNullspaceStiffnessCallback(const std_msgs::Float64MultiArray& msg);
-  ros::Subscriber sub_desired_external_tool_compensation_; 
-  void desiredExternalToolCompensationCallback(const std_msgs::Float64MultiArray& msg); 
+  struct DesiredTwist {
+    Eigen::Vector3d linear{Eigen::Vector3d::Zero()};
+    Eigen::Vector3d angular{Eigen::Vector3d::Zero()};
+  };
+
+  // Latest twist from the subscriber, latched for the RT loop
+  TripleBuffer<DesiredTwist> twist_buffer_;
+  double twist_timeout_{0.1};
+  double twist_decay_time_{0.05};
+  double max_position_lead_{0.1};
+  double max_orientation_lead_{0.5};
+
+  // Integrated setpoint, owned by the RT loop
+  Eigen::Vector3d position_d_{Eigen::Vector3d::Zero()};
+  Eigen::Quaterniond orientation_d_{Eigen::Quaterniond::Identity()};
+  double twist_age_{0.0};
 
   // Desired twist subscriber
   ros::Subscriber sub_desired_twist_;
   void desiredTwistCallback(const geometry_msgs::TwistConstPtr& msg);
 };
 
+class CartesianTwistImpedanceController : public CartesianImpedanceCore<TwistTargetPolicy> {};
+
 }  // namespace franka_interactive_controllers
@@ -12,6 +12,8 @@
 #include <ros/node_handle.h>
 #include <ros/time.h>
 
+#include <cycle_timing.h>
+
 namespace franka_interactive_controllers {
 
 class CartesianVelocityFrankaController : public controller_interface::MultiInterfaceController<
@@ -27,6 +29,9 @@ class CartesianVelocityFrankaController : public controller_interface::MultiInte
   franka_hw::FrankaVelocityCartesianInterface* velocity_cartesian_interface_;
   std::unique_ptr<franka_hw::FrankaCartesianVelocityHandle> velocity_cartesian_handle_;
   ros::Duration elapsed_time_;
+
+  // update() timing, published on <controller_ns>/cycle_timing
+  CycleTimer cycle_timer_;
 };
 
 }  // namespace franka_interactive_controllers
@@ -0,0 +1,131 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <actionlib/server/simple_action_server.h>
+#include <controller_interface/multi_interface_controller.h>
+#include <hardware_interface/joint_command_interface.h>
+#include <hardware_interface/robot_hw.h>
+#include <ros/node_handle.h>
+#include <ros/time.h>
+#include <Eigen/Core>
+
+#include <franka_hw/franka_state_interface.h>
+#include <franka_interactive_controllers/MoveToJointGoalAction.h>
+
+#include <cycle_timing.h>
+#include <joint_goals.h>
+#include <libfranka_waypoint_motion_generator.h>
+#include <triple_buffer.h>
+
+namespace franka_interactive_controllers {
+
+// Moves the arm to named or explicit joint goals inside the running control stack, so a reset
+// (e.g. to home) needs no restart of franka_control as the libfranka_joint_goal_motion_generator*
+// executables do. The action server plans a WaypointMotionGenerator (the timing of
+// MotionGenerator, passing intermediate goals without stopping) and update() samples it on the
+// position joint interface; without a goal the last setpoint is held.
+//
+// Action in the controller namespace:
+//   move_to_joint_goal  MoveToJointGoal  goals by name from joint_goals (config/joint_goals.yaml)
+//                                        or as 7 joint positions each
+// A new goal while moving takes over from the running motion without stopping, turning towards
+// it as early as the limits allow (it keeps the speed factor of the running motion); a cancel
+// brakes along the current path. Goals outside the Panda joint limits, and plans that would leave
+// them (blends and takeovers move the corners), are rejected and stop a running motion.
+//
+// Usage:
+//   roslaunch franka_interactive_controllers joint_goal_motion_controller.launch
+//   rosrun actionlib_tools axclient.py /joint_goal_motion_controller/move_to_joint_goal
+class JointGoalMotionController
+    : public controller_interface::MultiInterfaceController<
+          hardware_interface::PositionJointInterface,
+          franka_hw::FrankaStateInterface> {
+ public:
+  bool init(hardware_interface::RobotHW* robot_hardware, ros::NodeHandle& node_handle) override;
+  void starting(const ros::Time&) override;
+  void update(const ros::Time&, const ros::Duration& period) override;
+  void stopping(const ros::Time&) override;
+
+ private:
+  using ActionServer = actionlib::SimpleActionServer<MoveToJointGoalAction>;
+  using Vector7d = Eigen::Matrix<double, 7, 1>;
+
+  // A planned motion; owned by the action server thread, read by update() while active
+  struct Motion {
+    Motion(double speed_factor, const std::vector<JointGoal>& goals)
+        : generator(speed_factor, goals) {}
+    WaypointMotionGenerator generator;
+    uint64_t sequence{0};
+    // Via points of the motion taken over that count as passed waypoints
+    std::size_t skipped{0};
+  };
+
+  // Written by the action server, applied by update() when its sequence changes. A motion
+  // taking over from base (nullptr: from rest at the held position) is only applied while its
+  // clock is at most switch_until_us, before the two motions part.
+  struct MotionCommand {
+    const Motion* motion{nullptr};
+    const Motion* base{nullptr};
+    uint64_t switch_until_us{0};
+    uint64_t sequence{0};
+  };
+
+  void executeCallback(const MoveToJointGoalGoalConstPtr& goal);
+  bool resolveGoals(const MoveToJointGoalGoal& goal,
+                    std::vector<JointGoal>* goals,
+                    std::string* error);
+  // Plans from the running motion (or from rest) through goals, none to stop, and waits until
+  // update() has taken it over. Returns false with a message in error otherwise; motion is
+  // nullptr if there was nothing to stop.
+  bool command(double speed_factor,
+               const std::vector<JointGoal>& goals,
+               const Motion** motion,
+               std::string* error);
+
+  // RT
+  void applyCommand(const MotionCommand& command);
+
+  std::vector<hardware_interface::JointHandle> position_joint_handles_;
+  std::unique_ptr<franka_hw::FrankaStateHandle> state_handle_;
+  double default_speed_factor_{0.6};
+
+  // Action server side
+  std::map<std::string, JointGoal> goals_;
+  std::vector<std::unique_ptr<Motion>> motions_;
+  uint64_t sequence_{0};
+  TripleBuffer<MotionCommand> command_buffer_;
+
+  // Owned by the RT loop
+  const Motion* motion_{nullptr};
+  uint64_t time_us_{0};
+  uint64_t command_sequence_{0};
+  Vector7d q_hold_{Vector7d::Zero()};
+  Vector7d q_command_{Vector7d::Zero()};
+
+  // Reported by the RT loop to the action server. rt_motion_ is stored before
+  // rt_command_sequence_, rt_hold_ before rt_motion_ returns to nullptr.
+  std::atomic<const Motion*> rt_motion_{nullptr};
+  std::atomic<uint64_t> rt_time_us_{0};
+  std::atomic<uint64_t> rt_command_sequence_{0};
+  std::atomic<uint64_t> rt_rejected_sequence_{0};
+  std::atomic<uint64_t> rt_finished_sequence_{0};
+  std::atomic<uint64_t> rt_activations_{0};  // starting() and stopping()
+  std::array<std::atomic<double>, 7> rt_hold_{};
+
+  // update() timing, published on <controller_ns>/cycle_timing
+  CycleTimer cycle_timer_;
+
+  // Declared last so that its execute thread is joined before the members it uses go away
+  std::unique_ptr<ActionServer> action_server_;
+};
+
+}  // namespace franka_interactive_controllers
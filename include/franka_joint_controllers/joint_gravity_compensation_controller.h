@@ -21,41 +21,70 @@
 #include <franka_hw/franka_model_interface.h>
 #include <franka_hw/franka_state_interface.h>
 
+#include <allocation_counter.h>
+#include <cycle_timing.h>
+#include <ee_state_publisher.h>
+#include <flight_recorder.h>
+#include <impedance_gain.h>
+#include <model_cache.h>
+#include <realtime_log.h>
+#include <robot_state_view.h>
+#include <torque_pipeline.h>
+#include <triple_buffer.h>
+
 namespace franka_interactive_controllers {
 
+// Values written by the dynamic reconfigure callback and consumed by update().
+struct GravityCompensationTarget {
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  bool activate_tool_compensation{true};
+  Eigen::Matrix<double, 6, 1> tool_compensation_force{Eigen::Matrix<double, 6, 1>::Zero()};
+  bool activate_lock_joint6{false};
+  bool activate_lock_joint7{false};
+  Eigen::Matrix<double, 7, 1> q_locked_joints{Eigen::Matrix<double, 7, 1>::Zero()};
+  // k_lock_ on the locked joints, zero elsewhere
+  ImpedanceGain<7> lock_stiffness{ImpedanceGain<7>::fromDiagonal(Eigen::Matrix<double, 7, 1>::Zero())};
+};
+
+// Joint lock springs + coriolis - tool compensation, torque rate saturated
+using GravityCompensationTorque = TorquePipeline<TaskTorqueStage, CoriolisStage,
+                                                 ToolCompensationStage, TorqueRateSaturationStage>;
+
 class JointGravityCompensationController : public controller_interface::MultiInterfaceController<
                                                 franka_hw::FrankaModelInterface,
                                                 hardware_interface::EffortJointInterface,
                                                 franka_hw::FrankaStateInterface> {
  public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
   bool init(hardware_interface::RobotHW* robot_hw, ros::NodeHandle& node_handle) override;
   void starting(const ros::Time&) override;
+  void stopping(const ros::Time&) override;
   void update(const ros::Time&, const ros::Duration& period) override;
 
  private:
-  // Saturation
-  Eigen::Matrix<double, 7, 1> saturateTorqueRate(
-      const Eigen::Matrix<double, 7, 1>& tau_d_calculated,
-      const Eigen::Matrix<double, 7, 1>& tau_J_d);  // NOLINT (readability-identifier-naming)
-
   std::unique_ptr<franka_hw::FrankaStateHandle> state_handle_;
+  // Robot state of the current tick, read in place from the state handle
+  RobotStateView state_view_;
   std::unique_ptr<franka_hw::FrankaModelHandle> model_handle_;
   std::vector<hardware_interface::JointHandle> joint_handles_;
 
-  const double delta_tau_max_{1.0};
+  // Jacobian (tool compensation only) and Coriolis of the current tick, evaluated on first use
+  ModelCache model_cache_;
+
+  // Torque terms computed in update(), kept here so the loop never allocates
+  Eigen::Matrix<double, 7, 1> tau_task_;
+  Eigen::Matrix<double, 7, 1> tau_d_;
+  RealtimeAllocationCheck allocation_check_;
 
-  // Variables for tool compensation
-  bool activate_tool_compensation_;
-  Eigen::Matrix<double, 6, 1> tool_compensation_force_;
+  const double delta_tau_max_{1.0};
 
+  // Tool compensation and joint locks handed over from dynamic reconfigure to update()
+  TripleBuffer<GravityCompensationTarget> target_buffer_;
 
   // Variables for joint locks
-  Eigen::Matrix<double, 7, 1> q_locked_joints_;
-  bool activate_lock_joint6_;
-  bool activate_lock_joint7_;
-  bool set_locked_joints_position_;
   double k_lock_;
-  
 
   // Dynamic reconfigure
   std::unique_ptr<dynamic_reconfigure::Server<franka_interactive_controllers::gravity_compensation_paramConfig>>
@@ -63,6 +92,15 @@ class JointGravityCompensationController : public controller_interface::MultiInt
   ros::NodeHandle dynamic_reconfigure_gravity_compensation_param_node_;
   void gravitycompensationParamCallback(franka_interactive_controllers::gravity_compensation_paramConfig& config,
                                uint32_t level);
+
+  // update() timing, published on <controller_ns>/cycle_timing
+  CycleTimer cycle_timer_;
+
+  // Optional <controller_ns>/ee_{pose,twist,wrench} from the control tick
+  EndEffectorStatePublisher ee_state_publisher_;
+
+  // Optional binary log of every tick, started and stopped through <controller_ns>/flight_recorder
+  FlightRecorder flight_recorder_;
 };
 
 }  // namespace franka_interactive_controllers
@@ -17,6 +17,10 @@
 #include <franka_hw/franka_model_interface.h>
 #include <franka_hw/trigger_rate.h>
 
+#include <cycle_timing.h>
+#include <model_cache.h>
+#include <robot_state_view.h>
+
 namespace franka_interactive_controllers {
 
 class JointImpedanceFrankaController : public controller_interface::MultiInterfaceController<
@@ -24,6 +28,8 @@ class JointImpedanceFrankaController : public controller_interface::MultiInterfa
                                             hardware_interface::EffortJointInterface,
                                             franka_hw::FrankaPoseCartesianInterface> {
  public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
   bool init(hardware_interface::RobotHW* robot_hw, ros::NodeHandle& node_handle) override;
   void starting(const ros::Time&) override;
   void update(const ros::Time&, const ros::Duration& period) override;
@@ -32,10 +38,14 @@ class JointImpedanceFrankaController : public controller_interface::MultiInterfa
   // Saturation
   std::array<double, 7> saturateTorqueRate(
       const std::array<double, 7>& tau_d_calculated,
-      const std::array<double, 7>& tau_J_d);  // NOLINT (readability-identifier-naming)
+      const RobotStateView::Vector7dMap& tau_J_d);  // NOLINT (readability-identifier-naming)
 
   std::unique_ptr<franka_hw::FrankaCartesianPoseHandle> cartesian_pose_handle_;
+  // Robot state of the current tick, read in place from the pose handle
+  RobotStateView state_view_;
   std::unique_ptr<franka_hw::FrankaModelHandle> model_handle_;
+  // Coriolis of the current tick, evaluated on first use
+  ModelCache model_cache_;
   std::vector<hardware_interface::JointHandle> joint_handles_;
 
   static constexpr double kDeltaTauMax{1.0};
@@ -52,7 +62,9 @@ class JointImpedanceFrankaController : public controller_interface::MultiInterfa
   std::array<double, 16> initial_pose_;
 
   franka_hw::TriggerRate rate_trigger_{1.0};
-  std::array<double, 7> last_tau_d_{};
+
+  // update() timing, published on <controller_ns>/cycle_timing
+  CycleTimer cycle_timer_;
 };
 
 }  // namespace franka_interactive_controllers
@@ -12,6 +12,8 @@
 #include <ros/node_handle.h>
 #include <ros/time.h>
 
+#include <cycle_timing.h>
+
 namespace franka_interactive_controllers {
 
 class JointPositionFrankaController : public controller_interface::MultiInterfaceController<
@@ -26,6 +28,9 @@ class JointPositionFrankaController : public controller_interface::MultiInterfac
   std::vector<hardware_interface::JointHandle> position_joint_handles_;
   ros::Duration elapsed_time_;
   std::array<double, 7> initial_pose_{};
+
+  // update() timing, published on <controller_ns>/cycle_timing
+  CycleTimer cycle_timer_;
 };
 
 }  // namespace franka_interactive_controllers
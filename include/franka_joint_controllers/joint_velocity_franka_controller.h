@@ -12,6 +12,8 @@
 #include <ros/node_handle.h>
 #include <ros/time.h>
 
+#include <cycle_timing.h>
+
 namespace franka_interactive_controllers {
 
 class JointVelocityFrankaController : public controller_interface::MultiInterfaceController<
@@ -27,6 +29,9 @@ class JointVelocityFrankaController : public controller_interface::MultiInterfac
   hardware_interface::VelocityJointInterface* velocity_joint_interface_;
   std::vector<hardware_interface::JointHandle> velocity_joint_handles_;
   ros::Duration elapsed_time_;
+
+  // update() timing, published on <controller_ns>/cycle_timing
+  CycleTimer cycle_timer_;
 };
 
 }  // namespace franka_interactive_controllers
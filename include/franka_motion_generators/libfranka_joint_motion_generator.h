@@ -27,9 +27,16 @@
  * An example showing how to generate a joint pose motion to a goal position. Adapted from:
  * Wisama Khalil and Etienne Dombre. 2002. Modeling, Identification and Control of Robots
  * (Kogan Page Science Paper edition).
+ *
+ * The synchronized profile is planned once, by plan() before robot.control() or otherwise on the
+ * first callback, into three polynomial phases per joint (accelerate, cruise, decelerate) stored
+ * as coefficient arrays across the joints. A callback then only evaluates the three polynomials
+ * for all joints at once, clamping the time into each phase instead of branching on it.
  */
 class MotionGenerator {
  public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
   /**
    * Creates a new MotionGenerator instance for a target q.
    *
@@ -38,6 +45,44 @@ class MotionGenerator {
    */
   MotionGenerator(double speed_factor, const std::array<double, 7> q_goal);
 
+  /**
+   * Creates a new MotionGenerator instance for a target q and plans it from q_start.
+   *
+   * @param[in] speed_factor General speed factor in range [0, 1].
+   * @param[in] q_start Joint positions the motion starts from, e.g. robot.readOnce().q_d.
+   * @param[in] q_goal Target joint positions.
+   */
+  MotionGenerator(double speed_factor,
+                  const std::array<double, 7>& q_start,
+                  const std::array<double, 7> q_goal);
+
+  /**
+   * Plans the synchronized motion from q_start. The first callback replans from its q_d if that
+   * differs from q_start.
+   *
+   * @param[in] q_start Joint positions the motion starts from, e.g. robot.readOnce().q_d.
+   */
+  void plan(const std::array<double, 7>& q_start);
+
+  /**
+   * @return Whether the motion has been planned.
+   */
+  bool isPlanned() const { return planned_; }
+
+  /**
+   * @return Duration of the planned motion in seconds.
+   */
+  double duration() const { return duration_; }
+
+  /**
+   * Samples the planned motion for preview or validation before it is executed.
+   *
+   * @param[in] dt Time between samples in seconds, e.g. 0.001 for the control rate.
+   * @param[out] positions Joint positions at 0, dt, 2dt, ... up to the first sample at or after
+   * duration() (the goal), one column per sample.
+   */
+  void sample(double dt, Eigen::Matrix<double, 7, Eigen::Dynamic>* positions) const;
+
   /**
    * Sends joint position calculations
    *
@@ -51,9 +96,23 @@ class MotionGenerator {
  private:
   using Vector7d = Eigen::Matrix<double, 7, 1, Eigen::ColMajor>;
   using Vector7i = Eigen::Matrix<int, 7, 1, Eigen::ColMajor>;
+  // One lane per joint, padded to 8 so the per-tick evaluation vectorizes; the last lane stays 0
+  using Lanes = Eigen::Array<double, 8, 1>;
+
+  // delta_q of a joint in a phase, t clamped to [begin, begin + length]:
+  //   tau * (c1 + tau^2 * (c3 + tau * c4)),  tau = t - begin
+  // Summed over the phases this is the profile of calculateSynchronizedValues().
+  struct Phase {
+    Lanes begin;
+    Lanes length;
+    Lanes c1;
+    Lanes c3;
+    Lanes c4;
+  };
 
-  bool calculateDesiredValues(double t, Vector7d* delta_q_d) const;
   void calculateSynchronizedValues();
+  void calculatePhases();
+  Lanes calculateDesiredValues(double t) const;
 
   static constexpr double kDeltaQMotionFinished = 1e-6;
   const Vector7d q_goal_;
@@ -65,7 +124,10 @@ class MotionGenerator {
   Vector7d t_1_sync_;
   Vector7d t_2_sync_;
   Vector7d t_f_sync_;
-  Vector7d q_1_;
+
+  std::array<Phase, 3> phases_;
+  double duration_ = 0.0;
+  bool planned_ = false;
 
   double time_ = 0.0;
 
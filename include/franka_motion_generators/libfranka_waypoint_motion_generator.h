@@ -0,0 +1,190 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <franka/control_types.h>
+#include <franka/duration.h>
+#include <franka/robot_state.h>
+
+/**
+ * Moves through a sequence of joint waypoints without stopping at them. Consecutive waypoints are
+ * joined by straight lines in joint space, and the velocity switches from one line to the next in
+ * a blend around the via point: a smoothstep ramp (zero acceleration at both ends, so position,
+ * velocity and acceleration are continuous and the jerk is bounded) that starts on the incoming
+ * line and ends on the outgoing one, cutting the corner. The motion starts at rest and comes to
+ * rest exactly at the last waypoint. All joints share the line durations and
+ * blend durations, as whole milliseconds chosen so that every joint stays within the velocity,
+ * acceleration and jerk limits (those of MotionGenerator, scaled by speed_factor). From rest to
+ * rest this is the timing of MotionGenerator.
+ *
+ * The schedule is kept in microseconds, so the waypoints ahead can be replaced (replan(),
+ * redirect()) or the motion stopped (stop()) while it runs. Can be used as a libfranka
+ * JointPositions callback or offline through position() and sample().
+ *
+ * Usage:
+ *   WaypointMotionGenerator motion_generator(0.6, {q_1, q_2, q_3});
+ *   motion_generator.plan(robot.readOnce().q_d);  // optional, otherwise on the first callback
+ *   robot.control(motion_generator);
+ */
+class WaypointMotionGenerator {
+ public:
+  using JointGoal = std::array<double, 7>;
+
+  /**
+   * Creates a new WaypointMotionGenerator through the given waypoints.
+   *
+   * @param[in] speed_factor General speed factor in range [0, 1].
+   * @param[in] waypoints Joint positions to pass, the last one is the goal.
+   */
+  WaypointMotionGenerator(double speed_factor, const std::vector<JointGoal>& waypoints);
+
+  /**
+   * Plans the motion from rest at q_start. The first callback replans from its q_d if that
+   * differs from q_start.
+   *
+   * @param[in] q_start Joint positions the motion starts from, e.g. robot.readOnce().q_d.
+   */
+  void plan(const JointGoal& q_start);
+
+  /**
+   * Replaces the waypoints after the first via point whose blend has not started at time_us.
+   * The motion keeps its course to that via point and continues through the new waypoints; with
+   * none it comes to rest at that via point. If the new blend cannot start in time, the corner
+   * moves further along the current line. Allocates, so from the control callback only with few
+   * waypoints.
+   *
+   * @param[in] time_us Time since the start of the motion in microseconds.
+   * @param[in] waypoints New joint positions to pass after the next via point.
+   *
+   * @return False if the motion is already coming to rest at its goal, or if moving the corner
+   * did not get the new blend to start in time; the planned motion is unchanged then.
+   */
+  bool replan(uint64_t time_us, const std::vector<JointGoal>& waypoints);
+
+  /**
+   * Leaves the current line as early as possible after time_us: the next via point moves back
+   * along the line to where its blend can start, and the motion turns there towards the new
+   * waypoints, or comes to rest on the line with none (a stop). Allocates like replan().
+   *
+   * @param[in] time_us Time since the start of the motion in microseconds.
+   * @param[in] waypoints New joint positions to pass, the last one is the new goal.
+   *
+   * @return False if the motion is already coming to rest at its goal, or if the new blend cannot
+   * start in time as for replan(); the planned motion is unchanged then.
+   */
+  bool redirect(uint64_t time_us, const std::vector<JointGoal>& waypoints);
+
+  /**
+   * Comes to rest as early as possible after time_us without leaving the planned path: brakes on
+   * the current line if the stop fits before its via point, otherwise passes that via point as
+   * planned and tries the next line. The last via point is then where the motion rests instead
+   * of a waypoint. Does not allocate, so it can be called from the control callback.
+   *
+   * @param[in] time_us Time since the start of the motion in microseconds.
+   *
+   * @return False if the motion is already coming to rest at its goal.
+   */
+  bool stop(uint64_t time_us);
+
+  /**
+   * @return Whether the motion has been planned.
+   */
+  bool isPlanned() const { return !vias_.empty(); }
+
+  /**
+   * @return Duration of the planned motion in microseconds.
+   */
+  uint64_t duration() const { return vias_.empty() ? 0 : vias_.back().end_us; }
+
+  /**
+   * @return Time of the current callback since the start of the motion in microseconds.
+   */
+  uint64_t time() const { return time_us_; }
+
+  /**
+   * @return Number of waypoints passed (the corner of their blend) or, for the goal, reached at
+   * time_us.
+   */
+  std::size_t reachedWaypoints(uint64_t time_us) const;
+
+  /**
+   * Planned joint positions and velocities at time_us.
+   *
+   * @param[in] time_us Time since the start of the motion in microseconds.
+   * @param[out] q Joint positions.
+   * @param[out] dq Joint velocities, may be nullptr.
+   */
+  void position(uint64_t time_us, Eigen::Matrix<double, 7, 1>* q,
+                Eigen::Matrix<double, 7, 1>* dq = nullptr) const;
+
+  /**
+   * Samples the planned motion for preview or validation before it is executed.
+   *
+   * @param[in] dt_us Time between samples in microseconds, e.g. 1000 for the control rate.
+   * @param[out] positions Joint positions at 0, dt, 2dt, ... up to the first sample at or after
+   * duration() (the goal), one column per sample.
+   */
+  void sample(uint64_t dt_us, Eigen::Matrix<double, 7, Eigen::Dynamic>* positions) const;
+
+  /**
+   * Sends joint position calculations
+   *
+   * @param[in] robot_state Current state of the robot.
+   * @param[in] period Duration of execution.
+   *
+   * @return Joint positions for use inside a control loop.
+   */
+  franka::JointPositions operator()(const franka::RobotState& robot_state, franka::Duration period);
+
+ private:
+  using Vector7d = Eigen::Matrix<double, 7, 1>;
+
+  // Corner between the line into and the line out of a point: before begin_us the position is
+  // q + dq_in * (t - center), after end_us q + dq_out * (t - center), in between the blend
+  //   q + dq_in * (begin - center) + u * (dq_in + u^2 * (c3 + u * c4)),  u = t - begin.
+  // The first via is the start (dq_in 0), the last one the goal (dq_out 0).
+  struct Via {
+    uint64_t center_us{0};
+    uint64_t begin_us{0};
+    uint64_t end_us{0};
+    Vector7d q;
+    Vector7d dq_in;
+    Vector7d dq_out;
+    Vector7d c3;
+    Vector7d c4;
+  };
+
+  // Replaces the vias from index corner on with start (keeping its line in) and the waypoints;
+  // the blend at start begins at earliest_us or later. Returns false and leaves the vias as they
+  // are if moving start along its line for kShiftAttempts does not get there.
+  bool build(std::size_t corner, const Via& start, uint64_t earliest_us,
+             const std::vector<JointGoal>& waypoints);
+  // Blend duration in seconds from dq_in to dq_out, rounded up to an even number of milliseconds
+  double blendDuration(const Vector7d& dq_in, const Vector7d& dq_out) const;
+  // Blend coefficients of via for a blend of blend_us around its center
+  static void setBlend(uint64_t blend_us, Via* via);
+  static void evaluate(const Via& via, uint64_t time_us, Vector7d* q, Vector7d* dq);
+  // First via whose blend has not ended at time_us, the last one once the motion is done
+  std::size_t viaAt(uint64_t time_us) const;
+
+  static constexpr uint64_t kTickUs = 1000;
+  static constexpr double kDeltaQMotionFinished = 1e-6;
+
+  std::vector<JointGoal> waypoints_;
+  std::vector<Via> vias_;
+  Vector7d q_start_;
+  uint64_t time_us_ = 0;
+  std::size_t cursor_ = 0;
+
+  // Limits of MotionGenerator, plus a jerk limit
+  Vector7d dq_max_ = (Vector7d() << 2.0, 2.0, 2.0, 2.0, 2.5, 2.5, 2.5).finished();
+  Vector7d ddq_max_start_ = (Vector7d() << 5, 5, 5, 5, 5, 5, 5).finished();
+  Vector7d ddq_max_goal_ = (Vector7d() << 5, 5, 5, 5, 5, 5, 5).finished();
+  Vector7d dddq_max_ = (Vector7d() << 50, 50, 50, 50, 50, 50, 50).finished();
+};
@@ -0,0 +1,132 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// RobotHW standing in for franka_hw::FrankaHW without a robot. It exposes the same interfaces
+// and handle names (<arm_id>_robot, <arm_id>_model, <arm_id>_joint1..7), so the controllers of
+// this package run unchanged against it, and simulates the arm with SimPandaModel:
+//  - effort commands are integrated through the rigid-body dynamics, with gravity compensated
+//    as on the real robot, the commanded torque saturated and optional viscous joint friction;
+//  - joint position/velocity and Cartesian pose/velocity commands without an effort controller
+//    are tracked exactly, as the robot's motion generators do, Cartesian ones through the
+//    damped pseudo inverse of the Jacobian.
+// Joint positions and velocities are kept within the Panda limits. Gravity, mass and Coriolis
+// terms come from PandaDynamics.
+//
+// Parameters in the robot_hw namespace (franka_control_node.yaml and config/franka_sim.yaml):
+//   arm_id, joint_names                  as for franka_control
+//   sim_initial_joint_positions          default: the home pose of move_to_start
+//   sim_joint_friction                   viscous friction [Nm s/rad], default 0.1 on each joint
+//   sim_substeps                         integration steps per control period, default 1
+//   sim_end_effector_config              end effector exported from Desk (cfg/end-effector.json)
+//   sim_end_effector_mass, sim_end_effector_center_of_mass, sim_end_effector_inertia,
+//   sim_F_T_EE                           end effector as in Desk, override the config file;
+//                                        default: Franka Hand
+#pragma once
+
+#include <array>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <franka/robot_state.h>
+#include <franka_hw/franka_cartesian_command_interface.h>
+#include <franka_hw/franka_model_interface.h>
+#include <franka_hw/franka_state_interface.h>
+#include <hardware_interface/joint_command_interface.h>
+#include <hardware_interface/joint_state_interface.h>
+#include <hardware_interface/robot_hw.h>
+#include <ros/node_handle.h>
+#include <ros/time.h>
+
+#include <panda_dynamics.h>
+#include <pseudo_inversion.h>
+#include <sim_panda_model.h>
+
+namespace franka_interactive_controllers {
+
+class SimFrankaHW : public hardware_interface::RobotHW {
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  using Vector7d = SimPandaModel::Vector7d;
+
+  SimFrankaHW() = default;
+
+  bool init(ros::NodeHandle& root_nh, ros::NodeHandle& robot_hw_nh) override;
+
+  // Publishes the simulated state to the handles.
+  void read(const ros::Time& time, const ros::Duration& period) override;
+  // Applies the active command and advances the simulation by period.
+  void write(const ros::Time& time, const ros::Duration& period) override;
+
+  // Same rules as franka_hw: at most one motion generator interface, optionally combined with
+  // the effort interface, and every joint claimed by one controller only.
+  bool checkForConflict(const std::list<hardware_interface::ControllerInfo>& info) const override;
+  void doSwitch(const std::list<hardware_interface::ControllerInfo>& start_list,
+                const std::list<hardware_interface::ControllerInfo>& stop_list) override;
+
+  // Puts the arm at rest in configuration q.
+  void reset(const Vector7d& q);
+
+  const franka::RobotState& robotState() const { return robot_state_; }
+
+  // True while a running controller claims a command interface.
+  bool commanded() const { return effort_active_ || motion_mode_ != MotionMode::kNone; }
+
+ private:
+  enum class MotionMode {
+    kNone,
+    kJointPosition,
+    kJointVelocity,
+    kCartesianPose,
+    kCartesianVelocity
+  };
+
+  void updateControlMode();
+  void holdCommands();
+  void integrateTorque(double dt);
+  void trackMotion(double dt);
+  Vector7d cartesianToJointVelocity(const Eigen::Matrix<double, 6, 1>& twist) const;
+  void enforceLimits();
+
+  std::string arm_id_{"panda"};
+  std::vector<std::string> joint_names_;
+
+  SimPandaModel model_;
+  PandaDynamics dynamics_;
+  Eigen::Matrix4d F_T_EE_{Eigen::Matrix4d::Identity()};
+  Vector7d friction_{Vector7d::Constant(0.1)};
+  int substeps_{1};
+
+  // Simulated state
+  Vector7d q_{Vector7d::Zero()};
+  Vector7d dq_{Vector7d::Zero()};
+  Vector7d tau_d_{Vector7d::Zero()};
+  double time_{0.0};
+
+  // Interfaces claimed by the running controllers
+  std::map<std::string, std::vector<std::string>> controller_interfaces_;
+  bool effort_active_{false};
+  MotionMode motion_mode_{MotionMode::kNone};
+  DampedPseudoInverse<6, 7> jacobian_pinv_solver_{PseudoInverseMethod::kLDLT, 0.01};
+
+  franka::RobotState robot_state_;
+  std::array<double, 7> effort_command_{};
+  std::array<double, 7> position_command_{};
+  std::array<double, 7> velocity_command_{};
+  std::array<double, 16> pose_command_{};
+  std::array<double, 6> cartesian_velocity_command_{};
+  std::array<double, 2> elbow_command_{};
+
+  hardware_interface::JointStateInterface joint_state_interface_;
+  hardware_interface::EffortJointInterface effort_joint_interface_;
+  hardware_interface::PositionJointInterface position_joint_interface_;
+  hardware_interface::VelocityJointInterface velocity_joint_interface_;
+  franka_hw::FrankaStateInterface franka_state_interface_;
+  franka_hw::FrankaModelInterface franka_model_interface_;
+  franka_hw::FrankaPoseCartesianInterface franka_pose_cartesian_interface_;
+  franka_hw::FrankaVelocityCartesianInterface franka_velocity_cartesian_interface_;
+};
+
+}  // namespace franka_interactive_controllers
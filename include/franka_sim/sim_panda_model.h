@@ -0,0 +1,67 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Rigid-body model of the Panda arm backing SimFrankaHW: PandaKinematics and PandaDynamics behind
+// the franka_hw::ModelBase interface, so the model can stand in for libfranka's behind
+// franka_hw::FrankaModelHandle. The end effector and payload are passed per call like libfranka
+// does, as m_total, F_x_Ctotal and I_total.
+#pragma once
+
+#include <array>
+
+#include <Eigen/Dense>
+#include <franka_hw/franka_model_interface.h>
+
+namespace franka_interactive_controllers {
+
+class SimPandaModel : public franka_hw::ModelBase {
+ public:
+  using Vector7d = Eigen::Matrix<double, 7, 1>;
+  using Matrix7d = Eigen::Matrix<double, 7, 7>;
+  using Jacobian = Eigen::Matrix<double, 6, 7>;
+
+  static constexpr int kLinks = 7;
+
+  // Link frames 1..7 and the flange (index 7) in the base frame.
+  using Frames = std::array<Eigen::Isometry3d, kLinks + 1>;
+  static void linkFrames(const Vector7d& q, Frames* frames);
+
+  // Pose and zero Jacobian of a franka::Frame; F_T_EE and EE_T_K as in franka::RobotState.
+  static Eigen::Isometry3d framePose(franka::Frame frame,
+                                     const Frames& frames,
+                                     const Eigen::Matrix4d& F_T_EE,
+                                     const Eigen::Matrix4d& EE_T_K);
+  static Jacobian frameZeroJacobian(franka::Frame frame,
+                                    const Frames& frames,
+                                    const Eigen::Matrix4d& F_T_EE,
+                                    const Eigen::Matrix4d& EE_T_K);
+
+  // franka_hw::ModelBase
+  std::array<double, 16> pose(franka::Frame frame,
+                              const std::array<double, 7>& q,
+                              const std::array<double, 16>& F_T_EE,
+                              const std::array<double, 16>& EE_T_K) const override;
+  std::array<double, 42> bodyJacobian(franka::Frame frame,
+                                      const std::array<double, 7>& q,
+                                      const std::array<double, 16>& F_T_EE,
+                                      const std::array<double, 16>& EE_T_K) const override;
+  std::array<double, 42> zeroJacobian(franka::Frame frame,
+                                      const std::array<double, 7>& q,
+                                      const std::array<double, 16>& F_T_EE,
+                                      const std::array<double, 16>& EE_T_K) const override;
+  std::array<double, 49> mass(const std::array<double, 7>& q,
+                              const std::array<double, 9>& I_total,
+                              double m_total,
+                              const std::array<double, 3>& F_x_Ctotal) const override;
+  std::array<double, 7> coriolis(const std::array<double, 7>& q,
+                                 const std::array<double, 7>& dq,
+                                 const std::array<double, 9>& I_total,
+                                 double m_total,
+                                 const std::array<double, 3>& F_x_Ctotal) const override;
+  std::array<double, 7> gravity(const std::array<double, 7>& q,
+                                double m_total,
+                                const std::array<double, 3>& F_x_Ctotal,
+                                const std::array<double, 3>& gravity_earth) const override;
+};
+
+}  // namespace franka_interactive_controllers
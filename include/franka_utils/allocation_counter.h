@@ -0,0 +1,68 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Real-time allocation detector for the controllers' update() paths.
+//
+// Build with -DENABLE_RT_ALLOCATION_CHECK=ON and start franka_control with the interposer library
+// preloaded, e.g. LD_PRELOAD=<devel>/lib/libfranka_allocation_counter.so. A controller then arms
+// the counter on the control thread at the end of starting() and reads it back in stopping();
+// any malloc/calloc/realloc/memalign issued by that thread in between is counted and reported.
+// Setting FRANKA_ALLOCATION_COUNTER_ABORT=1 (any non-zero number; 0 or unset only counts) in the
+// environment aborts on the first counted allocation instead, which makes offline runs fail hard.
+// franka_rt_allocation_check runs the controllers against a mock robot with the counter linked
+// in and exits with 1 if any of them allocates.
+//
+// Without the CMake option RealtimeAllocationCheck compiles to no-ops.
+#pragma once
+
+#include <cstddef>
+
+#ifdef FRANKA_INTERACTIVE_CONTROLLERS_ALLOCATION_CHECK
+// Provided by libfranka_allocation_counter.so; weak so that the controllers still load when the
+// interposer is not preloaded.
+extern "C" {
+void franka_allocation_counter_arm() __attribute__((weak));
+void franka_allocation_counter_disarm() __attribute__((weak));
+std::size_t franka_allocation_counter_count() __attribute__((weak));
+}
+#endif
+
+namespace franka_interactive_controllers {
+
+class RealtimeAllocationCheck {
+ public:
+  // True when the check was compiled in and the interposer library is preloaded.
+  static bool available() {
+#ifdef FRANKA_INTERACTIVE_CONTROLLERS_ALLOCATION_CHECK
+    return franka_allocation_counter_arm != nullptr;
+#else
+    return false;
+#endif
+  }
+
+  // Starts counting allocations of the calling thread. Call from starting().
+  void start() {
+#ifdef FRANKA_INTERACTIVE_CONTROLLERS_ALLOCATION_CHECK
+    if (available()) {
+      count_at_start_ = franka_allocation_counter_count();
+      franka_allocation_counter_arm();
+    }
+#endif
+  }
+
+  // Stops counting and returns the number of allocations since start(). Call from stopping().
+  std::size_t stop() {
+#ifdef FRANKA_INTERACTIVE_CONTROLLERS_ALLOCATION_CHECK
+    if (available()) {
+      franka_allocation_counter_disarm();
+      return franka_allocation_counter_count() - count_at_start_;
+    }
+#endif
+    return 0;
+  }
+
+ private:
+  std::size_t count_at_start_{0};
+};
+
+}  // namespace franka_interactive_controllers
@@ -0,0 +1,172 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Per-controller update() timing: compute time (monotonic clock, entry to exit) and jitter of the
+// control period against its nominal value, each kept in an HDR-style histogram, plus a count of
+// ticks over a compute budget. A summary (p50/p99/p99.9/max) is published at a low rate on
+// <controller_ns>/cycle_timing and cleared with the <controller_ns>/reset_cycle_timing service.
+//
+// Usage in a controller:
+//   CycleTimer cycle_timer_;                                     // member
+//   cycle_timer_.init(node_handle, "MyController");              // init()
+//   cycle_timer_.starting();                                     // starting()
+//   CycleTimer::Scope cycle_timing(&cycle_timer_, period);       // first line of update()
+//
+// Optional parameters in the controller namespace:
+//   cycle_timing_budget          compute time budget per tick [s], default 0.0005
+//   cycle_timing_nominal_period  expected control period [s], default 0.001
+//   cycle_timing_publish_rate    summary rate [Hz], default 1.0, 0 disables publishing
+//
+// Given the controller's ModelCache, the summary also holds how often each model quantity was
+// evaluated since the last reset.
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <realtime_tools/realtime_publisher.h>
+#include <ros/node_handle.h>
+#include <ros/time.h>
+#include <std_srvs/Trigger.h>
+
+#include <franka_interactive_controllers/CycleTiming.h>
+
+namespace franka_interactive_controllers {
+
+class ModelCache;
+
+// Log-linear histogram of nanosecond durations: values below 2^kSubBucketBits are exact, above
+// that every power of two is split into 2^kSubBucketBits buckets (~3% relative resolution).
+// Single writer, fixed size, no allocation.
+class LatencyHistogram {
+ public:
+  static constexpr int kSubBucketBits = 5;
+  static constexpr int kSubBuckets = 1 << kSubBucketBits;
+  static constexpr int kMaxShift = 36;  // values up to ~2^41 ns (~36 min)
+  static constexpr int kBuckets = (kMaxShift + 2) * kSubBuckets;
+
+  LatencyHistogram() { clear(); }
+
+  void clear() {
+    counts_.fill(0);
+    total_ = 0;
+    max_ = 0;
+  }
+
+  void record(int64_t value_ns) {
+    const uint64_t value = value_ns > 0 ? static_cast<uint64_t>(value_ns) : 0;
+    ++counts_[bucketIndex(value)];
+    ++total_;
+    if (value > max_) {
+      max_ = value;
+    }
+  }
+
+  uint64_t count() const { return total_; }
+  uint64_t max() const { return max_; }
+
+  // Upper bound of the bucket holding the given quantile (0..1), in ns; 0 if empty.
+  uint64_t percentile(double quantile) const {
+    if (total_ == 0) {
+      return 0;
+    }
+    const uint64_t rank = static_cast<uint64_t>(quantile * static_cast<double>(total_ - 1)) + 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+      seen += counts_[i];
+      if (seen >= rank) {
+        const uint64_t upper = bucketLowerBound(i + 1) - 1;
+        return upper < max_ ? upper : max_;
+      }
+    }
+    return max_;
+  }
+
+  static int bucketIndex(uint64_t value) {
+    if (value < static_cast<uint64_t>(kSubBuckets)) {
+      return static_cast<int>(value);
+    }
+    const int msb = 63 - __builtin_clzll(value);
+    int shift = msb - kSubBucketBits;
+    if (shift > kMaxShift) {
+      return kBuckets - 1;
+    }
+    const int mantissa = static_cast<int>((value >> shift) & (kSubBuckets - 1));
+    return (shift + 1) * kSubBuckets + mantissa;
+  }
+
+  static uint64_t bucketLowerBound(int index) {
+    if (index < kSubBuckets) {
+      return static_cast<uint64_t>(index);
+    }
+    const int shift = index / kSubBuckets - 1;
+    const uint64_t mantissa = static_cast<uint64_t>(index % kSubBuckets);
+    return (static_cast<uint64_t>(kSubBuckets) + mantissa) << shift;
+  }
+
+ private:
+  std::array<uint64_t, kBuckets> counts_;
+  uint64_t total_;
+  uint64_t max_;
+};
+
+class CycleTimer {
+ public:
+  // Times one update() call from construction to destruction.
+  class Scope {
+   public:
+    Scope(CycleTimer* timer, const ros::Duration& period) : timer_(timer) {
+      timer_->begin(period);
+    }
+    ~Scope() { timer_->end(); }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    CycleTimer* timer_;
+  };
+
+  bool init(ros::NodeHandle& node_handle,
+            const std::string& controller_name,
+            ModelCache* model_cache = nullptr);
+
+  // RT: the first period after starting() is not counted as jitter.
+  void starting() { first_tick_ = true; }
+
+  // RT: called at entry and exit of update().
+  void begin(const ros::Duration& period);
+  void end();
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  bool resetCallback(std_srvs::Trigger::Request& request, std_srvs::Trigger::Response& response);
+  void publish();
+
+  std::string controller_name_;
+  ModelCache* model_cache_{nullptr};
+  int64_t budget_ns_{500000};
+  int64_t nominal_period_ns_{1000000};
+  int64_t publish_interval_ns_{1000000000};
+
+  LatencyHistogram compute_histogram_;
+  LatencyHistogram jitter_histogram_;
+  uint64_t overruns_{0};
+  Clock::time_point tick_start_;
+  Clock::time_point last_publish_;
+  bool first_tick_{true};
+
+  // Set by the reset service, applied by the RT thread at the next begin()
+  std::atomic<bool> reset_requested_{false};
+
+  std::unique_ptr<realtime_tools::RealtimePublisher<franka_interactive_controllers::CycleTiming>>
+      publisher_;
+  ros::ServiceServer reset_service_;
+};
+
+}  // namespace franka_interactive_controllers
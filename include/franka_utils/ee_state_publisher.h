@@ -0,0 +1,75 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Publishes the end-effector state straight from a controller's update(), stamped with the time
+// of the control tick:
+//   <controller_ns>/ee_pose    geometry_msgs/PoseStamped    O_T_EE
+//   <controller_ns>/ee_twist   geometry_msgs/TwistStamped   J * dq (zero Jacobian, base frame)
+//   <controller_ns>/ee_wrench  geometry_msgs/WrenchStamped  O_F_ext_hat_K (external wrench)
+// through realtime_tools::RealtimePublisher, so the RT loop never blocks on ROS. This replaces
+// converting the 1 kHz franka_states topic in scripts/franka_to_geometry_messages.py.
+//
+// Usage in a controller:
+//   EndEffectorStatePublisher ee_state_publisher_;                       // member
+//   ee_state_publisher_.init(node_handle, "MyController");               // init()
+//   state_view_.init(..., ... | EndEffectorStatePublisher::kStateFields); // init()
+//   ee_state_publisher_.publish(time, state_view_, &model_cache_);       // end of update()
+//
+// Optional parameters in the controller namespace:
+//   ee_state_publish_decimation  publish every n-th tick, default 0 (disabled), 1 = 1 kHz
+//   ee_state_frame_id            frame_id of the messages, default "panda_link0"
+//   ee_state_legacy_topics       also publish the pose under the names and types of the Python
+//                                converter: /franka_state_controller/O_T_EE (PoseStamped) and
+//                                /franka_state_controller/ee_pose (Pose). Default false, also
+//                                looked up in the parent namespaces (franka_interactive_bringup
+//                                sets it globally with use_python_ee_converter:=false). Turns a
+//                                decimation of 0 into 1, like the converter at 1 kHz.
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <geometry_msgs/Pose.h>
+#include <geometry_msgs/PoseStamped.h>
+#include <geometry_msgs/TwistStamped.h>
+#include <geometry_msgs/WrenchStamped.h>
+#include <realtime_tools/realtime_publisher.h>
+#include <ros/node_handle.h>
+#include <ros/time.h>
+
+#include <model_cache.h>
+#include <robot_state_view.h>
+
+namespace franka_interactive_controllers {
+
+class EndEffectorStatePublisher {
+ public:
+  // Robot state fields publish() reads
+  static constexpr uint32_t kStateFields =
+      RobotStateView::kDq | RobotStateView::kOTEE | RobotStateView::kOFExtHatK;
+
+  bool init(ros::NodeHandle& node_handle, const std::string& controller_name);
+
+  // RT: restarts the decimation so the first tick after starting() publishes.
+  void starting() { ticks_ = 0; }
+
+  // RT: publishes every decimation-th call. The Jacobian is only requested on publishing ticks.
+  void publish(const ros::Time& time, const RobotStateView& state, ModelCache* model_cache);
+
+ private:
+  int decimation_{0};
+  int ticks_{0};
+
+  std::unique_ptr<realtime_tools::RealtimePublisher<geometry_msgs::PoseStamped>> pose_publisher_;
+  std::unique_ptr<realtime_tools::RealtimePublisher<geometry_msgs::TwistStamped>>
+      twist_publisher_;
+  std::unique_ptr<realtime_tools::RealtimePublisher<geometry_msgs::WrenchStamped>>
+      wrench_publisher_;
+  // ee_state_legacy_topics, nullptr otherwise
+  std::unique_ptr<realtime_tools::RealtimePublisher<geometry_msgs::PoseStamped>>
+      legacy_pose_stamped_publisher_;
+  std::unique_ptr<realtime_tools::RealtimePublisher<geometry_msgs::Pose>> legacy_pose_publisher_;
+};
+
+}  // namespace franka_interactive_controllers
@@ -0,0 +1,200 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Bank of per-channel smoothing filters for the quantities a controller changes online (gains,
+// targets, force/PI parameters). All channels live in one set of aligned fixed-size arrays and
+// update(dt) advances every channel in a single branch-free, vectorised pass: each filter mode is
+// evaluated for all channels and blended with 0/1 mode masks.
+//
+// Modes, per channel (time constant T, rate limit r):
+//   kNone         output = target
+//   kFirstOrder   exponential filter, exact discretisation of dy/dt = (x - y) / T
+//   kSecondOrder  critically damped second order with natural frequency 1/T, exact
+//                 discretisation (no overshoot, unconditionally stable)
+//   kRateLimited  the outputs of a group move together along the straight line to their targets,
+//                 scaled so that no channel moves more than r per second. A group holding a gain
+//                 matrix so stays a convex combination of SPD matrices, hence SPD, while moving
+//
+// A channel that comes within kSettleTolerance * (1 + |target|) of its target snaps onto it and
+// comes to rest, so smoothed values become exact (e.g. off-diagonal gains exactly zero) and
+// atRest() tells the caller when a group no longer changes.
+//
+// A controller reserves named groups of channels in init() (addGroup()), configured from the
+// parameters filters/<group>/{mode,time_constant,rate_limit} of its node handle, then every tick
+// writes the group targets, calls update(period) and reads the group outputs.
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <string>
+
+#include <Eigen/Core>
+#include <ros/node_handle.h>
+
+namespace franka_interactive_controllers {
+
+enum class FilterMode { kNone, kFirstOrder, kSecondOrder, kRateLimited };
+
+struct FilterConfig {
+  FilterMode mode{FilterMode::kNone};
+  double time_constant{0.0};  // [s], kFirstOrder and kSecondOrder
+  double rate_limit{0.0};     // [unit/s], kRateLimited
+};
+
+// Reads filters/<group>/{mode,time_constant,rate_limit} (mode: none, first_order, second_order
+// or rate_limited), keeping the values of *config for missing parameters. Returns false and logs
+// on invalid values.
+bool filterConfigFromParam(const ros::NodeHandle& node_handle,
+                           const std::string& controller_name,
+                           const std::string& group,
+                           FilterConfig* config);
+
+template <int N>
+class FilterBank {
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  using Array = Eigen::Array<double, N, 1>;
+  using Segment = Eigen::VectorBlock<Array>;
+  using ConstSegment = const Eigen::VectorBlock<const Array>;
+
+  static constexpr double kSettleTolerance = 1e-6;
+
+  FilterBank() { clear(); }
+
+  void clear() {
+    size_ = 0;
+    value_.setZero();
+    velocity_.setZero();
+    target_.setZero();
+    time_constant_.setZero();
+    rate_limit_.setZero();
+    none_.setOnes();
+    first_order_.setZero();
+    second_order_.setZero();
+    rate_limited_.setZero();
+    omega_.setZero();
+    decay_.setZero();
+    period_ = -1.0;
+    rate_groups_ = 0;
+    filtering_ = false;
+  }
+
+  // Non-RT: reserves count channels with the given config and returns the offset of the group,
+  // or -1 if the bank is full.
+  int addGroup(int count, const FilterConfig& config) {
+    if (count < 0 || size_ + count > N) {
+      return -1;
+    }
+    const int offset = size_;
+    size_ += count;
+    time_constant_.segment(offset, count).setConstant(config.time_constant);
+    rate_limit_.segment(offset, count).setConstant(config.rate_limit);
+    none_.segment(offset, count).setConstant(config.mode == FilterMode::kNone ? 1.0 : 0.0);
+    first_order_.segment(offset, count)
+        .setConstant(config.mode == FilterMode::kFirstOrder ? 1.0 : 0.0);
+    second_order_.segment(offset, count)
+        .setConstant(config.mode == FilterMode::kSecondOrder ? 1.0 : 0.0);
+    rate_limited_.segment(offset, count)
+        .setConstant(config.mode == FilterMode::kRateLimited ? 1.0 : 0.0);
+    if (config.mode == FilterMode::kRateLimited && count > 0) {
+      rate_group_offset_[rate_groups_] = offset;
+      rate_group_count_[rate_groups_] = count;
+      ++rate_groups_;
+    }
+    if (config.mode != FilterMode::kNone) {
+      filtering_ = true;
+    }
+    period_ = -1.0;
+    return offset;
+  }
+
+  int size() const { return size_; }
+
+  // True if any channel actually filters; with all channels kNone update() may be skipped.
+  bool filtering() const { return filtering_; }
+
+  // RT: targets of a group, written before update()
+  Segment target(int offset, int count) { return target_.segment(offset, count); }
+
+  // RT: filtered outputs of a group, valid after update()
+  ConstSegment value(int offset, int count) const { return value_.segment(offset, count); }
+
+  // RT: true if the outputs of a group sit on their targets at rest, so update() leaves them be.
+  bool atRest(int offset, int count) const {
+    return (value_.segment(offset, count) == target_.segment(offset, count)).all() &&
+           (velocity_.segment(offset, count) == 0.0).all();
+  }
+
+  // RT: jumps every channel to its current target, at rest (e.g. from starting()).
+  void settle() {
+    value_ = target_;
+    velocity_.setZero();
+  }
+
+  // RT: advances every channel by dt in one pass.
+  void update(double dt) {
+    if (dt != period_) {
+      // w = 1 / T and exp(-w dt), both 0 for T = 0 (no smoothing)
+      omega_ = (time_constant_ > 0.0).select(time_constant_.max(1e-12).inverse(), 0.0);
+      decay_ = (time_constant_ > 0.0).select((-dt * omega_).exp(), 0.0);
+      period_ = dt;
+    }
+    const Array error = value_ - target_;
+
+    // kFirstOrder
+    const Array first = target_ + decay_ * error;
+
+    // kSecondOrder: e(t) = (e0 + (v0 + w e0) t) exp(-w t)
+    const Array slope = velocity_ + omega_ * error;
+    const Array second = target_ + (error + slope * dt) * decay_;
+    const Array second_velocity = (velocity_ - omega_ * slope * dt) * decay_;
+
+    // kRateLimited: one scale per group, set by its largest error
+    Array rate = target_;
+    for (int group = 0; group < rate_groups_; ++group) {
+      const int offset = rate_group_offset_[group];
+      const int count = rate_group_count_[group];
+      const double largest = error.segment(offset, count).abs().maxCoeff();
+      const double step = rate_limit_[offset] * dt;
+      if (largest > step) {
+        rate.segment(offset, count) =
+            value_.segment(offset, count) - (step / largest) * error.segment(offset, count);
+      }
+    }
+
+    value_ = none_ * target_ + first_order_ * first + second_order_ * second +
+             rate_limited_ * rate;
+    velocity_ = second_order_ * second_velocity;
+
+    // Snap channels that have arrived
+    const auto arrived = (value_ - target_).abs() <= kSettleTolerance * (1.0 + target_.abs()) &&
+                         velocity_.abs() <= kSettleTolerance;
+    value_ = arrived.select(target_, value_);
+    velocity_ = arrived.select(0.0, velocity_);
+  }
+
+ private:
+  Array value_;
+  Array velocity_;
+  Array target_;
+  Array time_constant_;
+  Array rate_limit_;
+  // 0/1 masks selecting the mode of each channel
+  Array none_;
+  Array first_order_;
+  Array second_order_;
+  Array rate_limited_;
+  // 1 / T and exp(-dt / T) for the last dt
+  Array omega_;
+  Array decay_;
+  double period_{-1.0};
+  // kRateLimited groups
+  std::array<int, N> rate_group_offset_{};
+  std::array<int, N> rate_group_count_{};
+  int rate_groups_{0};
+  int size_{0};
+  bool filtering_{false};
+};
+
+}  // namespace franka_interactive_controllers
@@ -0,0 +1,68 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Read-only, memory-mapped view of a flight log written by FlightRecorder (flight_recorder.h).
+// open() validates the header and maps the whole file; afterwards every accessor is a pointer
+// offset into the mapping, so a controller can read samples from update() once the log is open
+// and lock()ed.
+// Fields are looked up by name in the header, independent of the FlightSample of this build.
+//
+// Usage:
+//   FlightLog log;
+//   log.open("demo_000.flight", &error);
+//   const FlightLogField* q = log.field("q");
+//   for (uint64_t i = 0; i < log.size(); ++i) { log.values(i, *q)[0]; ... }
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <flight_recorder.h>
+
+namespace franka_interactive_controllers {
+
+class FlightLog {
+ public:
+  FlightLog() = default;
+  FlightLog(const FlightLog&) = delete;
+  FlightLog& operator=(const FlightLog&) = delete;
+  ~FlightLog() { close(); }
+
+  // Non-RT: maps path, false with a message in *error if it is not a valid flight log.
+  bool open(const std::string& path, std::string* error);
+  void close();
+
+  // Non-RT: faults the whole mapping in and locks it in RAM, so that reading samples from
+  // update() never waits for the disk. Without the rights to lock (RLIMIT_MEMLOCK) the pages are
+  // still faulted in, but may be evicted again; false with a message in *error then.
+  bool lock(std::string* error);
+
+  bool isOpen() const { return data_ != nullptr; }
+  const std::string& path() const { return path_; }
+  const FlightLogHeader& header() const { return *reinterpret_cast<const FlightLogHeader*>(data_); }
+
+  // Complete samples in the log. A log whose recorder did not close it keeps the samples that
+  // reached the file.
+  uint64_t size() const { return size_; }
+
+  // Field called name, nullptr if the log has none.
+  const FlightLogField* field(const char* name) const;
+
+  // RT: raw bytes of sample index.
+  const char* sample(uint64_t index) const {
+    return data_ + header().header_size + index * header().sample_size;
+  }
+
+  // RT: the values of a kFloat64 field of sample index.
+  const double* values(uint64_t index, const FlightLogField& field) const {
+    return reinterpret_cast<const double*>(sample(index) + field.offset);
+  }
+
+ private:
+  std::string path_;
+  const char* data_{nullptr};
+  std::size_t mapped_size_{0};
+  uint64_t size_{0};
+};
+
+}  // namespace franka_interactive_controllers
@@ -0,0 +1,183 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Lossless 1 kHz recording of a controller's state from inside update(). Every tick the controller
+// fills one fixed-layout FlightSample in place in a single-producer single-consumer ring; a writer
+// thread appends the ring to a binary flight log, written through 4 MiB memory-mapped chunks. No
+// serialisation, no TCP and no ROS in the loop, unlike recording the state topics with rosbag.
+//
+// Services in the controller namespace (std_srvs/Trigger):
+//   <controller_ns>/flight_recorder/start    opens <directory>/<prefix>_<date>_<time>_000.flight
+//   <controller_ns>/flight_recorder/segment  continues in the next file (_001, ...) without a gap
+//   <controller_ns>/flight_recorder/stop     flushes and closes the log
+// Logs are exported with
+//   rosrun franka_interactive_controllers flight_log_export <log.flight> <out.csv|out.npy>
+//
+// Usage in a controller:
+//   FlightRecorder flight_recorder_;                                        // member
+//   flight_recorder_.init(node_handle, "MyController");                     // init()
+//   state_view_.init(..., ... | FlightRecorder::kStateFields);              // init()
+//   flight_recorder_.starting();                                            // starting()
+//   if (FlightSample* sample = flight_recorder_.claim(time, period, state_view_)) {
+//     ... fill the controller-specific fields ...
+//     flight_recorder_.commit();                                            // end of update()
+//   }
+//
+// Optional parameters in the controller namespace:
+//   flight_recorder/enabled    advertise the services and allocate the ring, default false
+//   flight_recorder/directory  directory of the logs, default /tmp
+//   flight_recorder/prefix     file name prefix, default the controller name
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <ros/node_handle.h>
+#include <ros/service_server.h>
+#include <ros/time.h>
+#include <std_srvs/Trigger.h>
+
+#include <robot_state_view.h>
+
+namespace franka_interactive_controllers {
+
+// One control tick. Fields a controller does not have stay zero. Matrices are column major, as in
+// franka::RobotState and Eigen.
+struct FlightSample {
+  uint64_t sequence;        // ticks since starting(), consecutive unless samples were dropped
+  double time;              // time passed to update() [s]
+  double period;            // period passed to update() [s]
+  std::array<double, 7> q;
+  std::array<double, 7> dq;
+  std::array<double, 7> tau_J;
+  std::array<double, 7> tau_task;      // task (Cartesian impedance, joint locks) torque
+  std::array<double, 7> tau_coriolis;
+  std::array<double, 7> tau_d;         // commanded torque, after rate saturation
+  std::array<double, 16> O_T_EE;
+  std::array<double, 3> position_d;
+  std::array<double, 4> orientation_d;  // x, y, z, w
+  std::array<double, 36> cartesian_stiffness;
+  std::array<double, 36> cartesian_damping;
+  std::array<double, 49> nullspace_stiffness;
+  std::array<double, 49> nullspace_damping;
+};
+
+// Flight log file: a FlightLogHeader padded to kFlightLogHeaderSize bytes, then sample_count
+// samples of sample_size bytes, little endian. The header lists the fields, so a reader does not
+// depend on the FlightSample it was built with.
+enum class FlightLogType : uint32_t { kUInt64 = 0, kFloat64 = 1 };
+
+struct FlightLogField {
+  char name[24];
+  FlightLogType type;
+  uint32_t count;
+  uint32_t offset;  // in the sample [bytes]
+  uint32_t reserved;
+};
+
+constexpr char kFlightLogMagic[8] = {'F', 'L', 'I', 'G', 'H', 'T', 'L', 'G'};
+constexpr uint32_t kFlightLogVersion = 1;
+constexpr uint32_t kFlightLogHeaderSize = 4096;
+constexpr uint32_t kFlightLogMaxFields = 64;
+
+struct FlightLogHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t header_size;
+  uint32_t sample_size;
+  uint32_t field_count;
+  uint64_t sample_count;     // samples on disk, updated while recording
+  int64_t start_time_ns;     // wall clock at start [ns since epoch]
+  uint32_t segment;          // file index within the recording
+  uint32_t reserved;
+  char controller[64];
+  FlightLogField fields[kFlightLogMaxFields];
+};
+
+static_assert(sizeof(FlightLogHeader) <= kFlightLogHeaderSize, "FlightLogHeader too large");
+
+// Schema of FlightSample as written into the header.
+std::size_t flightSampleFields(std::array<FlightLogField, kFlightLogMaxFields>* fields);
+
+class FlightRecorder {
+ public:
+  // Robot state fields claim() reads
+  static constexpr uint32_t kStateFields = RobotStateView::kQ | RobotStateView::kDq |
+                                           RobotStateView::kTauJ | RobotStateView::kOTEE;
+  // 4 s at 1 kHz
+  static constexpr std::size_t kCapacity = 4096;
+
+  FlightRecorder() = default;
+  FlightRecorder(const FlightRecorder&) = delete;
+  FlightRecorder& operator=(const FlightRecorder&) = delete;
+  ~FlightRecorder();
+
+  bool init(ros::NodeHandle& node_handle, const std::string& controller_name);
+
+  // RT: restarts the tick sequence.
+  void starting() { ticks_ = 0; }
+
+  // RT: the slot of this tick with time, period and the robot state filled in, or nullptr if not
+  // recording or the writer is behind (counted as dropped). Every other field is zeroed. A
+  // non-null slot must be handed over with commit() in the same tick.
+  FlightSample* claim(const ros::Time& time, const ros::Duration& period,
+                      const RobotStateView& state);
+  void commit() { head_.store(claimed_ + 1, std::memory_order_release); }
+
+ private:
+  bool startCallback(std_srvs::Trigger::Request& request, std_srvs::Trigger::Response& response);
+  bool stopCallback(std_srvs::Trigger::Request& request, std_srvs::Trigger::Response& response);
+  bool segmentCallback(std_srvs::Trigger::Request& request,
+                       std_srvs::Trigger::Response& response);
+
+  // Writer side, called with file_mutex_ held
+  bool openFile(std::string* error);
+  void closeFile();
+  void drainRing();
+  bool appendBytes(const char* data, std::size_t size);
+  bool mapChunk(std::size_t index);
+  void writeSampleCount();
+
+  void writerLoop();
+
+  std::string controller_name_;
+  std::string directory_;
+  std::string prefix_;
+
+  std::unique_ptr<FlightSample[]> ring_;
+  std::atomic<uint64_t> head_{0};  // written by the RT thread
+  std::atomic<uint64_t> tail_{0};  // written by the writer thread
+  uint64_t claimed_{0};             // owned by the RT thread
+  uint64_t ticks_{0};               // owned by the RT thread
+  std::atomic<bool> recording_{false};
+  std::atomic<uint64_t> dropped_{0};
+  uint64_t dropped_reported_{0};  // owned by the writer thread
+
+  std::mutex file_mutex_;
+  int file_{-1};
+  std::string path_;
+  std::string stamp_;
+  uint32_t segment_{0};
+  int64_t start_time_ns_{0};
+  uint64_t dropped_at_start_{0};
+  char* chunk_{nullptr};
+  std::size_t chunk_index_{0};
+  std::size_t write_offset_{0};
+  uint64_t sample_count_{0};
+  bool write_failed_{false};
+
+  std::atomic<bool> running_{false};
+  std::thread writer_thread_;
+
+  ros::ServiceServer start_service_;
+  ros::ServiceServer stop_service_;
+  ros::ServiceServer segment_service_;
+};
+
+}  // namespace franka_interactive_controllers
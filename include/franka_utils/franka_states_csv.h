@@ -0,0 +1,92 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Reader for franka_msgs/FrankaState recordings made with
+//   rostopic echo -p /franka_state_controller/franka_states > franka_states.csv
+// for the offline model checks. Array fields are the columns field.<name>0..N-1, scalars
+// field.<name>, the receive time %time [ns].
+//
+// Usage:
+//   FrankaStatesCsv csv;
+//   csv.open("franka_states.csv");
+//   std::vector<size_t> q = csv.columns("q", 7);
+//   while (csv.next()) { csv.value(q[0]); ... }
+#pragma once
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace franka_interactive_controllers {
+
+class FrankaStatesCsv {
+ public:
+  // Reads the header line; false if the file cannot be read.
+  bool open(const std::string& path) {
+    file_.open(path);
+    std::string line;
+    if (!file_ || !std::getline(file_, line)) {
+      return false;
+    }
+    header_ = split(line);
+    return true;
+  }
+
+  // Columns of field.<name>0 .. field.<name><size-1>, or field.<name> for size 0. Empty if one
+  // is missing.
+  std::vector<size_t> columns(const std::string& name, size_t size) const {
+    std::vector<size_t> result;
+    const std::string prefix = name.front() == '%' ? name : "field." + name;
+    for (size_t i = 0; i < std::max<size_t>(size, 1); ++i) {
+      const std::string column_name = size == 0 ? prefix : prefix + std::to_string(i);
+      const auto column = std::find(header_.begin(), header_.end(), column_name);
+      if (column == header_.end()) {
+        return {};
+      }
+      result.push_back(static_cast<size_t>(column - header_.begin()));
+    }
+    return result;
+  }
+
+  // Advances to the next complete line; false at the end of the file.
+  bool next() {
+    std::string line;
+    while (std::getline(file_, line)) {
+      fields_ = split(line);
+      if (fields_.size() == header_.size()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  double value(size_t column) const { return std::stod(fields_[column]); }
+
+  // Values of the given columns in the current line, stored in order (column-major for Eigen
+  // matrices, as the arrays of franka::RobotState).
+  template <class Vector>
+  void values(const std::vector<size_t>& columns, Vector* result) const {
+    for (size_t i = 0; i < columns.size(); ++i) {
+      result->data()[i] = value(columns[i]);
+    }
+  }
+
+ private:
+  static std::vector<std::string> split(const std::string& line) {
+    std::vector<std::string> fields;
+    std::stringstream stream(line);
+    std::string field;
+    while (std::getline(stream, field, ',')) {
+      fields.push_back(field);
+    }
+    return fields;
+  }
+
+  std::ifstream file_;
+  std::vector<std::string> header_;
+  std::vector<std::string> fields_;
+};
+
+}  // namespace franka_interactive_controllers
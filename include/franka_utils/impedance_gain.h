@@ -0,0 +1,146 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Stiffness/damping gain for the impedance torque laws. Gains loaded from YAML or received on the
+// stiffness topics are almost always diagonal, so the structure is detected once on load and
+// operator* then only does the work that structure needs:
+//   kDiagonal       N multiplications
+//   kBlockDiagonal  3x3 translation block + (N-3)x(N-3) rotation block (for N = 6)
+//   kFull           dense NxN product, for arbitrary SPD gains
+// The product is a fixed-size expression evaluated on the stack, so it is safe inside update().
+#pragma once
+
+#include <cmath>
+#include <ostream>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/Eigenvalues>
+
+namespace franka_interactive_controllers {
+
+enum class GainStructure { kDiagonal, kBlockDiagonal, kFull };
+
+inline const char* gainStructureName(GainStructure structure) {
+  switch (structure) {
+    case GainStructure::kDiagonal:
+      return "diagonal";
+    case GainStructure::kBlockDiagonal:
+      return "block-diagonal";
+    case GainStructure::kFull:
+      return "full";
+  }
+  return "unknown";
+}
+
+template <int N>
+class ImpedanceGain {
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  static_assert(N > 3, "ImpedanceGain splits off a 3x3 translational block");
+  static constexpr int kBlock = 3;
+  using VectorType = Eigen::Matrix<double, N, 1>;
+  using MatrixType = Eigen::Matrix<double, N, N>;
+
+  // Identity gain
+  ImpedanceGain()
+      : structure_(GainStructure::kDiagonal),
+        diagonal_(VectorType::Ones()),
+        matrix_(MatrixType::Identity()) {}
+
+  static ImpedanceGain fromDiagonal(const VectorType& diagonal) {
+    ImpedanceGain gain;
+    gain.structure_ = GainStructure::kDiagonal;
+    gain.diagonal_ = diagonal;
+    gain.matrix_ = diagonal.asDiagonal();
+    return gain;
+  }
+
+  // Takes a symmetric gain matrix and keeps the sparsest structure that represents it exactly.
+  static ImpedanceGain fromMatrix(const MatrixType& matrix) {
+    ImpedanceGain gain;
+    gain.diagonal_ = matrix.diagonal();
+    gain.matrix_ = matrix;
+    MatrixType off_diagonal = matrix;
+    off_diagonal.diagonal().setZero();
+    if (off_diagonal.isZero(0.0)) {
+      gain.structure_ = GainStructure::kDiagonal;
+    } else if (off_diagonal.template topRightCorner<kBlock, N - kBlock>().isZero(0.0) &&
+               off_diagonal.template bottomLeftCorner<N - kBlock, kBlock>().isZero(0.0)) {
+      gain.structure_ = GainStructure::kBlockDiagonal;
+    } else {
+      gain.structure_ = GainStructure::kFull;
+    }
+    return gain;
+  }
+
+  // Builds a gain from a parameter list: N values give a diagonal gain, N*N values a row-major
+  // matrix that must be symmetric positive semi-definite. Returns false otherwise.
+  static bool fromVector(const std::vector<double>& values, ImpedanceGain* gain) {
+    if (values.size() == static_cast<size_t>(N)) {
+      *gain = fromDiagonal(Eigen::Map<const VectorType>(values.data()));
+      return true;
+    }
+    if (values.size() != static_cast<size_t>(N * N)) {
+      return false;
+    }
+    MatrixType matrix =
+        Eigen::Map<const Eigen::Matrix<double, N, N, Eigen::RowMajor>>(values.data());
+    if (!matrix.isApprox(matrix.transpose())) {
+      return false;
+    }
+    Eigen::SelfAdjointEigenSolver<MatrixType> eigen_solver(matrix, Eigen::EigenvaluesOnly);
+    if (eigen_solver.eigenvalues().minCoeff() < 0.0) {
+      return false;
+    }
+    *gain = fromMatrix(matrix);
+    return true;
+  }
+
+  // Damping ratio = 1: D = 2 * sqrt(K), with the matrix square root for non-diagonal K.
+  ImpedanceGain criticalDamping() const {
+    if (structure_ == GainStructure::kDiagonal) {
+      return fromDiagonal(2.0 * diagonal_.cwiseMax(0.0).cwiseSqrt());
+    }
+    Eigen::SelfAdjointEigenSolver<MatrixType> eigen_solver(matrix_);
+    return fromMatrix(2.0 * eigen_solver.operatorSqrt());
+  }
+
+  GainStructure structure() const { return structure_; }
+  const VectorType& diagonal() const { return diagonal_; }
+  const MatrixType& matrix() const { return matrix_; }
+
+  template <class Derived>
+  VectorType operator*(const Eigen::MatrixBase<Derived>& x) const {
+    const VectorType x_eval(x);
+    VectorType result;
+    switch (structure_) {
+      case GainStructure::kDiagonal:
+        result = diagonal_.cwiseProduct(x_eval);
+        break;
+      case GainStructure::kBlockDiagonal:
+        result.template head<kBlock>().noalias() =
+            matrix_.template topLeftCorner<kBlock, kBlock>() * x_eval.template head<kBlock>();
+        result.template tail<N - kBlock>().noalias() =
+            matrix_.template bottomRightCorner<N - kBlock, N - kBlock>() *
+            x_eval.template tail<N - kBlock>();
+        break;
+      case GainStructure::kFull:
+        result.noalias() = matrix_ * x_eval;
+        break;
+    }
+    return result;
+  }
+
+  friend std::ostream& operator<<(std::ostream& os, const ImpedanceGain& gain) {
+    return os << "(" << gainStructureName(gain.structure_) << ")" << std::endl << gain.matrix_;
+  }
+
+ private:
+  GainStructure structure_;
+  VectorType diagonal_;
+  MatrixType matrix_;
+};
+
+}  // namespace franka_interactive_controllers
@@ -0,0 +1,40 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Named joint goals from the parameter server, a struct of name: [q1, ..., q7] entries as in
+// config/joint_goals.yaml, each within the Panda joint position limits. Shared by
+// libfranka_motion_server and JointGoalMotionController.
+//
+// Usage:
+//   std::map<std::string, JointGoal> goals;
+//   if (!loadJointGoals(node_handle, "joint_goals", &goals, &error)) { ... }
+#pragma once
+
+#include <array>
+#include <map>
+#include <string>
+
+#include <ros/node_handle.h>
+
+namespace franka_interactive_controllers {
+
+using JointGoal = std::array<double, 7>;
+
+// Panda joint position limits from the Franka Control Interface documentation [rad]
+constexpr JointGoal kJointPositionMin{
+    {-2.8973, -1.7628, -2.8973, -3.0718, -2.8973, -0.0175, -2.8973}};
+constexpr JointGoal kJointPositionMax{{2.8973, 1.7628, 2.8973, -0.0698, 2.8973, 3.7525, 2.8973}};
+
+// True if q is finite and within the joint position limits; otherwise false with the first
+// violation in error.
+bool withinJointLimits(const JointGoal& q, std::string* error);
+
+// Reads the goals from param in the namespace of node_handle. Leaves goals untouched and returns
+// false with a message in error if the parameter is missing or any entry is invalid or outside
+// the joint limits.
+bool loadJointGoals(const ros::NodeHandle& node_handle,
+                    const std::string& param,
+                    std::map<std::string, JointGoal>* goals,
+                    std::string* error);
+
+}  // namespace franka_interactive_controllers
@@ -0,0 +1,150 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Per-tick memo of the model quantities a controller's update() needs. Each quantity is fetched
+// from the FrankaModelHandle (or derived from the Jacobian) the first time it is asked for in a
+// tick and served from the cache for the rest of that tick, so the stages of a torque law share
+// one evaluation and nothing is computed that no stage uses. Every evaluation is counted per
+// quantity; CycleTimer publishes the counts with the cycle timing, which shows which quantities a
+// controller actually touches.
+//
+// Usage in a controller:
+//   ModelCache model_cache_;                                     // member
+//   model_cache_.init(model_handle_.get());                      // init()
+//   model_cache_.setPseudoInverse(method, damping);              // init(), if the pinv is used
+//   cycle_timer_.init(node_handle, name, &model_cache_);         // init()
+//   model_cache_.beginTick();                                    // start of update()
+//   model_cache_.jacobian(), model_cache_.coriolis(), ...        // stages of update()
+// All accessors are RT safe and return references valid until the next beginTick().
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <Eigen/Dense>
+#include <franka_hw/franka_model_interface.h>
+
+#include <pseudo_inversion.h>
+
+namespace franka_interactive_controllers {
+
+class ModelCache {
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  enum Quantity : int {
+    kJacobian = 0,           // zero Jacobian of the end effector frame
+    kJacobianTransposePinv,  // damped pseudo inverse of its transpose
+    kNullspaceProjector,     // I - J^T * pinv(J^T)
+    kGravity,
+    kCoriolis,
+    kMass,
+    kQuantities
+  };
+
+  using Vector7d = Eigen::Matrix<double, 7, 1>;
+  using Matrix7d = Eigen::Matrix<double, 7, 7>;
+  using Jacobian = Eigen::Matrix<double, 6, 7>;
+
+  static const char* quantityName(Quantity quantity) {
+    static const char* const kNames[kQuantities] = {
+        "jacobian", "jacobian_transpose_pinv", "nullspace_projector", "gravity", "coriolis",
+        "mass"};
+    return kNames[quantity];
+  }
+
+  void init(franka_hw::FrankaModelHandle* model_handle) {
+    model_handle_ = model_handle;
+    resetEvaluations();
+  }
+
+  void setPseudoInverse(PseudoInverseMethod method, double damping) {
+    pinv_solver_.setMethod(method);
+    pinv_solver_.setDamping(damping);
+  }
+
+  // RT: forgets the quantities of the previous tick.
+  void beginTick() { cached_ = 0; }
+
+  const Jacobian& jacobian() {
+    if (miss(kJacobian)) {
+      const std::array<double, 42> jacobian_array =
+          model_handle_->getZeroJacobian(franka::Frame::kEndEffector);
+      jacobian_ = Eigen::Map<const Jacobian>(jacobian_array.data());
+    }
+    return jacobian_;
+  }
+
+  const Eigen::Matrix<double, 6, 7>& jacobianTransposePinv() {
+    if (miss(kJacobianTransposePinv)) {
+      pinv_solver_.compute(jacobian().transpose(), jacobian_transpose_pinv_);
+    }
+    return jacobian_transpose_pinv_;
+  }
+
+  const Matrix7d& nullspaceProjector() {
+    if (miss(kNullspaceProjector)) {
+      nullspace_projector_.setIdentity();
+      nullspace_projector_.noalias() -= jacobian().transpose() * jacobianTransposePinv();
+    }
+    return nullspace_projector_;
+  }
+
+  const Vector7d& gravity() {
+    if (miss(kGravity)) {
+      const std::array<double, 7> gravity_array = model_handle_->getGravity();
+      gravity_ = Eigen::Map<const Vector7d>(gravity_array.data());
+    }
+    return gravity_;
+  }
+
+  const Vector7d& coriolis() {
+    if (miss(kCoriolis)) {
+      const std::array<double, 7> coriolis_array = model_handle_->getCoriolis();
+      coriolis_ = Eigen::Map<const Vector7d>(coriolis_array.data());
+    }
+    return coriolis_;
+  }
+
+  const Matrix7d& mass() {
+    if (miss(kMass)) {
+      const std::array<double, 49> mass_array = model_handle_->getMass();
+      mass_ = Eigen::Map<const Matrix7d>(mass_array.data());
+    }
+    return mass_;
+  }
+
+  // Bit (1 << quantity) set for every quantity evaluated in the current tick.
+  uint32_t evaluatedThisTick() const { return cached_; }
+
+  // Number of ticks in which the quantity was evaluated since the last resetEvaluations().
+  uint64_t evaluations(Quantity quantity) const { return evaluations_[quantity]; }
+  void resetEvaluations() { evaluations_.fill(0); }
+
+ private:
+  // True (and the quantity marked as evaluated) if it still has to be computed in this tick.
+  bool miss(Quantity quantity) {
+    const uint32_t bit = 1u << quantity;
+    if ((cached_ & bit) != 0) {
+      return false;
+    }
+    cached_ |= bit;
+    ++evaluations_[quantity];
+    return true;
+  }
+
+  franka_hw::FrankaModelHandle* model_handle_{nullptr};
+  DampedPseudoInverse<7, 6> pinv_solver_;
+
+  uint32_t cached_{0};
+  std::array<uint64_t, kQuantities> evaluations_{};
+
+  Jacobian jacobian_{Jacobian::Zero()};
+  Eigen::Matrix<double, 6, 7> jacobian_transpose_pinv_{Eigen::Matrix<double, 6, 7>::Zero()};
+  Matrix7d nullspace_projector_{Matrix7d::Identity()};
+  Vector7d gravity_{Vector7d::Zero()};
+  Vector7d coriolis_{Vector7d::Zero()};
+  Matrix7d mass_{Matrix7d::Zero()};
+};
+
+}  // namespace franka_interactive_controllers
@@ -0,0 +1,91 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Rigid-body dynamics of the Panda arm without libfranka's model library, for the simulated
+// robot, offline gain tuning and payload-aware compensation. The inertial parameters of the
+// links are those identified in C. Gaz et al., "Dynamic Identification of the Franka Emika Panda
+// Robot With Retrieval of Feasible Parameters Using Penalty-Based Optimization", RA-L 2019 (as
+// shipped in franka_description); the end effector and payload enter as one rigid body fixed to
+// the flange, described like libfranka does by m_total, F_x_Ctotal and I_total.
+//
+//   inverseDynamics()  tau = M(q) ddq + C(q, dq) dq + g(q), recursive Newton-Euler
+//   massMatrix()       M(q), composite rigid body algorithm
+//   coriolisMatrix()   C(q, dq) with C dq the Coriolis/centrifugal torques and dM/dt - 2 C
+//                      skew-symmetric (as needed by passivity-based controllers)
+//   coriolisVector(), gravityVector()
+//
+// All quantities are fixed size; no call allocates. The load is folded into the last link when it
+// is set, so per-call cost does not depend on it.
+//
+// Usage:
+//   PandaDynamics::Load load;
+//   Eigen::Matrix4d F_T_EE;
+//   PandaDynamics::readEndEffectorConfig("cfg/end-effector.json", &load, &F_T_EE);
+//   PandaDynamics dynamics(load);
+//   dynamics.massMatrix(q, &mass);
+#pragma once
+
+#include <array>
+#include <string>
+
+#include <Eigen/Core>
+
+namespace franka_interactive_controllers {
+
+class PandaDynamics {
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  static constexpr int kJoints = 7;
+
+  using Vector7d = Eigen::Matrix<double, kJoints, 1>;
+  using Matrix7d = Eigen::Matrix<double, kJoints, kJoints>;
+
+  // Body fixed to the flange: mass, center of mass and inertia about it, in the flange frame.
+  struct Load {
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    double mass{0.0};
+    Eigen::Vector3d center_of_mass{Eigen::Vector3d::Zero()};
+    Eigen::Matrix3d inertia{Eigen::Matrix3d::Zero()};
+  };
+
+  // Reads an end effector as exported by Desk (see cfg/end-effector.json): mass, centerOfMass,
+  // inertia and transformation (F_T_EE, column-major). Returns false with a message in error if
+  // the file cannot be read or a field is missing.
+  static bool readEndEffectorConfig(const std::string& path,
+                                    Load* load,
+                                    Eigen::Matrix4d* F_T_EE,
+                                    std::string* error = nullptr);
+
+  PandaDynamics();  // no load
+  explicit PandaDynamics(const Load& load);
+
+  void setLoad(const Load& load);
+  const Load& load() const { return load_; }
+
+  // gravity_earth is the gravity vector in the base frame, e.g. (0, 0, -9.81).
+  void inverseDynamics(const Vector7d& q,
+                       const Vector7d& dq,
+                       const Vector7d& ddq,
+                       const Eigen::Vector3d& gravity_earth,
+                       Vector7d* tau) const;
+  void massMatrix(const Vector7d& q, Matrix7d* mass) const;
+  void coriolisMatrix(const Vector7d& q, const Vector7d& dq, Matrix7d* coriolis) const;
+  void coriolisVector(const Vector7d& q, const Vector7d& dq, Vector7d* coriolis) const;
+  void gravityVector(const Vector7d& q,
+                     const Eigen::Vector3d& gravity_earth,
+                     Vector7d* gravity) const;
+
+ private:
+  // Mass, center of mass and inertia about it, in the link frame.
+  struct Body {
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    double mass;
+    Eigen::Vector3d com;
+    Eigen::Matrix3d inertia;
+  };
+
+  Load load_;
+  std::array<Body, kJoints> bodies_;
+};
+
+}  // namespace franka_interactive_controllers
@@ -0,0 +1,323 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Closed-form Panda forward kinematics and zero Jacobian, without libfranka's model library.
+// One pass over the joints yields all link frames, the flange, end effector (F_T_EE) and
+// stiffness (EE_T_K) frames, and the 6x7 zero Jacobian of the end effector, i.e. what
+// O_T_EE and FrankaModelHandle::getZeroJacobian(franka::Frame::kEndEffector) report.
+//
+// The kinematic parameters are a compile-time policy (PandaKinematicParameters by default).
+// Since every twist angle alpha is 0 or +-pi/2, the joint recursion is unrolled at compile time
+// and the alpha rotation reduces to picking and negating columns:
+//   c0' = ct c0 + st u,  c1' = ct u - st c0,  c2' = w,  p' = p + a c0 + d w,
+//   with u = cos(alpha) c1 + sin(alpha) c2 and w = cos(alpha) c2 - sin(alpha) c1,
+// which is about 30 flops per joint instead of a 4x4 matrix product.
+//
+// PandaKinematics<>::computeBatch() runs the same kernel on kLanes configurations at once, each
+// scalar being an Eigen array packet, for offline tools that evaluate many configurations.
+//
+// Usage:
+//   PandaKinematics<>::Result kinematics;
+//   PandaKinematics<>::compute(q, F_T_EE, EE_T_K, &kinematics);
+//   kinematics.O_T_EE, kinematics.zero_jacobian, kinematics.link_frames[i]
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+#include <Eigen/Core>
+
+namespace franka_interactive_controllers {
+
+// Modified DH parameters of the Panda, from the Franka Control Interface documentation. Index i
+// holds a_{i-1}, d_i and alpha_{i-1} of joint i + 1; index 7 is the flange.
+struct PandaKinematicParameters {
+  static constexpr int kJoints = 7;
+
+  static constexpr double a(int i) {
+    constexpr double kA[8] = {0.0, 0.0, 0.0, 0.0825, -0.0825, 0.0, 0.088, 0.0};
+    return kA[i];
+  }
+  static constexpr double d(int i) {
+    constexpr double kD[8] = {0.333, 0.0, 0.316, 0.0, 0.384, 0.0, 0.0, 0.107};
+    return kD[i];
+  }
+  // alpha_{i-1} in multiples of pi/2 (0, 1 or -1)
+  static constexpr int alpha(int i) {
+    constexpr int kAlpha[8] = {0, -1, 1, 1, -1, 1, 1, 0};
+    return kAlpha[i];
+  }
+};
+
+namespace internal {
+
+template <class T>
+inline T kinematicsConstant(double value) {
+  return T::Constant(value);
+}
+template <>
+inline double kinematicsConstant<double>(double value) {
+  return value;
+}
+
+template <class T>
+inline T kinematicsCos(const T& x) {
+  return x.cos();
+}
+template <class T>
+inline T kinematicsSin(const T& x) {
+  return x.sin();
+}
+inline double kinematicsCos(double x) {
+  return std::cos(x);
+}
+inline double kinematicsSin(double x) {
+  return std::sin(x);
+}
+
+// u = cos(alpha) c1 + sin(alpha) c2 and w = cos(alpha) c2 - sin(alpha) c1 for alpha = k pi/2
+template <int Alpha>
+struct AlphaColumns;
+
+template <>
+struct AlphaColumns<0> {
+  template <class T>
+  static T u(const T& c1, const T& /*c2*/) { return c1; }
+  template <class T>
+  static T w(const T& /*c1*/, const T& c2) { return c2; }
+};
+
+template <>
+struct AlphaColumns<1> {
+  template <class T>
+  static T u(const T& /*c1*/, const T& c2) { return c2; }
+  template <class T>
+  static T w(const T& c1, const T& /*c2*/) { return -c1; }
+};
+
+template <>
+struct AlphaColumns<-1> {
+  template <class T>
+  static T u(const T& /*c1*/, const T& c2) { return -c2; }
+  template <class T>
+  static T w(const T& c1, const T& /*c2*/) { return c1; }
+};
+
+// Rigid transform with a column-major rotation r and translation p, scalar T being double or an
+// Eigen array packet holding one value per configuration.
+template <class T>
+struct KinematicFrame {
+  T r[9];
+  T p[3];
+};
+
+// frame = parent * DH(joint I, theta)
+template <class Parameters, int I, class T>
+inline void dhStep(const KinematicFrame<T>& parent,
+                   const T& cos_theta,
+                   const T& sin_theta,
+                   KinematicFrame<T>* frame) {
+  using Alpha = AlphaColumns<Parameters::alpha(I)>;
+  constexpr double kA = Parameters::a(I);
+  constexpr double kD = Parameters::d(I);
+  for (int k = 0; k < 3; ++k) {
+    const T& c0 = parent.r[k];
+    const T u = Alpha::u(parent.r[3 + k], parent.r[6 + k]);
+    const T w = Alpha::w(parent.r[3 + k], parent.r[6 + k]);
+    T p = parent.p[k];
+    if (kA != 0.0) {
+      p += kA * c0;
+    }
+    if (kD != 0.0) {
+      p += kD * w;
+    }
+    frame->r[k] = cos_theta * c0 + sin_theta * u;
+    frame->r[3 + k] = cos_theta * u - sin_theta * c0;
+    frame->r[6 + k] = w;
+    frame->p[k] = p;
+  }
+}
+
+// Unrolls dhStep over joints I..kJoints-1 at compile time
+template <class Parameters, int I, bool Done = (I == Parameters::kJoints)>
+struct JointChain {
+  template <class T>
+  static void run(const T* cos_q, const T* sin_q, KinematicFrame<T>* frames) {
+    dhStep<Parameters, I>(frames[I], cos_q[I], sin_q[I], &frames[I + 1]);
+    JointChain<Parameters, I + 1>::run(cos_q, sin_q, frames);
+  }
+};
+
+template <class Parameters, int I>
+struct JointChain<Parameters, I, true> {
+  template <class T>
+  static void run(const T* /*cos_q*/, const T* /*sin_q*/, KinematicFrame<T>* /*frames*/) {}
+};
+
+// frame = parent * transform, transform a constant column-major 4x4 matrix
+template <class T>
+inline void fixedTransform(const KinematicFrame<T>& parent,
+                           const double* transform,
+                           KinematicFrame<T>* frame) {
+  for (int k = 0; k < 3; ++k) {
+    for (int j = 0; j < 3; ++j) {
+      frame->r[3 * j + k] = transform[4 * j] * parent.r[k] +
+                            transform[4 * j + 1] * parent.r[3 + k] +
+                            transform[4 * j + 2] * parent.r[6 + k];
+    }
+    frame->p[k] = parent.p[k] + transform[12] * parent.r[k] + transform[13] * parent.r[3 + k] +
+                  transform[14] * parent.r[6 + k];
+  }
+}
+
+// Link frames 1..7 (frames[1..7], frames[0] is the base), flange (frames[8]), end effector and
+// stiffness frames, and the zero Jacobian of the end effector, column-major 6x7.
+template <class Parameters, class T>
+inline void pandaKinematicsKernel(const T* q,
+                                  const double* F_T_EE,
+                                  const double* EE_T_K,
+                                  KinematicFrame<T>* frames,
+                                  KinematicFrame<T>* end_effector,
+                                  KinematicFrame<T>* stiffness,
+                                  T* zero_jacobian) {
+  constexpr int kJoints = Parameters::kJoints;
+  T cos_q[kJoints], sin_q[kJoints];
+  for (int i = 0; i < kJoints; ++i) {
+    cos_q[i] = kinematicsCos(q[i]);
+    sin_q[i] = kinematicsSin(q[i]);
+  }
+
+  KinematicFrame<T>& base = frames[0];
+  for (int k = 0; k < 9; ++k) {
+    base.r[k] = kinematicsConstant<T>(k % 4 == 0 ? 1.0 : 0.0);
+  }
+  for (int k = 0; k < 3; ++k) {
+    base.p[k] = kinematicsConstant<T>(0.0);
+  }
+  JointChain<Parameters, 0>::run(cos_q, sin_q, frames);
+
+  // flange: pure translation along z of link 7
+  KinematicFrame<T>& flange = frames[kJoints + 1];
+  for (int k = 0; k < 3; ++k) {
+    flange.r[k] = frames[kJoints].r[k];
+    flange.r[3 + k] = frames[kJoints].r[3 + k];
+    flange.r[6 + k] = frames[kJoints].r[6 + k];
+    flange.p[k] = frames[kJoints].p[k] + Parameters::d(kJoints) * frames[kJoints].r[6 + k];
+  }
+  fixedTransform(flange, F_T_EE, end_effector);
+  fixedTransform(*end_effector, EE_T_K, stiffness);
+
+  // column i: [z_i x (p_EE - o_i); z_i]
+  for (int i = 0; i < kJoints; ++i) {
+    const KinematicFrame<T>& joint = frames[i + 1];
+    const T* z = &joint.r[6];
+    const T dx = end_effector->p[0] - joint.p[0];
+    const T dy = end_effector->p[1] - joint.p[1];
+    const T dz = end_effector->p[2] - joint.p[2];
+    T* column = &zero_jacobian[6 * i];
+    column[0] = z[1] * dz - z[2] * dy;
+    column[1] = z[2] * dx - z[0] * dz;
+    column[2] = z[0] * dy - z[1] * dx;
+    column[3] = z[0];
+    column[4] = z[1];
+    column[5] = z[2];
+  }
+}
+
+}  // namespace internal
+
+template <class Parameters = PandaKinematicParameters>
+class PandaKinematics {
+ public:
+  static constexpr int kJoints = Parameters::kJoints;
+  static constexpr int kLanes = 4;  // configurations per batch step
+
+  using JointVector = Eigen::Matrix<double, kJoints, 1>;
+  using Jacobian = Eigen::Matrix<double, 6, kJoints>;
+
+  struct Result {
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    // Frames of links 1..7 (link_frames[0..6]) and the flange (link_frames[7])
+    std::array<Eigen::Matrix4d, kJoints + 1> link_frames;
+    Eigen::Matrix4d O_T_EE;
+    Eigen::Matrix4d O_T_K;
+    Jacobian zero_jacobian;  // of the end effector frame
+  };
+
+  // F_T_EE and EE_T_K as in franka::RobotState.
+  static void compute(const JointVector& q,
+                      const Eigen::Matrix4d& F_T_EE,
+                      const Eigen::Matrix4d& EE_T_K,
+                      Result* result) {
+    internal::KinematicFrame<double> frames[kJoints + 2];
+    internal::KinematicFrame<double> end_effector, stiffness;
+    internal::pandaKinematicsKernel<Parameters>(q.data(), F_T_EE.data(), EE_T_K.data(), frames,
+                                                &end_effector, &stiffness,
+                                                result->zero_jacobian.data());
+    for (int i = 0; i <= kJoints; ++i) {
+      toMatrix(frames[i + 1], &result->link_frames[i]);
+    }
+    toMatrix(end_effector, &result->O_T_EE);
+    toMatrix(stiffness, &result->O_T_K);
+  }
+
+  // Same for the columns of q (one configuration each); column k of poses and jacobians holds
+  // the column-major O_T_EE and zero Jacobian of configuration k, laid out like the
+  // std::array's of franka::RobotState and FrankaModelHandle. Outputs must have q.cols() columns.
+  template <class QType, class PoseType, class JacobianType>
+  static void computeBatch(const Eigen::MatrixBase<QType>& q,
+                           const Eigen::Matrix4d& F_T_EE,
+                           const Eigen::Matrix4d& EE_T_K,
+                           Eigen::MatrixBase<PoseType>* poses,
+                           Eigen::MatrixBase<JacobianType>* jacobians) {
+    using Packet = Eigen::Array<double, kLanes, 1>;
+    const Eigen::Index count = q.cols();
+    for (Eigen::Index first = 0; first < count; first += kLanes) {
+      const int lanes = static_cast<int>(std::min<Eigen::Index>(kLanes, count - first));
+      Packet q_packet[kJoints];
+      for (int i = 0; i < kJoints; ++i) {
+        for (int lane = 0; lane < kLanes; ++lane) {
+          // the last step repeats its last configuration in unused lanes
+          q_packet[i](lane) = q(i, first + std::min(lane, lanes - 1));
+        }
+      }
+      internal::KinematicFrame<Packet> frames[kJoints + 2];
+      internal::KinematicFrame<Packet> end_effector, stiffness;
+      Packet jacobian[6 * kJoints];
+      internal::pandaKinematicsKernel<Parameters>(q_packet, F_T_EE.data(), EE_T_K.data(), frames,
+                                                  &end_effector, &stiffness, jacobian);
+      for (int lane = 0; lane < lanes; ++lane) {
+        auto pose = poses->derived().col(first + lane);
+        for (int j = 0; j < 3; ++j) {
+          for (int k = 0; k < 3; ++k) {
+            pose(4 * j + k) = end_effector.r[3 * j + k](lane);
+          }
+          pose(4 * j + 3) = 0.0;
+          pose(12 + j) = end_effector.p[j](lane);
+        }
+        pose(15) = 1.0;
+        auto jacobian_column = jacobians->derived().col(first + lane);
+        for (int k = 0; k < 6 * kJoints; ++k) {
+          jacobian_column(k) = jacobian[k](lane);
+        }
+      }
+    }
+  }
+
+ private:
+  static void toMatrix(const internal::KinematicFrame<double>& frame, Eigen::Matrix4d* matrix) {
+    double* data = matrix->data();
+    for (int j = 0; j < 3; ++j) {
+      data[4 * j] = frame.r[3 * j];
+      data[4 * j + 1] = frame.r[3 * j + 1];
+      data[4 * j + 2] = frame.r[3 * j + 2];
+      data[4 * j + 3] = 0.0;
+      data[12 + j] = frame.p[j];
+    }
+    data[15] = 1.0;
+  }
+};
+
+}  // namespace franka_interactive_controllers
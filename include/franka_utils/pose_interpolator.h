@@ -0,0 +1,179 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Resamples a stream of stamped poses (e.g. a 100-200 Hz DS publisher) at the control rate.
+//
+// The subscriber pushes each waypoint with its header stamp; the last kWindow waypoints travel to
+// the RT loop as one snapshot through a TripleBuffer, so the loop never blocks and never sees a
+// half-written window. evaluate() looks at the stream `delay` seconds in the past, which keeps
+// the evaluation time between two received waypoints while data flows, and interpolates
+//   position:    cubic Hermite, tangents from finite differences of the neighbouring waypoints
+//   orientation: SQUAD, reducing to slerp on the first and last segment of the window
+// Past the newest waypoint (late or missing data) the last linear and angular velocity is
+// extrapolated for at most `max_extrapolation` seconds, after which the setpoint holds.
+//
+// delay = 0 and max_extrapolation = 0 reproduce the unfiltered "latest waypoint" behaviour.
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include <Eigen/Dense>
+
+#include <triple_buffer.h>
+
+namespace franka_interactive_controllers {
+
+class PoseInterpolator {
+ public:
+  static constexpr int kWindow = 4;
+
+  struct Waypoint {
+    double stamp{0.0};
+    Eigen::Vector3d position{Eigen::Vector3d::Zero()};
+    Eigen::Quaterniond orientation{Eigen::Quaterniond::Identity()};
+  };
+
+  void configure(double delay, double max_extrapolation) {
+    delay_ = delay;
+    max_extrapolation_ = max_extrapolation;
+  }
+
+  double delay() const { return delay_; }
+  double maxExtrapolation() const { return max_extrapolation_; }
+
+  // Non-RT: drops every waypoint, from init().
+  void reset() { buffer_.reset(Window()); }
+
+  // RT: drops every waypoint without blocking on the subscriber, from starting().
+  void resetFromRT() { buffer_.resetFromRT(); }
+
+  // Non-RT writer: appends a waypoint. Waypoints not newer than the last one are ignored.
+  void push(double stamp, const Eigen::Vector3d& position, const Eigen::Quaterniond& orientation) {
+    buffer_.modify([&](Window& window) {
+      if (window.size > 0 && stamp <= window.waypoints[window.size - 1].stamp) {
+        return;
+      }
+      if (window.size == kWindow) {
+        std::rotate(window.waypoints.begin(), window.waypoints.begin() + 1,
+                    window.waypoints.end());
+        --window.size;
+      }
+      Waypoint& waypoint = window.waypoints[window.size];
+      waypoint.stamp = stamp;
+      waypoint.position = position;
+      waypoint.orientation = orientation.normalized();
+      // Same hemisphere as the previous waypoint so that the interpolation takes the short way
+      if (window.size > 0 && window.waypoints[window.size - 1].orientation.coeffs().dot(
+                                 waypoint.orientation.coeffs()) < 0.0) {
+        waypoint.orientation.coeffs() *= -1.0;
+      }
+      ++window.size;
+    });
+  }
+
+  // RT: setpoint at `time` - delay. Returns false (outputs untouched) while no waypoint has
+  // arrived since the last reset().
+  bool evaluate(double time, Eigen::Vector3d* position, Eigen::Quaterniond* orientation) {
+    const Window& window = buffer_.readFromRT();
+    const int n = window.size;
+    if (n == 0) {
+      return false;
+    }
+    const Waypoint* w = window.waypoints.data();
+    const double t = time - delay_;
+
+    if (n == 1 || t <= w[0].stamp) {
+      *position = w[0].position;
+      *orientation = w[0].orientation;
+      return true;
+    }
+
+    if (t >= w[n - 1].stamp) {
+      // Extrapolate with the velocity of the last segment, limited to max_extrapolation_
+      const Waypoint& a = w[n - 2];
+      const Waypoint& b = w[n - 1];
+      const double dt = std::min(t - b.stamp, max_extrapolation_) / (b.stamp - a.stamp);
+      *position = b.position + dt * (b.position - a.position);
+      *orientation = (exp(dt * log(b.orientation * a.orientation.conjugate())) * b.orientation)
+                         .normalized();
+      return true;
+    }
+
+    int i = 0;
+    while (w[i + 1].stamp <= t) {
+      ++i;
+    }
+    const Waypoint& a = w[i];
+    const Waypoint& b = w[i + 1];
+    const double h = b.stamp - a.stamp;
+    const double s = (t - a.stamp) / h;
+
+    // Cubic Hermite position
+    const Eigen::Vector3d m_a = tangent(w, n, i);
+    const Eigen::Vector3d m_b = tangent(w, n, i + 1);
+    const double s2 = s * s;
+    const double s3 = s2 * s;
+    *position = (2.0 * s3 - 3.0 * s2 + 1.0) * a.position + (s3 - 2.0 * s2 + s) * h * m_a +
+                (-2.0 * s3 + 3.0 * s2) * b.position + (s3 - s2) * h * m_b;
+
+    // SQUAD orientation
+    const Eigen::Quaterniond c_a = squadControl(w, n, i);
+    const Eigen::Quaterniond c_b = squadControl(w, n, i + 1);
+    *orientation = a.orientation.slerp(s, b.orientation)
+                       .slerp(2.0 * s * (1.0 - s), c_a.slerp(s, c_b))
+                       .normalized();
+    return true;
+  }
+
+ private:
+  struct Window {
+    std::array<Waypoint, kWindow> waypoints;
+    int size{0};
+  };
+
+  // Velocity at waypoint i: central difference inside the window, one-sided at its ends
+  static Eigen::Vector3d tangent(const Waypoint* w, int n, int i) {
+    const int lo = std::max(i - 1, 0);
+    const int hi = std::min(i + 1, n - 1);
+    return (w[hi].position - w[lo].position) / (w[hi].stamp - w[lo].stamp);
+  }
+
+  // SQUAD inner control point of waypoint i; the waypoint itself at the ends of the window
+  static Eigen::Quaterniond squadControl(const Waypoint* w, int n, int i) {
+    if (i == 0 || i == n - 1) {
+      return w[i].orientation;
+    }
+    const Eigen::Quaterniond inverse = w[i].orientation.conjugate();
+    const Eigen::Vector3d sum =
+        log(inverse * w[i + 1].orientation) + log(inverse * w[i - 1].orientation);
+    return w[i].orientation * exp(-0.25 * sum);
+  }
+
+  // Rotation vector (angle * axis) of a unit quaternion, taking the short way
+  static Eigen::Vector3d log(const Eigen::Quaterniond& q) {
+    const double sign = q.w() < 0.0 ? -1.0 : 1.0;
+    const Eigen::Vector3d v = sign * q.vec();
+    const double sin_half = v.norm();
+    if (sin_half < 1e-12) {
+      return 2.0 * v;
+    }
+    return (2.0 * std::atan2(sin_half, sign * q.w()) / sin_half) * v;
+  }
+
+  static Eigen::Quaterniond exp(const Eigen::Vector3d& rotation) {
+    const double angle = rotation.norm();
+    if (angle < 1e-12) {
+      return Eigen::Quaterniond(1.0, 0.5 * rotation.x(), 0.5 * rotation.y(), 0.5 * rotation.z())
+          .normalized();
+    }
+    return Eigen::Quaterniond(Eigen::AngleAxisd(angle, rotation / angle));
+  }
+
+  TripleBuffer<Window> buffer_;
+  double delay_{0.01};
+  double max_extrapolation_{0.02};
+};
+
+}  // namespace franka_interactive_controllers
@@ -4,11 +4,19 @@
 // pseudo_inverse() computes the pseudo inverse of matrix M_ using SVD decomposition (can choose
 // between damped and not)
 // returns the pseudo inverted matrix M_pinv_
+//
+// The fixed-size solvers below (DampedPseudoInverse) are the ones to use inside update(): they
+// work on Eigen::Matrix<double, Rows, Cols> so every decomposition lives on the stack and no
+// heap allocation happens per tick.
 
 #pragma once
 
+#include <string>
+
+#include <Eigen/Cholesky>
 #include <Eigen/Core>
 #include <Eigen/LU>
+#include <Eigen/QR>
 #include <Eigen/SVD>
 
 namespace franka_interactive_controllers {
@@ -27,4 +35,159 @@ inline void pseudoInverse(const Eigen::MatrixXd& M_, Eigen::MatrixXd& M_pinv_, b
   M_pinv_ = Eigen::MatrixXd(svd.matrixV() * S_.transpose() * svd.matrixU().transpose());
 }
 
+// Solver used by DampedPseudoInverse, selectable per controller with the
+// "pseudo_inverse_method" rosparam ("svd", "ldlt" or "cod").
+enum class PseudoInverseMethod { kSVD, kLDLT, kCOD };
+
+inline bool pseudoInverseMethodFromString(const std::string& name, PseudoInverseMethod* method) {
+  if (name == "svd") {
+    *method = PseudoInverseMethod::kSVD;
+  } else if (name == "ldlt") {
+    *method = PseudoInverseMethod::kLDLT;
+  } else if (name == "cod") {
+    *method = PseudoInverseMethod::kCOD;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+inline const char* pseudoInverseMethodName(PseudoInverseMethod method) {
+  switch (method) {
+    case PseudoInverseMethod::kSVD:
+      return "svd";
+    case PseudoInverseMethod::kLDLT:
+      return "ldlt";
+    case PseudoInverseMethod::kCOD:
+      return "cod";
+  }
+  return "unknown";
+}
+
+// Damped pseudo inverse M^+ = V S^+ U^T with S^+_ii = s_i / (s_i^2 + lambda^2). Only the
+// min(Rows, Cols) leading columns of U and V take part in the product (thin SVD).
+template <int Rows, int Cols>
+inline void dampedPseudoInverseSVD(const Eigen::Matrix<double, Rows, Cols>& M,
+                                   Eigen::Matrix<double, Cols, Rows>& M_pinv,
+                                   double lambda) {
+  constexpr int kRank = Rows < Cols ? Rows : Cols;
+  Eigen::JacobiSVD<Eigen::Matrix<double, Rows, Cols>> svd(
+      M, Eigen::ComputeFullU | Eigen::ComputeFullV);
+  const auto& sing_vals = svd.singularValues();
+  Eigen::Matrix<double, kRank, 1> sing_vals_inv;
+  for (int i = 0; i < kRank; i++) {
+    sing_vals_inv(i) = sing_vals(i) / (sing_vals(i) * sing_vals(i) + lambda * lambda);
+  }
+  M_pinv.noalias() = svd.matrixV().template leftCols<kRank>() * sing_vals_inv.asDiagonal() *
+                     svd.matrixU().template leftCols<kRank>().transpose();
+}
+
+namespace internal {
+
+// The normal-equation and COD solvers below are written for tall matrices (Rows >= Cols); a wide
+// matrix is handled through pinv(M) = pinv(M^T)^T.
+template <int Rows, int Cols, bool Tall = (Rows >= Cols)>
+struct TallPseudoInverse {
+  static void ldlt(const Eigen::Matrix<double, Rows, Cols>& M,
+                   Eigen::Matrix<double, Cols, Rows>& M_pinv,
+                   double lambda) {
+    Eigen::Matrix<double, Cols, Cols> gram;
+    gram.noalias() = M.transpose() * M;
+    gram.diagonal().array() += lambda * lambda;
+    Eigen::LDLT<Eigen::Matrix<double, Cols, Cols>> ldlt(gram);
+    M_pinv = ldlt.solve(M.transpose());
+  }
+
+  static void cod(const Eigen::Matrix<double, Rows, Cols>& M,
+                  Eigen::Matrix<double, Cols, Rows>& M_pinv,
+                  double lambda) {
+    Eigen::Matrix<double, Rows + Cols, Cols> augmented;
+    augmented.template topRows<Rows>() = M;
+    augmented.template bottomRows<Cols>() = lambda * Eigen::Matrix<double, Cols, Cols>::Identity();
+    Eigen::CompleteOrthogonalDecomposition<Eigen::Matrix<double, Rows + Cols, Cols>> cod(
+        augmented);
+    Eigen::Matrix<double, Cols, Rows + Cols> augmented_pinv = cod.pseudoInverse();
+    M_pinv = augmented_pinv.template leftCols<Rows>();
+  }
+};
+
+template <int Rows, int Cols>
+struct TallPseudoInverse<Rows, Cols, false> {
+  static void ldlt(const Eigen::Matrix<double, Rows, Cols>& M,
+                   Eigen::Matrix<double, Cols, Rows>& M_pinv,
+                   double lambda) {
+    Eigen::Matrix<double, Rows, Cols> M_pinv_transpose;
+    TallPseudoInverse<Cols, Rows>::ldlt(M.transpose(), M_pinv_transpose, lambda);
+    M_pinv = M_pinv_transpose.transpose();
+  }
+
+  static void cod(const Eigen::Matrix<double, Rows, Cols>& M,
+                  Eigen::Matrix<double, Cols, Rows>& M_pinv,
+                  double lambda) {
+    Eigen::Matrix<double, Rows, Cols> M_pinv_transpose;
+    TallPseudoInverse<Cols, Rows>::cod(M.transpose(), M_pinv_transpose, lambda);
+    M_pinv = M_pinv_transpose.transpose();
+  }
+};
+
+}  // namespace internal
+
+// Damped pseudo inverse through the normal equations of the smaller dimension:
+//   tall M: (M^T M + lambda^2 I)^-1 M^T,  wide M: M^T (M M^T + lambda^2 I)^-1.
+// For the 7x6/6x7 Jacobian this is a 6x6 LDLT, the cheapest of the three solvers. Requires
+// lambda > 0 close to singularities.
+template <int Rows, int Cols>
+inline void dampedPseudoInverseLDLT(const Eigen::Matrix<double, Rows, Cols>& M,
+                                    Eigen::Matrix<double, Cols, Rows>& M_pinv,
+                                    double lambda) {
+  internal::TallPseudoInverse<Rows, Cols>::ldlt(M, M_pinv, lambda);
+}
+
+// Damped pseudo inverse from a complete orthogonal decomposition of the augmented tall matrix
+// [M; lambda I] (or of M^T for wide M). With lambda = 0 this is the exact Moore-Penrose inverse,
+// rank revealing and cheaper than the SVD.
+template <int Rows, int Cols>
+inline void dampedPseudoInverseCOD(const Eigen::Matrix<double, Rows, Cols>& M,
+                                   Eigen::Matrix<double, Cols, Rows>& M_pinv,
+                                   double lambda) {
+  internal::TallPseudoInverse<Rows, Cols>::cod(M, M_pinv, lambda);
+}
+
+// Fixed-size damped pseudo inverse with a runtime selectable solver. Typical use in a controller:
+//   DampedPseudoInverse<7, 6> jacobian_transpose_pinv_solver_;   // member, configured in init()
+//   jacobian_transpose_pinv_solver_.compute(jacobian.transpose(), jacobian_transpose_pinv_);
+template <int Rows, int Cols>
+class DampedPseudoInverse {
+ public:
+  using InputType = Eigen::Matrix<double, Rows, Cols>;
+  using OutputType = Eigen::Matrix<double, Cols, Rows>;
+
+  explicit DampedPseudoInverse(PseudoInverseMethod method = PseudoInverseMethod::kSVD,
+                               double lambda = 0.2)
+      : method_(method), lambda_(lambda) {}
+
+  void setMethod(PseudoInverseMethod method) { method_ = method; }
+  void setDamping(double lambda) { lambda_ = lambda; }
+  PseudoInverseMethod method() const { return method_; }
+  double damping() const { return lambda_; }
+
+  void compute(const InputType& M, OutputType& M_pinv) const {
+    switch (method_) {
+      case PseudoInverseMethod::kSVD:
+        dampedPseudoInverseSVD<Rows, Cols>(M, M_pinv, lambda_);
+        break;
+      case PseudoInverseMethod::kLDLT:
+        dampedPseudoInverseLDLT<Rows, Cols>(M, M_pinv, lambda_);
+        break;
+      case PseudoInverseMethod::kCOD:
+        dampedPseudoInverseCOD<Rows, Cols>(M, M_pinv, lambda_);
+        break;
+    }
+  }
+
+ private:
+  PseudoInverseMethod method_;
+  double lambda_;
+};
+
 }  // namespace franka_interactive_controllers
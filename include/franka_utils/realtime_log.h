@@ -0,0 +1,99 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Real-time safe logging for the controllers' update() paths.
+//
+// rosconsole formats, locks and writes to stdout/rosout on the calling thread, which stalls the
+// 1 kHz loop. The RT_LOG_* macros instead printf-format into a preallocated slot of a lock-free
+// ring buffer; a background thread drains the ring and forwards the messages to rosconsole.
+//   RT_LOG_INFO("Joint position error: %f", q_error.norm());
+//   RT_LOG_WARN_THROTTLE(0.5, "tau_task_6: %f", tau_task_[5]);
+// The _THROTTLE variants forward at most one message per period from that call site and report
+// how many were suppressed in between. When the ring is full messages are dropped, never waited
+// for; the drain thread reports the dropped count.
+//
+// Call RealtimeLogger::instance() once from init() so the ring and the drain thread are created
+// outside the control loop.
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+namespace franka_interactive_controllers {
+
+enum class RealtimeLogLevel : uint8_t { kDebug, kInfo, kWarn, kError };
+
+// Per call site state, a function-local static created by the RT_LOG_* macros.
+struct RealtimeLogSite {
+  constexpr RealtimeLogSite(const char* file, int line, double min_period)
+      : file(file), line(line), min_period(min_period) {}
+
+  const char* file;
+  int line;
+  double min_period;                  // [s] between forwarded messages, 0 forwards every call
+  std::atomic<int64_t> next_ns{0};    // steady clock time of the next allowed message
+  std::atomic<uint32_t> suppressed{0};
+};
+
+class RealtimeLogger {
+ public:
+  static constexpr std::size_t kCapacity = 512;  // power of two
+  static constexpr std::size_t kMessageSize = 256;
+
+  static RealtimeLogger& instance();
+
+  RealtimeLogger(const RealtimeLogger&) = delete;
+  RealtimeLogger& operator=(const RealtimeLogger&) = delete;
+
+  // RT safe: never blocks or allocates. Returns false if the message was rate limited or dropped.
+  bool log(RealtimeLogSite* site, RealtimeLogLevel level, const char* format, ...)
+      __attribute__((format(printf, 4, 5)));
+
+  // Messages lost because the ring was full.
+  uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+ private:
+  struct Slot {
+    std::atomic<std::size_t> sequence;
+    RealtimeLogLevel level;
+    uint32_t suppressed;
+    char message[kMessageSize];
+  };
+
+  RealtimeLogger();
+  ~RealtimeLogger();
+
+  void drain();
+  bool forwardNext();
+
+  std::array<Slot, kCapacity> slots_;
+  std::atomic<std::size_t> enqueue_position_{0};
+  std::size_t dequeue_position_{0};  // owned by the drain thread
+  std::atomic<uint64_t> dropped_{0};
+  uint64_t dropped_reported_{0};
+  std::atomic<bool> running_{true};
+  std::thread drain_thread_;
+};
+
+}  // namespace franka_interactive_controllers
+
+#define RT_LOG_SITE_(level, period, ...)                                                       \
+  do {                                                                                         \
+    static ::franka_interactive_controllers::RealtimeLogSite rt_log_site_(__FILE__, __LINE__, \
+                                                                          period);             \
+    ::franka_interactive_controllers::RealtimeLogger::instance().log(                         \
+        &rt_log_site_, ::franka_interactive_controllers::RealtimeLogLevel::level, __VA_ARGS__); \
+  } while (0)
+
+#define RT_LOG_DEBUG(...) RT_LOG_SITE_(kDebug, 0.0, __VA_ARGS__)
+#define RT_LOG_INFO(...) RT_LOG_SITE_(kInfo, 0.0, __VA_ARGS__)
+#define RT_LOG_WARN(...) RT_LOG_SITE_(kWarn, 0.0, __VA_ARGS__)
+#define RT_LOG_ERROR(...) RT_LOG_SITE_(kError, 0.0, __VA_ARGS__)
+
+#define RT_LOG_DEBUG_THROTTLE(period, ...) RT_LOG_SITE_(kDebug, period, __VA_ARGS__)
+#define RT_LOG_INFO_THROTTLE(period, ...) RT_LOG_SITE_(kInfo, period, __VA_ARGS__)
+#define RT_LOG_WARN_THROTTLE(period, ...) RT_LOG_SITE_(kWarn, period, __VA_ARGS__)
+#define RT_LOG_ERROR_THROTTLE(period, ...) RT_LOG_SITE_(kError, period, __VA_ARGS__)
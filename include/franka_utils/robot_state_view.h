@@ -0,0 +1,83 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Read-only, zero-copy view of the franka::RobotState behind a FrankaStateHandle. The handle
+// already returns a reference to the state FrankaHW::read() wrote for this control period; the
+// view keeps that reference for the tick and hands out Eigen maps over the fields instead of
+// copying the whole struct (~2 kB of arrays) into update() every millisecond. FrankaHW writes
+// the state on the control thread before update(), so the view is consistent for the whole tick
+// and every stage of a controller can share it.
+//
+// A controller declares the fields it reads at init(); reading an undeclared field asserts in
+// debug builds, so the declaration stays an accurate list of what update() touches.
+//
+// Usage in a controller:
+//   RobotStateView state_view_;                                            // member
+//   state_view_.init(*state_handle_, RobotStateView::kQ | RobotStateView::kDq);  // init()
+//   state_view_.beginTick();                                               // start of update()
+//   state_view_.q(), state_view_.dq(), ...                                 // stages of update()
+// All accessors are RT safe; the maps are valid until the next beginTick().
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+
+#include <Eigen/Dense>
+#include <franka/robot_state.h>
+#include <franka_hw/franka_state_interface.h>
+
+namespace franka_interactive_controllers {
+
+class RobotStateView {
+ public:
+  enum Field : uint32_t {
+    kQ = 1u << 0,
+    kQD = 1u << 1,
+    kDq = 1u << 2,
+    kDqD = 1u << 3,
+    kTauJ = 1u << 4,
+    kTauJD = 1u << 5,
+    kOTEE = 1u << 6,
+    kOTEED = 1u << 7,
+    kOFExtHatK = 1u << 8,
+  };
+
+  using Vector7dMap = Eigen::Map<const Eigen::Matrix<double, 7, 1>>;
+  using Matrix4dMap = Eigen::Map<const Eigen::Matrix4d>;
+  using Vector6dMap = Eigen::Map<const Eigen::Matrix<double, 6, 1>>;
+
+  void init(const franka_hw::FrankaStateHandle& state_handle, uint32_t fields) {
+    state_handle_ = &state_handle;
+    fields_ = fields;
+    beginTick();
+  }
+
+  // RT: takes the state of the current control period.
+  void beginTick() { state_ = &state_handle_->getRobotState(); }
+
+  Vector7dMap q() const { return Vector7dMap(field(kQ).q.data()); }
+  Vector7dMap qD() const { return Vector7dMap(field(kQD).q_d.data()); }
+  Vector7dMap dq() const { return Vector7dMap(field(kDq).dq.data()); }
+  Vector7dMap dqD() const { return Vector7dMap(field(kDqD).dq_d.data()); }
+  Vector7dMap tauJ() const { return Vector7dMap(field(kTauJ).tau_J.data()); }
+  Vector7dMap tauJD() const { return Vector7dMap(field(kTauJD).tau_J_d.data()); }
+  Matrix4dMap oTEE() const { return Matrix4dMap(field(kOTEE).O_T_EE.data()); }
+  Matrix4dMap oTEED() const { return Matrix4dMap(field(kOTEED).O_T_EE_d.data()); }
+  // Estimated external wrench on the end effector, in the base frame
+  Vector6dMap oFExtHatK() const { return Vector6dMap(field(kOFExtHatK).O_F_ext_hat_K.data()); }
+
+  uint32_t fields() const { return fields_; }
+
+ private:
+  const franka::RobotState& field(Field f) const {
+    assert((fields_ & f) != 0 && "RobotStateView: field not declared at init()");
+    (void)f;
+    return *state_;
+  }
+
+  const franka_hw::FrankaStateHandle* state_handle_{nullptr};
+  const franka::RobotState* state_{nullptr};
+  uint32_t fields_{0};
+};
+
+}  // namespace franka_interactive_controllers
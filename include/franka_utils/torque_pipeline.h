@@ -0,0 +1,123 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Compile-time torque pipeline. A torque law is a type list of stages,
+//   using Torque = TorquePipeline<TaskTorqueStage, NullspaceStage, CoriolisStage,
+//                                 ToolCompensationStage, TorqueRateSaturationStage>;
+//   Torque::compute(context, &tau_d_);
+// and compute() runs them in order on one fixed-size accumulator. Every stage is a struct with
+//   template <class Target>
+//   static void apply(const TorqueContext<Target>& context, Eigen::Matrix<double, 7, 1>* tau);
+// that adds its term to (or, like the saturation, rewrites) tau in place. The stage list is
+// unrolled at compile time, so the law compiles to the same straight-line code as writing the
+// sum by hand: no virtual calls, no heap and no intermediate torque vectors.
+//
+// Stages read their inputs from a TorqueContext built once per tick by the controller. Target is
+// the controller's RT target struct; a stage only requires the target members it reads.
+#pragma once
+
+#include <algorithm>
+
+#include <Eigen/Dense>
+
+#include <model_cache.h>
+#include <robot_state_view.h>
+
+namespace franka_interactive_controllers {
+
+template <class Target>
+struct TorqueContext {
+  const RobotStateView& state;
+  ModelCache& model;
+  const Target& target;
+  // Task space / joint space term computed by the controller for this tick
+  const Eigen::Matrix<double, 7, 1>& tau_task;
+  // Nullspace equilibrium, only read by NullspaceStage
+  const Eigen::Matrix<double, 7, 1>* q_nullspace;
+  // Torque rate limit per tick, only read by TorqueRateSaturationStage
+  double delta_tau_max;
+};
+
+// tau += tau_task
+struct TaskTorqueStage {
+  template <class Target>
+  static void apply(const TorqueContext<Target>& context, Eigen::Matrix<double, 7, 1>* tau) {
+    *tau += context.tau_task;
+  }
+};
+
+// Nullspace PD control projected with the kinematic pseudoinverse:
+// tau += (I - J^T pinv(J^T)) * (K_ns * (q_ns - q) - D_ns * dq)
+// Reads target.nullspace_stiffness and target.nullspace_damping.
+struct NullspaceStage {
+  template <class Target>
+  static void apply(const TorqueContext<Target>& context, Eigen::Matrix<double, 7, 1>* tau) {
+    tau->noalias() +=
+        context.model.nullspaceProjector() *
+        (context.target.nullspace_stiffness * (*context.q_nullspace - context.state.q()) -
+         context.target.nullspace_damping * context.state.dq());
+  }
+};
+
+// tau += C(q, dq) dq
+struct CoriolisStage {
+  template <class Target>
+  static void apply(const TorqueContext<Target>& context, Eigen::Matrix<double, 7, 1>* tau) {
+    *tau += context.model.coriolis();
+  }
+};
+
+// tau -= J^T * F_tool when target.activate_tool_compensation (scoop/camera in scooping task).
+// Reads target.activate_tool_compensation and target.tool_compensation_force.
+struct ToolCompensationStage {
+  template <class Target>
+  static void apply(const TorqueContext<Target>& context, Eigen::Matrix<double, 7, 1>* tau) {
+    if (context.target.activate_tool_compensation) {
+      tau->noalias() -=
+          context.model.jacobian().transpose() * context.target.tool_compensation_force;
+    }
+  }
+};
+
+// Limits the change from the last commanded torque tau_J_d to delta_tau_max per tick, to avoid
+// discontinuities. Belongs at the end of the list.
+struct TorqueRateSaturationStage {
+  template <class Target>
+  static void apply(const TorqueContext<Target>& context, Eigen::Matrix<double, 7, 1>* tau) {
+    const RobotStateView::Vector7dMap tau_J_d =  // NOLINT (readability-identifier-naming)
+        context.state.tauJD();
+    for (int i = 0; i < 7; ++i) {
+      const double difference = (*tau)[i] - tau_J_d[i];
+      (*tau)[i] = tau_J_d[i] + std::max(std::min(difference, context.delta_tau_max),
+                                        -context.delta_tau_max);
+    }
+  }
+};
+
+template <class... Stages>
+struct TorquePipeline;
+
+template <>
+struct TorquePipeline<> {
+  template <class Target>
+  static void run(const TorqueContext<Target>& /*context*/,
+                  Eigen::Matrix<double, 7, 1>* /*tau*/) {}
+};
+
+template <class Stage, class... Rest>
+struct TorquePipeline<Stage, Rest...> {
+  // RT: tau = result of all stages, starting from zero.
+  template <class Target>
+  static void compute(const TorqueContext<Target>& context, Eigen::Matrix<double, 7, 1>* tau) {
+    tau->setZero();
+    run(context, tau);
+  }
+
+  template <class Target>
+  static void run(const TorqueContext<Target>& context, Eigen::Matrix<double, 7, 1>* tau) {
+    Stage::apply(context, tau);
+    TorquePipeline<Rest...>::run(context, tau);
+  }
+};
+
+}  // namespace franka_interactive_controllers
@@ -0,0 +1,97 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Triple buffer handing a value from ROS callbacks to the real-time loop.
+//
+// Writers (subscriber / dynamic reconfigure threads) edit a staging copy under a mutex and publish
+// it by swapping the back buffer with the shared middle slot. The RT thread swaps the middle slot
+// with its front buffer when new data is flagged, so readFromRT() is wait-free, never blocks on a
+// writer and always returns a complete snapshot, never a half-written one.
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+
+namespace franka_interactive_controllers {
+
+template <class T>
+class TripleBuffer {
+ public:
+  TripleBuffer() = default;
+  explicit TripleBuffer(const T& initial) { reset(initial); }
+
+  TripleBuffer(const TripleBuffer&) = delete;
+  TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+  // Overwrites every copy with value and drops any pending update. Takes the writer mutex, so only
+  // call while the RT side is not reading concurrently and before the writers start, from init().
+  void reset(const T& value) {
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    staging_ = value;
+    for (T& buffer : buffers_) {
+      buffer = value;
+    }
+    front_ = 0;
+    back_ = 1;
+    middle_.store(2, std::memory_order_release);
+    reset_requested_.store(false, std::memory_order_relaxed);
+  }
+
+  // Non-RT writers: applies function to the latest written value and publishes the result.
+  // Writers are serialised among themselves; the RT side never takes this mutex.
+  template <class Function>
+  void modify(Function&& function) {
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    if (reset_requested_.exchange(false, std::memory_order_acq_rel)) {
+      staging_ = T();
+    }
+    std::forward<Function>(function)(staging_);
+    buffers_[back_] = staging_;
+    back_ = middle_.exchange(back_ | kDirty, std::memory_order_acq_rel) & kIndexMask;
+  }
+
+  // Non-RT: copy of the latest written value.
+  T readFromNonRT() const {
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    return reset_requested_.load(std::memory_order_acquire) ? T() : staging_;
+  }
+
+  // RT reader (single thread): latest published snapshot, valid until the next call.
+  const T& readFromRT() {
+    if (middle_.load(std::memory_order_relaxed) & kDirty) {
+      front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kIndexMask;
+    }
+    return buffers_[front_];
+  }
+
+  // RT reader: drops any pending update and reads T() until the next one is published; the next
+  // modify() starts from T() instead of the latest written value. Never blocks, for starting().
+  // An update written concurrently may still be based on the value before the reset.
+  void resetFromRT() {
+    if (middle_.load(std::memory_order_relaxed) & kDirty) {
+      front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kIndexMask;
+    }
+    buffers_[front_] = T();
+    reset_requested_.store(true, std::memory_order_release);
+  }
+
+  // RT reader: true if a value was published since the last readFromRT().
+  bool hasNewData() const { return middle_.load(std::memory_order_relaxed) & kDirty; }
+
+ private:
+  static constexpr uint8_t kDirty = 0x4;
+  static constexpr uint8_t kIndexMask = 0x3;
+
+  std::array<T, 3> buffers_;
+  T staging_;
+  mutable std::mutex writer_mutex_;
+  uint8_t front_{0};                 // owned by the reader
+  uint8_t back_{1};                  // owned by the writers
+  std::atomic<uint8_t> middle_{2};  // shared slot index, plus kDirty when unread
+  std::atomic<bool> reset_requested_{false};  // set by resetFromRT(), cleared by modify()
+};
+
+}  // namespace franka_interactive_controllers
@@ -3,17 +3,35 @@ import shlex
 from tkinter import *
 from tkinter import messagebox
 from psutil import Popen
+import rospy
+from franka_interactive_controllers.srv import GripperCommand, GripperCommandRequest
 
 root = Tk()
 root.title("Franka Gripper Control")
 root.geometry("300x75+1000+0")
 
+def gripper_server():
+	# libfranka_gripper_server (gripper_server:=true) if running, else one process per command
+	try:
+		rospy.wait_for_service('/franka_gripper/command', timeout=0.05)
+		return rospy.ServiceProxy('/franka_gripper/command', GripperCommand)
+	except rospy.ROSException:
+		return None
+
 def open():
+	gripper_command = gripper_server()
+	if gripper_command is not None:
+		messagebox.showinfo("Open Gripper", gripper_command(command=GripperCommandRequest.OPEN).message)
+		return
 	node_process = Popen(shlex.split('rosrun franka_interactive_controllers franka_gripper_run_node 1'))
 	messagebox.showinfo("Open Gripper", "Gripper Opened")
 	node_process.terminate()
 
 def close():
+	gripper_command = gripper_server()
+	if gripper_command is not None:
+		messagebox.showinfo("Close Gripper", gripper_command(command=GripperCommandRequest.CLOSE).message)
+		return
 	node_process = Popen(shlex.split('rosrun franka_interactive_controllers franka_gripper_run_node 0'))
 	messagebox.showinfo("Close Gripper", "Gripper Closed")   
 	node_process.terminate()
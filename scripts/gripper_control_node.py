@@ -2,6 +2,7 @@
 
 import rospy
 from std_msgs.msg import Int32
+from franka_interactive_controllers.srv import GripperCommand, GripperCommandRequest
 # from psutil import Popen
 # import shlex
 import subprocess
@@ -11,6 +12,7 @@ class GripperControlNode:
     def __init__(self):
         self.curr_gripper_state = 1 # open, 0 for close
         rospy.init_node('gripper_control_node', anonymous=True)
+        self.gripper_command = None
         rospy.Subscriber('/gripper_command', Int32, self.gripper_control_callback)
         rospy.spin()
 
@@ -22,7 +24,21 @@ class GripperControlNode:
             self.close()
             self.curr_gripper_state = 0
 
+    def gripper_server(self):
+        # libfranka_gripper_server (gripper_server:=true) if running, else one process per command
+        if self.gripper_command is None:
+            try:
+                rospy.wait_for_service('/franka_gripper/command', timeout=0.05)
+                self.gripper_command = rospy.ServiceProxy('/franka_gripper/command', GripperCommand)
+            except rospy.ROSException:
+                pass
+        return self.gripper_command
+
     def open(self):
+        if self.gripper_server() is not None:
+            rospy.loginfo("Opening gripper")
+            rospy.loginfo(self.gripper_command(command=GripperCommandRequest.OPEN).message)
+            return
         # node_process = Popen(shlex.split('rosrun franka_interactive_controllers libfranka_gripper_run 1'))
         process = subprocess.Popen("rosrun franka_interactive_controllers franka_gripper_run_node 1", shell=True)
         rospy.loginfo("Opening gripper")
@@ -30,6 +46,10 @@ class GripperControlNode:
         process.terminate()
 
     def close(self):
+        if self.gripper_server() is not None:
+            rospy.loginfo("Closing gripper")
+            rospy.loginfo(self.gripper_command(command=GripperCommandRequest.CLOSE).message)
+            return
         # node_process = Popen(shlex.split('rosrun franka_interactive_controllers libfranka_gripper_run 0'))
         process = subprocess.Popen("rosrun franka_interactive_controllers franka_gripper_run_node 0", shell=True)
         rospy.loginfo("Closing gripper")
@@ -0,0 +1,153 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Exports a flight log written by FlightRecorder (see franka_utils/flight_recorder.h):
+//   rosrun franka_interactive_controllers flight_log_export <log.flight> <out.csv|out.npy>
+// .csv: one line per sample, columns <field> for scalars and <field>0..N-1 for arrays, as in
+//       rostopic echo -p.
+// .npy: one structured array, load with numpy.load("out.npy") and index by field name,
+//       e.g. log["q"] has shape (samples, 7).
+// The layout is taken from the header of the log, not from the FlightSample of this build.
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <flight_log.h>
+
+namespace {
+
+using franka_interactive_controllers::FlightLogField;
+using franka_interactive_controllers::FlightLogHeader;
+using franka_interactive_controllers::FlightLogType;
+
+bool endsWith(const std::string& text, const std::string& suffix) {
+  return text.size() >= suffix.size() &&
+         text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+std::string fieldName(const FlightLogField& field) {
+  return std::string(field.name, strnlen(field.name, sizeof(field.name)));
+}
+
+void writeCsvHeader(const FlightLogHeader& header, std::ostream& out) {
+  bool first = true;
+  for (uint32_t f = 0; f < header.field_count; ++f) {
+    const FlightLogField& field = header.fields[f];
+    for (uint32_t i = 0; i < field.count; ++i) {
+      out << (first ? "" : ",") << fieldName(field);
+      if (field.count > 1) {
+        out << i;
+      }
+      first = false;
+    }
+  }
+  out << "\n";
+}
+
+void writeCsvSample(const FlightLogHeader& header, const char* sample, std::ostream& out) {
+  char text[32];
+  bool first = true;
+  for (uint32_t f = 0; f < header.field_count; ++f) {
+    const FlightLogField& field = header.fields[f];
+    for (uint32_t i = 0; i < field.count; ++i) {
+      const char* value = sample + field.offset + 8 * i;
+      if (field.type == FlightLogType::kUInt64) {
+        uint64_t integer;
+        std::memcpy(&integer, value, sizeof(integer));
+        std::snprintf(text, sizeof(text), "%llu", static_cast<unsigned long long>(integer));
+      } else {
+        double real;
+        std::memcpy(&real, value, sizeof(real));
+        std::snprintf(text, sizeof(text), "%.17g", real);
+      }
+      out << (first ? "" : ",") << text;
+      first = false;
+    }
+  }
+  out << "\n";
+}
+
+// NPY 1.0 header describing one record per sample; gaps in the sample become unnamed padding.
+std::string npyHeader(const FlightLogHeader& header, uint64_t samples) {
+  std::vector<const FlightLogField*> fields;
+  for (uint32_t f = 0; f < header.field_count; ++f) {
+    fields.push_back(&header.fields[f]);
+  }
+  std::sort(fields.begin(), fields.end(), [](const FlightLogField* a, const FlightLogField* b) {
+    return a->offset < b->offset;
+  });
+
+  std::ostringstream descr;
+  uint32_t offset = 0;
+  for (const FlightLogField* field : fields) {
+    if (field->offset > offset) {
+      descr << "('', '|V" << field->offset - offset << "'), ";
+    }
+    descr << "('" << fieldName(*field) << "', '"
+          << (field->type == FlightLogType::kUInt64 ? "<u8" : "<f8") << "'";
+    if (field->count > 1) {
+      descr << ", (" << field->count << ",)";
+    }
+    descr << "), ";
+    offset = field->offset + 8 * field->count;
+  }
+  if (header.sample_size > offset) {
+    descr << "('', '|V" << header.sample_size - offset << "'), ";
+  }
+
+  std::string dictionary = "{'descr': [" + descr.str() +
+                           "], 'fortran_order': False, 'shape': (" + std::to_string(samples) +
+                           ",), }";
+  // magic (6) + version (2) + length (2) + dictionary + '\n', padded to 64 bytes
+  const std::size_t unpadded = 10 + dictionary.size() + 1;
+  dictionary.append((64 - unpadded % 64) % 64, ' ');
+  dictionary.push_back('\n');
+
+  std::string result("\x93NUMPY\x01\x00", 8);
+  result.push_back(static_cast<char>(dictionary.size() & 0xff));
+  result.push_back(static_cast<char>(dictionary.size() >> 8));
+  return result + dictionary;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 3 || !(endsWith(argv[2], ".csv") || endsWith(argv[2], ".npy"))) {
+    std::cerr << "Usage: " << argv[0] << " <log.flight> <out.csv|out.npy>" << std::endl;
+    return -1;
+  }
+  const bool csv = endsWith(argv[2], ".csv");
+
+  franka_interactive_controllers::FlightLog log;
+  std::string error;
+  if (!log.open(argv[1], &error)) {
+    std::cerr << error << std::endl;
+    return -1;
+  }
+  const FlightLogHeader& header = log.header();
+
+  std::ofstream out(argv[2], std::ios::binary);
+  if (!out) {
+    std::cerr << "Could not write " << argv[2] << std::endl;
+    return -1;
+  }
+  if (csv) {
+    writeCsvHeader(header, out);
+    for (uint64_t i = 0; i < log.size(); ++i) {
+      writeCsvSample(header, log.sample(i), out);
+    }
+  } else {
+    out << npyHeader(header, log.size());
+    out.write(log.sample(0), log.size() * header.sample_size);
+  }
+
+  std::cout << argv[1] << " (" << header.controller << ", segment " << header.segment << "): "
+            << log.size() << " samples written to " << argv[2] << std::endl;
+  return out ? 0 : -1;
+}
@@ -45,6 +45,7 @@ bool CartesianForceController::init(hardware_interface::RobotHW* robot_hw,
         "CartesianForceController: Exception getting model handle from interface: " << ex.what());
     return false;
   }
+  model_cache_.init(model_handle_.get());
 
   auto* state_interface = robot_hw->get<franka_hw::FrankaStateInterface>();
   if (state_interface == nullptr) {
@@ -59,6 +60,7 @@ bool CartesianForceController::init(hardware_interface::RobotHW* robot_hw,
         "CartesianForceController: Exception getting state handle from interface: " << ex.what());
     return false;
   }
+  state_view_.init(*state_handle_, RobotStateView::kTauJ | RobotStateView::kTauJD);
 
   auto* effort_joint_interface = robot_hw->get<hardware_interface::EffortJointInterface>();
   if (effort_joint_interface == nullptr) {
@@ -83,39 +85,55 @@ bool CartesianForceController::init(hardware_interface::RobotHW* robot_hw,
   dynamic_server_desired_mass_param_->setCallback(
       boost::bind(&CartesianForceController::desiredMassParamCallback, this, _1, _2));
 
+  FilterConfig force_parameters_filter;
+  force_parameters_filter.mode = FilterMode::kFirstOrder;
+  force_parameters_filter.time_constant = 1.0;
+  if (!filterConfigFromParam(node_handle, "CartesianForceController", "force_parameters",
+                             &force_parameters_filter)) {
+    return false;
+  }
+  filter_bank_.clear();
+  force_parameters_ = filter_bank_.addGroup(3, force_parameters_filter);
+
+  if (!cycle_timer_.init(node_handle, "CartesianForceController", &model_cache_)) {
+    return false;
+  }
+
   return true;
 }
 
 void CartesianForceController::starting(const ros::Time& /*time*/) {
-  franka::RobotState robot_state = state_handle_->getRobotState();
-  std::array<double, 7> gravity_array = model_handle_->getGravity();
-  Eigen::Map<Eigen::Matrix<double, 7, 1>> tau_measured(robot_state.tau_J.data());
-  Eigen::Map<Eigen::Matrix<double, 7, 1>> gravity(gravity_array.data());
+  cycle_timer_.starting();
+  state_view_.beginTick();
+  model_cache_.beginTick();
   // Bias correction for the current external torque
-  tau_ext_initial_ = tau_measured - gravity;
+  tau_ext_initial_ = state_view_.tauJ() - model_cache_.gravity();
   tau_error_.setZero();
+
+  auto values = filter_bank_.target(force_parameters_, 3);
+  values << desired_mass_, k_p_, k_i_;
+  filter_bank_.settle();
 }
 
 void CartesianForceController::update(const ros::Time& /*time*/, const ros::Duration& period) {
-  franka::RobotState robot_state = state_handle_->getRobotState();
-  std::array<double, 42> jacobian_array =
-      model_handle_->getZeroJacobian(franka::Frame::kEndEffector);
-
-  std::array<double, 7> gravity_array = model_handle_->getGravity();
-  Eigen::Map<Eigen::Matrix<double, 6, 7>> jacobian(jacobian_array.data());
-  Eigen::Map<Eigen::Matrix<double, 7, 1>> tau_measured(robot_state.tau_J.data());
-  Eigen::Map<Eigen::Matrix<double, 7, 1>> tau_J_d(  // NOLINT (readability-identifier-naming)
-      robot_state.tau_J_d.data());
-  Eigen::Map<Eigen::Matrix<double, 7, 1>> gravity(gravity_array.data());
-
-  Eigen::VectorXd tau_d(7), desired_force_torque(6), tau_cmd(7), tau_ext(7);
+  CycleTimer::Scope cycle_timing(&cycle_timer_, period);
+
+  state_view_.beginTick();
+  model_cache_.beginTick();
+
+  const RobotStateView::Vector7dMap tau_measured = state_view_.tauJ();
+  const RobotStateView::Vector7dMap tau_J_d =  // NOLINT (readability-identifier-naming)
+      state_view_.tauJD();
+
+  Eigen::Matrix<double, 7, 1> tau_d, tau_cmd, tau_ext;
+  Eigen::Matrix<double, 6, 1> desired_force_torque;
   
   // TODO: Updated this take a desired force/torque from a WrenchStamped (i.e. output of passive DS controller?)
   desired_force_torque.setZero();
   desired_force_torque(2) = desired_mass_ * -9.81;
 
-  tau_ext = tau_measured - gravity - tau_ext_initial_;
-  tau_d << jacobian.transpose() * desired_force_torque;
+  tau_ext = tau_measured - model_cache_.gravity() - tau_ext_initial_;
+  tau_d << model_cache_.jacobian().transpose() * desired_force_torque;
   tau_error_ = tau_error_ + period.toSec() * (tau_d - tau_ext);
 
   // FF + PI control (PI gains are initially all 0)
@@ -127,9 +145,13 @@ void CartesianForceController::update(const ros::Time& /*time*/, const ros::Dura
   }
 
   // Update signals changed online through dynamic reconfigure
-  desired_mass_ = filter_gain_ * target_mass_ + (1 - filter_gain_) * desired_mass_;
-  k_p_ = filter_gain_ * target_k_p_ + (1 - filter_gain_) * k_p_;
-  k_i_ = filter_gain_ * target_k_i_ + (1 - filter_gain_) * k_i_;
+  auto targets = filter_bank_.target(force_parameters_, 3);
+  targets << target_mass_, target_k_p_, target_k_i_;
+  filter_bank_.update(period.toSec());
+  const auto values = filter_bank_.value(force_parameters_, 3);
+  desired_mass_ = values[0];
+  k_p_ = values[1];
+  k_i_ = values[2];
 }
 
 void CartesianForceController::desiredMassParamCallback(
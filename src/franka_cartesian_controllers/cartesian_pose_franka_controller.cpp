@@ -66,16 +66,23 @@ bool CartesianPoseFrankaController::init(hardware_interface::RobotHW* robot_hard
     return false;
   }
 
+  if (!cycle_timer_.init(node_handle, "CartesianPoseFrankaController")) {
+    return false;
+  }
+
   return true;
 }
 
 void CartesianPoseFrankaController::starting(const ros::Time& /* time */) {
+  cycle_timer_.starting();
   initial_pose_ = cartesian_pose_handle_->getRobotState().O_T_EE_d;
   elapsed_time_ = ros::Duration(0.0);
 }
 
 void CartesianPoseFrankaController::update(const ros::Time& /* time */,
                                             const ros::Duration& period) {
+  CycleTimer::Scope cycle_timing(&cycle_timer_, period);
+
 
   // TODO: Change this code to take a desired pose message stamped
   elapsed_time_ += period;
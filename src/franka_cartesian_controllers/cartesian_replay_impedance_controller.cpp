@@ -0,0 +1,367 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+
+#include <cartesian_replay_impedance_controller.h>
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include <controller_interface/controller_base.h>
+#include <pluginlib/class_list_macros.h>
+#include <ros/ros.h>
+
+namespace franka_interactive_controllers {
+
+void ReplayTargetPolicy::ReplayTrack::pose(uint64_t index,
+                                           Eigen::Vector3d* position,
+                                           Eigen::Quaterniond* orientation) const {
+  const double* values = log.values(index, *this->position);
+  if (this->orientation == nullptr) {
+    const Eigen::Map<const Eigen::Matrix4d> transform(values);
+    *position = transform.topRightCorner<3, 1>();
+    *orientation = Eigen::Quaterniond(transform.topLeftCorner<3, 3>());
+  } else {
+    *position = Eigen::Map<const Eigen::Vector3d>(values);
+    orientation->coeffs() =
+        Eigen::Map<const Eigen::Vector4d>(log.values(index, *this->orientation));
+  }
+  orientation->normalize();
+}
+
+bool ReplayTargetPolicy::init(ros::NodeHandle& node_handle,
+                              const franka_hw::FrankaStateHandle& state_handle,
+                              TripleBuffer<CartesianImpedanceTarget>* /*target_buffer*/) {
+  state_handle_ = &state_handle;
+
+  std::string source("measured");
+  if (!node_handle.getParam("replay_source", source)) {
+    ROS_INFO_STREAM(name() << ": No parameter replay_source, defaulting to: " << source);
+  }
+  if (source != "measured" && source != "desired") {
+    ROS_ERROR_STREAM(name() << ": Invalid replay_source " << source
+                     << " (expected measured or desired), aborting controller init!");
+    return false;
+  }
+  replay_desired_ = source == "desired";
+  if (!node_handle.getParam("replay_max_start_distance", max_start_distance_)) {
+    ROS_INFO_STREAM(name() << ": No parameter replay_max_start_distance, defaulting to: "
+                    << max_start_distance_);
+  }
+  if (!node_handle.getParam("replay_max_start_angle", max_start_angle_)) {
+    ROS_INFO_STREAM(name() << ": No parameter replay_max_start_angle, defaulting to: "
+                    << max_start_angle_);
+  }
+  if (!node_handle.getParam("replay_max_time_scale", max_time_scale_)) {
+    ROS_INFO_STREAM(name() << ": No parameter replay_max_time_scale, defaulting to: "
+                    << max_time_scale_);
+  }
+
+  command_buffer_.reset(ReplayCommand());
+  load_service_ =
+      node_handle.advertiseService("replay/load", &ReplayTargetPolicy::loadCallback, this);
+  start_service_ =
+      node_handle.advertiseService("replay/start", &ReplayTargetPolicy::startCallback, this);
+  stop_service_ =
+      node_handle.advertiseService("replay/stop", &ReplayTargetPolicy::stopCallback, this);
+  seek_service_ =
+      node_handle.advertiseService("replay/seek", &ReplayTargetPolicy::seekCallback, this);
+  return true;
+}
+
+void ReplayTargetPolicy::starting(const Eigen::Vector3d& position,
+                                  const Eigen::Quaterniond& orientation) {
+  position_d_ = position;
+  orientation_d_ = orientation;
+  // A restarted controller holds its pose; the loaded log stays at its position
+  if (command_buffer_.hasNewData()) {
+    applyCommand(command_buffer_.readFromRT());
+  }
+  playing_ = false;
+  rt_playing_.store(false, std::memory_order_release);
+}
+
+const CartesianImpedanceTarget& ReplayTargetPolicy::adjustTarget(
+    const CartesianImpedanceTarget& target) {
+  if (track_ == nullptr || track_->stiffness == nullptr) {
+    return target;
+  }
+  using Matrix6d = Eigen::Matrix<double, 6, 6>;
+  replay_target_ = target;
+  replay_target_.cartesian_stiffness = ImpedanceGain<6>::fromMatrix(
+      Eigen::Map<const Matrix6d>(track_->log.values(cursor_, *track_->stiffness)));
+  replay_target_.cartesian_damping = ImpedanceGain<6>::fromMatrix(
+      Eigen::Map<const Matrix6d>(track_->log.values(cursor_, *track_->damping)));
+  return replay_target_;
+}
+
+void ReplayTargetPolicy::update(const ros::Time& /*time*/,
+                                const ros::Duration& period,
+                                const CartesianImpedanceTarget& /*target*/,
+                                const Eigen::Affine3d& /*transform*/,
+                                Eigen::Vector3d* position_d,
+                                Eigen::Quaterniond* orientation_d) {
+  if (command_buffer_.hasNewData()) {
+    applyCommand(command_buffer_.readFromRT());
+  }
+
+  if (playing_) {
+    replay_time_ += time_scale_ * std::max(period.toSec(), 0.0);
+    if (replay_time_ >= track_->duration) {
+      replay_time_ = track_->duration;
+      playing_ = false;
+    }
+    advance(replay_time_);
+    evaluate(replay_time_, &position_d_, &orientation_d_);
+  }
+  rt_playing_.store(playing_, std::memory_order_relaxed);
+  rt_replay_time_.store(replay_time_, std::memory_order_relaxed);
+
+  *position_d = position_d_;
+  *orientation_d = orientation_d_;
+}
+
+void ReplayTargetPolicy::applyCommand(const ReplayCommand& command) {
+  if (command.track != track_) {
+    track_ = command.track;
+    playing_ = false;
+    replay_time_ = 0.0;
+    cursor_ = 0;
+    rt_generation_.store(track_->generation, std::memory_order_release);
+  }
+  if (command.seek_sequence != seek_sequence_) {
+    seek_sequence_ = command.seek_sequence;
+    replay_time_ = command.seek_time;
+    seek(replay_time_);
+  }
+  if (command.play_sequence != play_sequence_) {
+    play_sequence_ = command.play_sequence;
+    playing_ = command.playing && track_ != nullptr;
+    time_scale_ = command.time_scale;
+    if (playing_ && replay_time_ >= track_->duration) {
+      replay_time_ = 0.0;
+      cursor_ = 0;
+    }
+  }
+}
+
+void ReplayTargetPolicy::seek(double time) {
+  // Last sample at or before time
+  uint64_t low = 0;
+  uint64_t high = track_->log.size();
+  while (high - low > 1) {
+    const uint64_t middle = low + (high - low) / 2;
+    (track_->sampleTime(middle) <= time ? low : high) = middle;
+  }
+  cursor_ = low;
+}
+
+void ReplayTargetPolicy::advance(double time) {
+  const uint64_t last = track_->log.size() - 1;
+  while (cursor_ < last && track_->sampleTime(cursor_ + 1) <= time) {
+    ++cursor_;
+  }
+}
+
+void ReplayTargetPolicy::evaluate(double time,
+                                  Eigen::Vector3d* position,
+                                  Eigen::Quaterniond* orientation) const {
+  track_->pose(cursor_, position, orientation);
+  if (cursor_ + 1 >= track_->log.size()) {
+    return;
+  }
+  const double start = track_->sampleTime(cursor_);
+  const double span = track_->sampleTime(cursor_ + 1) - start;
+  const double fraction = span > 0.0 ? std::min(std::max((time - start) / span, 0.0), 1.0) : 0.0;
+  if (fraction == 0.0) {
+    return;
+  }
+  Eigen::Vector3d next_position;
+  Eigen::Quaterniond next_orientation;
+  track_->pose(cursor_ + 1, &next_position, &next_orientation);
+  *position += fraction * (next_position - *position);
+  *orientation = orientation->slerp(fraction, next_orientation);
+}
+
+bool ReplayTargetPolicy::loadCallback(ReplayLoad::Request& request,
+                                      ReplayLoad::Response& response) {
+  auto track = std::make_unique<ReplayTrack>();
+  std::string error;
+  if (!track->log.open(request.path, &error)) {
+    response.success = false;
+    response.message = error;
+    return true;
+  }
+  track->time = track->log.field("time");
+  if (replay_desired_) {
+    track->position = track->log.field("position_d");
+    track->orientation = track->log.field("orientation_d");
+  } else {
+    track->position = track->log.field("O_T_EE");
+  }
+  if (request.use_recorded_gains) {
+    track->stiffness = track->log.field("cartesian_stiffness");
+    track->damping = track->log.field("cartesian_damping");
+  }
+  const auto has = [](const FlightLogField* field, uint32_t count) {
+    return field != nullptr && field->type == FlightLogType::kFloat64 && field->count == count;
+  };
+  if (!has(track->time, 1) || !has(track->position, replay_desired_ ? 3 : 16) ||
+      (replay_desired_ && !has(track->orientation, 4)) ||
+      (request.use_recorded_gains &&
+       (!has(track->stiffness, 36) || !has(track->damping, 36)))) {
+    response.success = false;
+    response.message = request.path + " lacks the fields to replay";
+    return true;
+  }
+  if (track->log.size() == 0) {
+    response.success = false;
+    response.message = request.path + " has no samples";
+    return true;
+  }
+  // update() reads the samples from the mapping, which must not fault on the control thread
+  if (!track->log.lock(&error)) {
+    ROS_WARN_STREAM(name() << ": " << error << ", replaying from the page cache");
+  }
+  if (request.use_recorded_gains &&
+      Eigen::Map<const Eigen::Matrix<double, 36, 1>>(track->log.values(0, *track->stiffness))
+          .isZero(0.0)) {
+    response.success = false;
+    response.message = request.path + " holds no gains (recorded by a controller without "
+                       "Cartesian impedance?)";
+    return true;
+  }
+  track->start_time = track->log.values(0, *track->time)[0];
+  track->duration = track->sampleTime(track->log.size() - 1);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  track->generation = ++generation_;
+  const ReplayTrack* loaded = track.get();
+  // Unmap the logs update() no longer reads
+  const uint64_t in_use = rt_generation_.load(std::memory_order_acquire);
+  tracks_.erase(std::remove_if(tracks_.begin(), tracks_.end(),
+                               [in_use](const std::unique_ptr<ReplayTrack>& old) {
+                                 return old->generation < in_use;
+                               }),
+                tracks_.end());
+  tracks_.push_back(std::move(track));
+  command_buffer_.modify([loaded](ReplayCommand& command) {
+    command.track = loaded;
+    command.playing = false;
+    ++command.play_sequence;
+  });
+
+  response.success = true;
+  response.samples = loaded->log.size();
+  response.duration = loaded->duration;
+  response.message = "Loaded " + request.path;
+  ROS_INFO_STREAM(name() << ": Loaded " << request.path << " for replay, " << loaded->log.size()
+                  << " samples, " << loaded->duration << " s");
+  return true;
+}
+
+bool ReplayTargetPolicy::startCallback(ReplayStart::Request& request,
+                                       ReplayStart::Response& response) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (tracks_.empty()) {
+    response.success = false;
+    response.message = "No log loaded";
+    return true;
+  }
+  if (!std::isfinite(request.time_scale) || request.time_scale <= 0.0) {
+    response.success = false;
+    response.message = "time_scale must be finite and > 0";
+    return true;
+  }
+  double time_scale = request.time_scale;
+  if (max_time_scale_ > 0.0 && time_scale > max_time_scale_) {
+    time_scale = max_time_scale_;
+  }
+  const ReplayTrack& track = *tracks_.back();
+
+  // First setpoint of the replay against the current end-effector pose
+  double replay_time = rt_replay_time_.load(std::memory_order_relaxed);
+  if (rt_generation_.load(std::memory_order_acquire) != track.generation ||
+      replay_time >= track.duration) {
+    replay_time = 0.0;
+  }
+  uint64_t index = 0;
+  while (index + 1 < track.log.size() && track.sampleTime(index + 1) <= replay_time) {
+    ++index;
+  }
+  Eigen::Vector3d position;
+  Eigen::Quaterniond orientation;
+  track.pose(index, &position, &orientation);
+  const Eigen::Affine3d current(
+      Eigen::Matrix4d::Map(state_handle_->getRobotState().O_T_EE.data()));
+  const double distance = (position - current.translation()).norm();
+  if (max_start_distance_ > 0.0 && distance > max_start_distance_) {
+    response.success = false;
+    response.message = "Replay starts " + std::to_string(distance) +
+                       " m from the current pose (replay_max_start_distance " +
+                       std::to_string(max_start_distance_) + " m)";
+    return true;
+  }
+  const double angle = orientation.angularDistance(Eigen::Quaterniond(current.linear()));
+  if (max_start_angle_ > 0.0 && angle > max_start_angle_) {
+    response.success = false;
+    response.message = "Replay starts " + std::to_string(angle) +
+                       " rad from the current orientation (replay_max_start_angle " +
+                       std::to_string(max_start_angle_) + " rad)";
+    return true;
+  }
+
+  command_buffer_.modify([time_scale](ReplayCommand& command) {
+    command.playing = true;
+    command.time_scale = time_scale;
+    ++command.play_sequence;
+  });
+  response.success = true;
+  response.message = "Replaying " + track.log.path() + " from " + std::to_string(replay_time) +
+                     " s";
+  if (time_scale != request.time_scale) {
+    response.message += " at time_scale " + std::to_string(time_scale) +
+                        " (replay_max_time_scale)";
+  }
+  return true;
+}
+
+bool ReplayTargetPolicy::stopCallback(std_srvs::Trigger::Request& /*request*/,
+                                      std_srvs::Trigger::Response& response) {
+  command_buffer_.modify([](ReplayCommand& command) {
+    command.playing = false;
+    ++command.play_sequence;
+  });
+  response.success = true;
+  response.message =
+      "Stopped at " + std::to_string(rt_replay_time_.load(std::memory_order_relaxed)) + " s";
+  return true;
+}
+
+bool ReplayTargetPolicy::seekCallback(ReplaySeek::Request& request,
+                                      ReplaySeek::Response& response) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (tracks_.empty()) {
+    response.success = false;
+    response.message = "No log loaded";
+    return true;
+  }
+  if (rt_playing_.load(std::memory_order_relaxed)) {
+    response.success = false;
+    response.message = "Stop the replay before seeking";
+    return true;
+  }
+  const double time = std::min(std::max(request.time, 0.0), tracks_.back()->duration);
+  command_buffer_.modify([time](ReplayCommand& command) {
+    command.seek_time = time;
+    ++command.seek_sequence;
+  });
+  response.success = true;
+  response.message = "Replay position " + std::to_string(time) + " s";
+  return true;
+}
+
+}  // namespace franka_interactive_controllers
+
+PLUGINLIB_EXPORT_CLASS(franka_interactive_controllers::CartesianReplayImpedanceController,
+                       controller_interface::ControllerBase)
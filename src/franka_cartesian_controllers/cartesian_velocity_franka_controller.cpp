@@ -67,15 +67,22 @@ bool CartesianVelocityFrankaController::init(hardware_interface::RobotHW* robot_
     return false;
   }
 
+  if (!cycle_timer_.init(node_handle, "CartesianVelocityFrankaController")) {
+    return false;
+  }
+
   return true;
 }
 
 void CartesianVelocityFrankaController::starting(const ros::Time& /* time */) {
+  cycle_timer_.starting();
   elapsed_time_ = ros::Duration(0.0);
 }
 
 void CartesianVelocityFrankaController::update(const ros::Time& /* time */,
                                                 const ros::Duration& period) {
+  CycleTimer::Scope cycle_timing(&cycle_timer_, period);
+
 
   // TODO: Change this code to take a desired pose message stamped
   elapsed_time_ += period;
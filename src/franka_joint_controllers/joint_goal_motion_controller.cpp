@@ -0,0 +1,391 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <joint_goal_motion_controller.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include <controller_interface/controller_base.h>
+#include <hardware_interface/hardware_interface.h>
+#include <pluginlib/class_list_macros.h>
+#include <ros/ros.h>
+
+namespace franka_interactive_controllers {
+
+namespace {
+
+// Lead of a takeover over the clock of update(): the running motion is left at the earliest this
+// far ahead of its last reported time, enough for planning and the handoff
+constexpr uint64_t kTakeOverUs = 20000;
+// How long command() waits for update() to take a motion over [s]
+constexpr double kCommandTimeout = 2.0;
+// Rejected takeovers (the running motion moved on while planning) before giving up
+constexpr int kCommandAttempts = 3;
+// A motion from rest must start at the held setpoint
+constexpr double kMaxStartDeviation = 1e-6;
+constexpr double kFeedbackRate = 50.0;
+// Sampling of a plan for the joint limit check, the control period
+constexpr uint64_t kLimitCheckUs = 1000;
+
+// True if the plan stays within the joint position limits at every control tick. Blends and the
+// corner shifts of a takeover can move it off the straight lines between the goals.
+bool planWithinJointLimits(const WaypointMotionGenerator& generator, std::string* error) {
+  Eigen::Matrix<double, 7, Eigen::Dynamic> positions;
+  generator.sample(kLimitCheckUs, &positions);
+  JointGoal q;
+  for (Eigen::Index k = 0; k < positions.cols(); ++k) {
+    Eigen::Map<Eigen::Matrix<double, 7, 1>>(q.data()) = positions.col(k);
+    if (!withinJointLimits(q, error)) {
+      *error = "The planned motion leaves the joint limits after " +
+               std::to_string(k * kLimitCheckUs * 1e-6) + " s: " + *error;
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // anonymous namespace
+
+bool JointGoalMotionController::init(hardware_interface::RobotHW* robot_hardware,
+                                     ros::NodeHandle& node_handle) {
+  std::string arm_id;
+  if (!node_handle.getParam("arm_id", arm_id)) {
+    ROS_ERROR_STREAM("JointGoalMotionController: Could not read parameter arm_id");
+    return false;
+  }
+  std::vector<std::string> joint_names;
+  if (!node_handle.getParam("joint_names", joint_names) || joint_names.size() != 7) {
+    ROS_ERROR(
+        "JointGoalMotionController: Invalid or no joint_names parameters provided, aborting "
+        "controller init!");
+    return false;
+  }
+
+  auto* position_joint_interface =
+      robot_hardware->get<hardware_interface::PositionJointInterface>();
+  if (position_joint_interface == nullptr) {
+    ROS_ERROR("JointGoalMotionController: Error getting position joint interface from hardware!");
+    return false;
+  }
+  position_joint_handles_.resize(7);
+  for (size_t i = 0; i < 7; ++i) {
+    try {
+      position_joint_handles_[i] = position_joint_interface->getHandle(joint_names[i]);
+    } catch (const hardware_interface::HardwareInterfaceException& ex) {
+      ROS_ERROR_STREAM(
+          "JointGoalMotionController: Exception getting joint handles: " << ex.what());
+      return false;
+    }
+  }
+
+  auto* state_interface = robot_hardware->get<franka_hw::FrankaStateInterface>();
+  if (state_interface == nullptr) {
+    ROS_ERROR_STREAM("JointGoalMotionController: Error getting state interface from hardware");
+    return false;
+  }
+  try {
+    state_handle_ = std::make_unique<franka_hw::FrankaStateHandle>(
+        state_interface->getHandle(arm_id + "_robot"));
+  } catch (hardware_interface::HardwareInterfaceException& ex) {
+    ROS_ERROR_STREAM(
+        "JointGoalMotionController: Exception getting state handle from interface: "
+        << ex.what());
+    return false;
+  }
+
+  if (!node_handle.getParam("speed_factor", default_speed_factor_)) {
+    ROS_INFO_STREAM("JointGoalMotionController: No parameter speed_factor, defaulting to: "
+                    << default_speed_factor_);
+  }
+  if (default_speed_factor_ <= 0.0 || default_speed_factor_ > 1.0) {
+    ROS_ERROR_STREAM("JointGoalMotionController: speed_factor must be in (0, 1], got "
+                     << default_speed_factor_);
+    return false;
+  }
+  std::string error;
+  if (!loadJointGoals(node_handle, "joint_goals", &goals_, &error)) {
+    ROS_WARN_STREAM("JointGoalMotionController: " << error << ", only explicit goals accepted");
+  }
+
+  if (!cycle_timer_.init(node_handle, "JointGoalMotionController")) {
+    return false;
+  }
+
+  command_buffer_.reset(MotionCommand());
+  action_server_ = std::make_unique<ActionServer>(
+      node_handle, "move_to_joint_goal",
+      [this](const MoveToJointGoalGoalConstPtr& goal) { executeCallback(goal); }, false);
+  action_server_->start();
+  return true;
+}
+
+void JointGoalMotionController::starting(const ros::Time& /* time */) {
+  cycle_timer_.starting();
+  // Hold the last commanded joint positions, the motion generator of franka_hw starts there
+  q_hold_ = Vector7d(state_handle_->getRobotState().q_d.data());
+  q_command_ = q_hold_;
+  for (size_t i = 0; i < 7; ++i) {
+    rt_hold_[i].store(q_hold_[i], std::memory_order_relaxed);
+  }
+  motion_ = nullptr;
+  time_us_ = 0;
+  rt_time_us_.store(0, std::memory_order_relaxed);
+  rt_motion_.store(nullptr, std::memory_order_release);
+  rt_activations_.fetch_add(1, std::memory_order_release);
+}
+
+void JointGoalMotionController::stopping(const ros::Time& /* time */) {
+  // Ends a running goal; the motion restarts from rest after the next starting()
+  rt_activations_.fetch_add(1, std::memory_order_release);
+}
+
+void JointGoalMotionController::update(const ros::Time& /*time*/, const ros::Duration& period) {
+  CycleTimer::Scope cycle_timing(&cycle_timer_, period);
+
+  if (motion_ != nullptr) {
+    time_us_ += static_cast<uint64_t>(std::llround(std::max(period.toSec(), 0.0) * 1e6));
+  }
+  if (command_buffer_.hasNewData()) {
+    applyCommand(command_buffer_.readFromRT());
+  }
+
+  if (motion_ != nullptr) {
+    motion_->generator.position(time_us_, &q_command_);
+    if (time_us_ >= motion_->generator.duration()) {
+      q_hold_ = q_command_;
+      for (size_t i = 0; i < 7; ++i) {
+        rt_hold_[i].store(q_hold_[i], std::memory_order_relaxed);
+      }
+      rt_finished_sequence_.store(motion_->sequence, std::memory_order_relaxed);
+      motion_ = nullptr;
+      rt_motion_.store(nullptr, std::memory_order_release);
+    }
+  } else {
+    q_command_ = q_hold_;
+  }
+  rt_time_us_.store(time_us_, std::memory_order_relaxed);
+
+  for (size_t i = 0; i < 7; ++i) {
+    position_joint_handles_[i].setCommand(q_command_[i]);
+  }
+}
+
+void JointGoalMotionController::applyCommand(const MotionCommand& command) {
+  if (command.sequence == command_sequence_) {
+    return;
+  }
+  command_sequence_ = command.sequence;
+
+  bool accepted = false;
+  if (command.base == nullptr) {
+    Vector7d q_start;
+    command.motion->generator.position(0, &q_start);
+    accepted = motion_ == nullptr &&
+               (q_start - q_hold_).cwiseAbs().maxCoeff() <= kMaxStartDeviation;
+    if (accepted) {
+      time_us_ = 0;
+    }
+  } else {
+    // Both motions agree up to switch_until_us, both run on the same clock
+    accepted = motion_ == command.base && time_us_ <= command.switch_until_us;
+  }
+  if (accepted) {
+    motion_ = command.motion;
+    rt_motion_.store(motion_, std::memory_order_release);
+  } else {
+    rt_rejected_sequence_.store(command.sequence, std::memory_order_relaxed);
+  }
+  rt_command_sequence_.store(command.sequence, std::memory_order_release);
+}
+
+void JointGoalMotionController::executeCallback(const MoveToJointGoalGoalConstPtr& goal) {
+  MoveToJointGoalResult result;
+  std::vector<JointGoal> goals;
+  const double speed_factor = goal->speed_factor > 0.0 ? goal->speed_factor
+                                                       : default_speed_factor_;
+
+  const uint64_t activations = rt_activations_.load(std::memory_order_acquire);
+  const Motion* motion = nullptr;
+  if (!resolveGoals(*goal, &goals, &result.message) ||
+      !command(speed_factor, goals, &motion, &result.message)) {
+    ROS_ERROR_STREAM("JointGoalMotionController: " << result.message);
+    // The rejected goal has preempted the previous one, whose motion must not run on unattended
+    const Motion* stop = nullptr;
+    std::string error;
+    if (!command(speed_factor, {}, &stop, &error)) {
+      ROS_WARN_STREAM("JointGoalMotionController: Could not stop: " << error);
+    }
+    action_server_->setAborted(result, result.message);
+    return;
+  }
+  ROS_INFO_STREAM("JointGoalMotionController: moving through "
+                  << goals.size() << " goals in " << motion->generator.duration() * 1e-6 << " s");
+
+  MoveToJointGoalFeedback feedback;
+  ros::Rate rate(kFeedbackRate);
+  while (true) {
+    const uint64_t time_us = rt_time_us_.load(std::memory_order_relaxed);
+    const std::size_t reached = motion->generator.reachedWaypoints(time_us);
+    result.completed = reached > motion->skipped ? reached - motion->skipped : 0;
+
+    if (rt_finished_sequence_.load(std::memory_order_relaxed) >= motion->sequence) {
+      result.completed = goals.size();
+      result.message = "Reached " + std::to_string(goals.size()) + " goals";
+      ROS_INFO_STREAM("JointGoalMotionController: " << result.message);
+      action_server_->setSucceeded(result, result.message);
+      return;
+    }
+    if (rt_activations_.load(std::memory_order_acquire) != activations) {
+      result.message = "Controller stopped while moving";
+      ROS_ERROR_STREAM("JointGoalMotionController: " << result.message);
+      action_server_->setAborted(result, result.message);
+      return;
+    }
+    if (action_server_->isPreemptRequested() || !ros::ok()) {
+      // A new goal takes over from the running motion in the next executeCallback()
+      const Motion* stop = nullptr;
+      std::string error;
+      if (!action_server_->isNewGoalAvailable() && !command(speed_factor, {}, &stop, &error)) {
+        ROS_WARN_STREAM("JointGoalMotionController: Could not stop: " << error);
+      }
+      result.message = "Preempted after " + std::to_string(result.completed) + " goals";
+      action_server_->setPreempted(result, result.message);
+      return;
+    }
+
+    feedback.completed = result.completed;
+    feedback.time_remaining =
+        time_us < motion->generator.duration()
+            ? (motion->generator.duration() - time_us) * 1e-6
+            : 0.0;
+    action_server_->publishFeedback(feedback);
+    rate.sleep();
+  }
+}
+
+bool JointGoalMotionController::resolveGoals(const MoveToJointGoalGoal& goal,
+                                             std::vector<JointGoal>* goals,
+                                             std::string* error) {
+  if (goal.speed_factor < 0.0 || goal.speed_factor > 1.0) {
+    *error = "speed_factor must be in (0, 1], or 0 for the default";
+    return false;
+  }
+  if (goal.names.empty() == goal.positions.empty()) {
+    *error = "Give either names or positions of the joint goals";
+    return false;
+  }
+  for (const std::string& name : goal.names) {
+    auto named = goals_.find(name);
+    if (named == goals_.end()) {
+      *error = "Unknown joint goal " + name;
+      return false;
+    }
+    goals->push_back(named->second);
+  }
+  if (goal.positions.size() % 7 != 0) {
+    *error = "positions must hold 7 joint positions per goal";
+    return false;
+  }
+  for (size_t k = 0; k < goal.positions.size(); k += 7) {
+    JointGoal explicit_goal;
+    std::copy_n(goal.positions.begin() + k, 7, explicit_goal.begin());
+    std::string limit_error;
+    if (!withinJointLimits(explicit_goal, &limit_error)) {
+      *error = "Goal " + std::to_string(k / 7 + 1) + " of positions: " + limit_error;
+      return false;
+    }
+    goals->push_back(explicit_goal);
+  }
+  return true;
+}
+
+bool JointGoalMotionController::command(double speed_factor,
+                                        const std::vector<JointGoal>& goals,
+                                        const Motion** motion,
+                                        std::string* error) {
+  const ros::WallTime deadline = ros::WallTime::now() + ros::WallDuration(kCommandTimeout);
+  int rejected = 0;
+  while (true) {
+    const Motion* base = rt_motion_.load(std::memory_order_acquire);
+    if (base == nullptr && goals.empty()) {
+      // Nothing to stop
+      *motion = nullptr;
+      return true;
+    }
+
+    std::unique_ptr<Motion> next;
+    uint64_t switch_until_us = 0;
+    if (base == nullptr) {
+      JointGoal q_start;
+      for (size_t i = 0; i < 7; ++i) {
+        q_start[i] = rt_hold_[i].load(std::memory_order_relaxed);
+      }
+      next = std::make_unique<Motion>(speed_factor, goals);
+      next->generator.plan(q_start);
+    } else {
+      next = std::make_unique<Motion>(*base);
+      switch_until_us = rt_time_us_.load(std::memory_order_relaxed) + kTakeOverUs;
+      const bool planned = goals.empty() ? next->generator.stop(switch_until_us)
+                                         : next->generator.redirect(switch_until_us, goals);
+      if (!planned) {
+        if (goals.empty()) {
+          // Already coming to rest
+          *motion = base;
+          return true;
+        }
+        // Coming to rest at its goal (start from there once it is reached) or no blend fits in
+        // time yet, retry with the next tick
+        if (ros::WallTime::now() > deadline) {
+          *error = "The running motion did not come to rest";
+          return false;
+        }
+        ros::WallDuration(0.001).sleep();
+        continue;
+      }
+      next->skipped = next->generator.reachedWaypoints(next->generator.duration()) - goals.size();
+    }
+    // A stop stays on the path of the running motion, between goals already checked
+    if (!goals.empty() && !planWithinJointLimits(next->generator, error)) {
+      return false;
+    }
+    next->sequence = ++sequence_;
+    const Motion* sent = next.get();
+
+    // Free the motions update() no longer runs and cannot switch to anymore
+    const uint64_t applied = rt_command_sequence_.load(std::memory_order_acquire);
+    const Motion* running = rt_motion_.load(std::memory_order_acquire);
+    motions_.erase(std::remove_if(motions_.begin(), motions_.end(),
+                                  [applied, running](const std::unique_ptr<Motion>& old) {
+                                    return old->sequence < applied && old.get() != running;
+                                  }),
+                   motions_.end());
+    motions_.push_back(std::move(next));
+    command_buffer_.modify([sent, base, switch_until_us](MotionCommand& command) {
+      command.motion = sent;
+      command.base = base;
+      command.switch_until_us = switch_until_us;
+      command.sequence = sent->sequence;
+    });
+
+    while (rt_command_sequence_.load(std::memory_order_acquire) < sent->sequence) {
+      if (ros::WallTime::now() > deadline) {
+        *error = "The controller did not take the motion over, is it running?";
+        return false;
+      }
+      ros::WallDuration(0.001).sleep();
+    }
+    if (rt_rejected_sequence_.load(std::memory_order_relaxed) != sent->sequence) {
+      *motion = sent;
+      return true;
+    }
+    if (++rejected >= kCommandAttempts) {
+      *error = "Could not take over the running motion";
+      return false;
+    }
+  }
+}
+
+}  // namespace franka_interactive_controllers
+
+PLUGINLIB_EXPORT_CLASS(franka_interactive_controllers::JointGoalMotionController,
+                       controller_interface::ControllerBase)
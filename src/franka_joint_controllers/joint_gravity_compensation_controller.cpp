@@ -13,7 +13,6 @@
 #include <pluginlib/class_list_macros.h>
 #include <ros/ros.h>
 
-#include <pseudo_inversion.h>
 #include <hardware_interface/joint_command_interface.h>
 
 namespace franka_interactive_controllers {
@@ -21,6 +20,9 @@ namespace franka_interactive_controllers {
 bool JointGravityCompensationController::init(hardware_interface::RobotHW* robot_hw,
                                                ros::NodeHandle& node_handle) {
 
+  // Create the RT log ring and its drain thread before the control loop runs
+  RealtimeLogger::instance();
+
   // Getting ROSParams
   std::string arm_id;
   if (!node_handle.getParam("arm_id", arm_id)) {
@@ -35,8 +37,9 @@ bool JointGravityCompensationController::init(hardware_interface::RobotHW* robot
     return false;
   }
 
+  GravityCompensationTarget target;
+
   // Initialize variables for tool compensation from yaml config file
-  activate_tool_compensation_ = true;
   std::vector<double> external_tool_compensation;
   if (!node_handle.getParam("external_tool_compensation", external_tool_compensation)) {
       ROS_ERROR(
@@ -45,11 +48,11 @@ bool JointGravityCompensationController::init(hardware_interface::RobotHW* robot
       return false;
     }
 
-  tool_compensation_force_.setZero();  
   for (size_t i = 0; i < 6; ++i) 
-    tool_compensation_force_[i] = external_tool_compensation.at(i);
-  ROS_INFO_STREAM("External tool compensation force: " << std::endl << tool_compensation_force_);
-  // tool_compensation_force_ << 0.46, -0.17, -1.64, 0, 0, 0;  //read from yaml
+    target.tool_compensation_force[i] = external_tool_compensation.at(i);
+  ROS_INFO_STREAM("External tool compensation force: " << std::endl
+                  << target.tool_compensation_force);
+  // tool_compensation_force << 0.46, -0.17, -1.64, 0, 0, 0;  //read from yaml
 
   // Getting libranka control interfaces
   auto* model_interface = robot_hw->get<franka_hw::FrankaModelInterface>();
@@ -67,6 +70,7 @@ bool JointGravityCompensationController::init(hardware_interface::RobotHW* robot
         << ex.what());
     return false;
   }
+  model_cache_.init(model_handle_.get());
 
   auto* state_interface = robot_hw->get<franka_hw::FrankaStateInterface>();
   if (state_interface == nullptr) {
@@ -83,6 +87,9 @@ bool JointGravityCompensationController::init(hardware_interface::RobotHW* robot
         << ex.what());
     return false;
   }
+  state_view_.init(*state_handle_, RobotStateView::kQ | RobotStateView::kTauJD |
+                                       EndEffectorStatePublisher::kStateFields |
+                                       FlightRecorder::kStateFields);
 
   auto* effort_joint_interface = robot_hw->get<hardware_interface::EffortJointInterface>();
   if (effort_joint_interface == nullptr) {
@@ -100,6 +107,10 @@ bool JointGravityCompensationController::init(hardware_interface::RobotHW* robot
     }
   }
 
+  // Initialize variables for joint locks (unlocked until set from dynamic reconfigure)
+  k_lock_      = 50; 
+  target_buffer_.reset(target);
+
   // Getting Dynamic Reconfigure objects
   dynamic_reconfigure_gravity_compensation_param_node_ =
       ros::NodeHandle(node_handle.getNamespace() + "dynamic_reconfigure_gravity_compensation_param_node");
@@ -111,116 +122,111 @@ bool JointGravityCompensationController::init(hardware_interface::RobotHW* robot
   dynamic_server_gravity_compensation_param_->setCallback(
       boost::bind(&JointGravityCompensationController::gravitycompensationParamCallback, this, _1, _2));
 
-  
-  // Initialize variables for joint locks
-  set_locked_joints_position_ = false;
-  activate_lock_joint6_ = false;
-  activate_lock_joint7_ = false;
-  k_lock_      = 50; 
-  q_locked_joints_.setZero();
+  if (!cycle_timer_.init(node_handle, "JointGravityCompensationController", &model_cache_)) {
+    return false;
+  }
+  if (!ee_state_publisher_.init(node_handle, "JointGravityCompensationController")) {
+    return false;
+  }
+  if (!flight_recorder_.init(node_handle, "JointGravityCompensationController")) {
+    return false;
+  }
 
   return true;
 }
 
 void JointGravityCompensationController::starting(const ros::Time& /*time*/) {
-  // Get robot current/initial joint state
-  franka::RobotState initial_state = state_handle_->getRobotState();
-  Eigen::Map<Eigen::Matrix<double, 7, 1>> q_initial(initial_state.q.data());
+  cycle_timer_.starting();
+  ee_state_publisher_.starting();
+  flight_recorder_.starting();
+
+  tau_task_.setZero();
+  tau_d_.setZero();
 
-  // get jacobian
-  std::array<double, 42> jacobian_array =
-      model_handle_->getZeroJacobian(franka::Frame::kEndEffector);
+  // Count heap allocations made on the control thread from here until stopping()
+  allocation_check_.start();
 }
 
-void JointGravityCompensationController::update(const ros::Time& /*time*/,
-                                                 const ros::Duration& /*period*/) {
-  // get state variables
-  franka::RobotState robot_state = state_handle_->getRobotState();
-  std::array<double, 7> coriolis_array = model_handle_->getCoriolis();
-  std::array<double, 42> jacobian_array =
-      model_handle_->getZeroJacobian(franka::Frame::kEndEffector);
+void JointGravityCompensationController::stopping(const ros::Time& /*time*/) {
+  std::size_t allocations = allocation_check_.stop();
+  if (allocations > 0) {
+    RT_LOG_ERROR("JointGravityCompensationController: %zu heap allocations on the control thread "
+                 "while running", allocations);
+  }
+}
 
-  // convert to Eigen
-  Eigen::Map<Eigen::Matrix<double, 7, 1>> coriolis(coriolis_array.data());
-  Eigen::Map<Eigen::Matrix<double, 6, 7>> jacobian(jacobian_array.data());
-  Eigen::Map<Eigen::Matrix<double, 7, 1>> q(robot_state.q.data());
-  Eigen::Map<Eigen::Matrix<double, 7, 1>> dq(robot_state.dq.data());
-  Eigen::Map<Eigen::Matrix<double, 7, 1>> tau_J_d(  // NOLINT (readability-identifier-naming)
-      robot_state.tau_J_d.data());
+void JointGravityCompensationController::update(const ros::Time& time,
+                                                 const ros::Duration& period) {
+  CycleTimer::Scope cycle_timing(&cycle_timer_, period);
 
-  // compute control
-  // allocate variables
-  Eigen::VectorXd tau_d(7), tau_task(7), tau_nullspace(7), tau_tool(7);
+  // get state variables in place; model quantities are evaluated when first used below
+  state_view_.beginTick();
+  model_cache_.beginTick();
 
-  // pseudoinverse for nullspace handling kinematic pseudoinverse
-  Eigen::MatrixXd jacobian_transpose_pinv;
-  pseudoInverse(jacobian.transpose(), jacobian_transpose_pinv);
+  // Eigen views of the state
+  const RobotStateView::Vector7dMap q = state_view_.q();
 
-  // Set 0 torques for the controller
-  tau_task.setZero();
+  // consistent snapshot of the dynamic reconfigure settings
+  const GravityCompensationTarget& target = target_buffer_.readFromRT();
 
-  // Compute tool compensation (scoop/camera in scooping task)
-  if (activate_tool_compensation_)
-    tau_tool << jacobian.transpose() * tool_compensation_force_;
-  else
-    tau_tool.setZero();
+  // Joint locks: spring towards q_locked_joints on the locked joints only
+  tau_task_ << -(target.lock_stiffness * (q - target.q_locked_joints));
 
-  if (activate_lock_joint6_){
-    double tau_task_6 = -k_lock_*(q[5] -  q_locked_joints_[5]) ;
-    std::cout << "tau_task_6: " << tau_task_6 << std::endl;
-    tau_task[5] = tau_task_6;
+  if (target.activate_lock_joint6){
+    RT_LOG_INFO_THROTTLE(0.1, "tau_task_6: %f", tau_task_[5]);
   }
 
-  if (activate_lock_joint7_){
-    double tau_task_7 = -k_lock_*(q[6] -  q_locked_joints_[6]) ;
-    std::cout << "tau_task_7: " << tau_task_7 << std::endl;
-    tau_task[6] = tau_task_7;
+  if (target.activate_lock_joint7){
+    RT_LOG_INFO_THROTTLE(0.1, "tau_task_7: %f", tau_task_[6]);
   }
 
-  // Desired torque (Check this.. might not be necessary)
-  tau_d << tau_task + coriolis - tau_tool;
+  // Desired torque (Check this.. might not be necessary): joint locks + coriolis - tool
+  // compensation (scoop/camera in scooping task), torque rate saturated to avoid discontinuities
+  const TorqueContext<GravityCompensationTarget> torque_context{
+      state_view_, model_cache_, target, tau_task_, nullptr, delta_tau_max_};
+  GravityCompensationTorque::compute(torque_context, &tau_d_);
 
   // Alternative 
-  // tau_d.setZero();
-
-  // Saturate torque rate to avoid discontinuities
-  tau_d << saturateTorqueRate(tau_d, tau_J_d);
+  // tau_d_.setZero();
 
   for (size_t i = 0; i < 7; ++i) {
-    joint_handles_[i].setCommand(tau_d(i));
+    joint_handles_[i].setCommand(tau_d_(i));
   }
-}
 
-Eigen::Matrix<double, 7, 1> JointGravityCompensationController::saturateTorqueRate(
-    const Eigen::Matrix<double, 7, 1>& tau_d_calculated,
-    const Eigen::Matrix<double, 7, 1>& tau_J_d) {  // NOLINT (readability-identifier-naming)
-  Eigen::Matrix<double, 7, 1> tau_d_saturated{};
-  for (size_t i = 0; i < 7; i++) {
-    double difference = tau_d_calculated[i] - tau_J_d[i];
-    tau_d_saturated[i] =
-        tau_J_d[i] + std::max(std::min(difference, delta_tau_max_), -delta_tau_max_);
+  if (FlightSample* sample = flight_recorder_.claim(time, period, state_view_)) {
+    using Vector7d = Eigen::Matrix<double, 7, 1>;
+    Eigen::Map<Vector7d>(sample->tau_task.data()) = tau_task_;
+    Eigen::Map<Vector7d>(sample->tau_coriolis.data()) = model_cache_.coriolis();
+    Eigen::Map<Vector7d>(sample->tau_d.data()) = tau_d_;
+    flight_recorder_.commit();
   }
-  return tau_d_saturated;
+
+  ee_state_publisher_.publish(time, state_view_, &model_cache_);
 }
 
 void JointGravityCompensationController::gravitycompensationParamCallback(
     franka_interactive_controllers::gravity_compensation_paramConfig& config,
     uint32_t /*level*/) {
-  
-  // To activate external tool compensation
-  activate_tool_compensation_ = config.activate_tool_compensation;
-  
-  // To lock a specific joint
-  activate_lock_joint6_                = config.activate_lock_joint6;
-  activate_lock_joint7_                = config.activate_lock_joint7;
-  
-  set_locked_joints_position_ = config.set_locked_joints_position;
-  if (set_locked_joints_position_){
-      franka::RobotState locked_state = state_handle_->getRobotState();
-      Eigen::Map<Eigen::Matrix<double, 7, 1>> q_locked_joints(locked_state.q.data());
-      q_locked_joints_ = q_locked_joints;
-      ROS_INFO_STREAM("Locked Joints Set to: " << q_locked_joints_);
-  }
+
+  target_buffer_.modify([&](GravityCompensationTarget& target) {
+    // To activate external tool compensation
+    target.activate_tool_compensation = config.activate_tool_compensation;
+
+    // To lock a specific joint
+    target.activate_lock_joint6 = config.activate_lock_joint6;
+    target.activate_lock_joint7 = config.activate_lock_joint7;
+    Eigen::Matrix<double, 7, 1> lock_stiffness = Eigen::Matrix<double, 7, 1>::Zero();
+    lock_stiffness[5] = target.activate_lock_joint6 ? k_lock_ : 0.0;
+    lock_stiffness[6] = target.activate_lock_joint7 ? k_lock_ : 0.0;
+    target.lock_stiffness = ImpedanceGain<7>::fromDiagonal(lock_stiffness);
+
+    if (config.set_locked_joints_position){
+        franka::RobotState locked_state = state_handle_->getRobotState();
+        Eigen::Map<Eigen::Matrix<double, 7, 1>> q_locked_joints(locked_state.q.data());
+        target.q_locked_joints = q_locked_joints;
+        ROS_INFO_STREAM("Locked Joints Set to: " << target.q_locked_joints);
+    }
+  });
 }
 
 
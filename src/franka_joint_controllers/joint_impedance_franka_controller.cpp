@@ -89,6 +89,7 @@ bool JointImpedanceFrankaController::init(hardware_interface::RobotHW* robot_hw,
         << ex.what());
     return false;
   }
+  model_cache_.init(model_handle_.get());
 
   auto* cartesian_pose_interface = robot_hw->get<franka_hw::FrankaPoseCartesianInterface>();
   if (cartesian_pose_interface == nullptr) {
@@ -105,6 +106,9 @@ bool JointImpedanceFrankaController::init(hardware_interface::RobotHW* robot_hw,
         << ex.what());
     return false;
   }
+  state_view_.init(*cartesian_pose_handle_,
+                   RobotStateView::kQ | RobotStateView::kQD | RobotStateView::kDq |
+                       RobotStateView::kDqD | RobotStateView::kTauJD);
 
   auto* effort_joint_interface = robot_hw->get<hardware_interface::EffortJointInterface>();
   if (effort_joint_interface == nullptr) {
@@ -124,15 +128,22 @@ bool JointImpedanceFrankaController::init(hardware_interface::RobotHW* robot_hw,
 
   std::fill(dq_filtered_.begin(), dq_filtered_.end(), 0);
 
+  if (!cycle_timer_.init(node_handle, "JointImpedanceFrankaController", &model_cache_)) {
+    return false;
+  }
+
   return true;
 }
 
 void JointImpedanceFrankaController::starting(const ros::Time& /*time*/) {
+  cycle_timer_.starting();
   initial_pose_ = cartesian_pose_handle_->getRobotState().O_T_EE_d;
 }
 
 void JointImpedanceFrankaController::update(const ros::Time& /*time*/,
                                              const ros::Duration& period) {
+  CycleTimer::Scope cycle_timing(&cycle_timer_, period);
+
   if (vel_current_ < vel_max_) {
     vel_current_ += period.toSec() * std::fabs(vel_max_ / acceleration_time_);
   }
@@ -151,38 +162,39 @@ void JointImpedanceFrankaController::update(const ros::Time& /*time*/,
   pose_desired[14] += delta_z;
   cartesian_pose_handle_->setCommand(pose_desired);
 
-  franka::RobotState robot_state = cartesian_pose_handle_->getRobotState();
-  std::array<double, 7> coriolis = model_handle_->getCoriolis();
-  std::array<double, 7> gravity = model_handle_->getGravity();
+  state_view_.beginTick();
+  model_cache_.beginTick();
+  const ModelCache::Vector7d& coriolis = model_cache_.coriolis();
+  const RobotStateView::Vector7dMap q = state_view_.q();
+  const RobotStateView::Vector7dMap q_d = state_view_.qD();
+  const RobotStateView::Vector7dMap dq = state_view_.dq();
+  const RobotStateView::Vector7dMap dq_d = state_view_.dqD();
 
   double alpha = 0.99;
   for (size_t i = 0; i < 7; i++) {
-    dq_filtered_[i] = (1 - alpha) * dq_filtered_[i] + alpha * robot_state.dq[i];
+    dq_filtered_[i] = (1 - alpha) * dq_filtered_[i] + alpha * dq(i);
   }
 
   std::array<double, 7> tau_d_calculated;
   for (size_t i = 0; i < 7; ++i) {
-    tau_d_calculated[i] = coriolis_factor_ * coriolis[i] +
-                          k_gains_[i] * (robot_state.q_d[i] - robot_state.q[i]) +
-                          d_gains_[i] * (robot_state.dq_d[i] - dq_filtered_[i]);
+    tau_d_calculated[i] = coriolis_factor_ * coriolis(i) +
+                          k_gains_[i] * (q_d(i) - q(i)) +
+                          d_gains_[i] * (dq_d(i) - dq_filtered_[i]);
   }
 
   // Maximum torque difference with a sampling rate of 1 kHz. The maximum torque rate is
   // 1000 * (1 / sampling_time).
-  std::array<double, 7> tau_d_saturated = saturateTorqueRate(tau_d_calculated, robot_state.tau_J_d);
+  std::array<double, 7> tau_d_saturated =
+      saturateTorqueRate(tau_d_calculated, state_view_.tauJD());
 
   for (size_t i = 0; i < 7; ++i) {
     joint_handles_[i].setCommand(tau_d_saturated[i]);
   }
-
-  for (size_t i = 0; i < 7; ++i) {
-    last_tau_d_[i] = tau_d_saturated[i] + gravity[i];
-  }
 }
 
 std::array<double, 7> JointImpedanceFrankaController::saturateTorqueRate(
     const std::array<double, 7>& tau_d_calculated,
-    const std::array<double, 7>& tau_J_d) {  // NOLINT (readability-identifier-naming)
+    const RobotStateView::Vector7dMap& tau_J_d) {  // NOLINT (readability-identifier-naming)
   std::array<double, 7> tau_d_saturated{};
   for (size_t i = 0; i < 7; i++) {
     double difference = tau_d_calculated[i] - tau_J_d[i];
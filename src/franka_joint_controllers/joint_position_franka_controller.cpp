@@ -52,10 +52,15 @@ bool JointPositionFrankaController::init(hardware_interface::RobotHW* robot_hard
     }
   }
 
+  if (!cycle_timer_.init(node_handle, "JointPositionFrankaController")) {
+    return false;
+  }
+
   return true;
 }
 
 void JointPositionFrankaController::starting(const ros::Time& /* time */) {
+  cycle_timer_.starting();
   for (size_t i = 0; i < 7; ++i) {
     initial_pose_[i] = position_joint_handles_[i].getPosition();
   }
@@ -64,6 +69,8 @@ void JointPositionFrankaController::starting(const ros::Time& /* time */) {
 
 void JointPositionFrankaController::update(const ros::Time& /*time*/,
                                             const ros::Duration& period) {
+  CycleTimer::Scope cycle_timing(&cycle_timer_, period);
+
   elapsed_time_ += period;
 
   double delta_angle = M_PI / 16 * (1 - std::cos(M_PI / 5.0 * elapsed_time_.toSec())) * 0.2;
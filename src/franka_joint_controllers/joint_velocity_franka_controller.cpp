@@ -66,15 +66,22 @@ bool JointVelocityFrankaController::init(hardware_interface::RobotHW* robot_hard
     return false;
   }
 
+  if (!cycle_timer_.init(node_handle, "JointVelocityFrankaController")) {
+    return false;
+  }
+
   return true;
 }
 
 void JointVelocityFrankaController::starting(const ros::Time& /* time */) {
+  cycle_timer_.starting();
   elapsed_time_ = ros::Duration(0.0);
 }
 
 void JointVelocityFrankaController::update(const ros::Time& /* time */,
                                             const ros::Duration& period) {
+  CycleTimer::Scope cycle_timing(&cycle_timer_, period);
+
   elapsed_time_ += period;
 
   ros::Duration time_max(8.0);
@@ -20,42 +20,39 @@ MotionGenerator::MotionGenerator(double speed_factor, const std::array<double, 7
   t_1_sync_.setZero();
   t_2_sync_.setZero();
   t_f_sync_.setZero();
-  q_1_.setZero();
+  calculatePhases();
 }
 
-bool MotionGenerator::calculateDesiredValues(double t, Vector7d* delta_q_d) const {
-  Vector7i sign_delta_q;
-  sign_delta_q << delta_q_.cwiseSign().cast<int>();
-  Vector7d t_d = t_2_sync_ - t_1_sync_;
-  Vector7d delta_t_2_sync = t_f_sync_ - t_2_sync_;
-  std::array<bool, 7> joint_motion_finished{};
+MotionGenerator::MotionGenerator(double speed_factor,
+                                 const std::array<double, 7>& q_start,
+                                 const std::array<double, 7> q_goal)
+    : MotionGenerator(speed_factor, q_goal) {
+  plan(q_start);
+}
 
-  for (size_t i = 0; i < 7; i++) {
-    if (std::abs(delta_q_[i]) < kDeltaQMotionFinished) {
-      (*delta_q_d)[i] = 0;
-      joint_motion_finished[i] = true;
-    } else {
-      if (t < t_1_sync_[i]) {
-        (*delta_q_d)[i] = -1.0 / std::pow(t_1_sync_[i], 3.0) * dq_max_sync_[i] * sign_delta_q[i] *
-                          (0.5 * t - t_1_sync_[i]) * std::pow(t, 3.0);
-      } else if (t >= t_1_sync_[i] && t < t_2_sync_[i]) {
-        (*delta_q_d)[i] = q_1_[i] + (t - t_1_sync_[i]) * dq_max_sync_[i] * sign_delta_q[i];
-      } else if (t >= t_2_sync_[i] && t < t_f_sync_[i]) {
-        (*delta_q_d)[i] =
-            delta_q_[i] + 0.5 *
-                              (1.0 / std::pow(delta_t_2_sync[i], 3.0) *
-                                   (t - t_1_sync_[i] - 2.0 * delta_t_2_sync[i] - t_d[i]) *
-                                   std::pow((t - t_1_sync_[i] - t_d[i]), 3.0) +
-                               (2.0 * t - 2.0 * t_1_sync_[i] - delta_t_2_sync[i] - 2.0 * t_d[i])) *
-                              dq_max_sync_[i] * sign_delta_q[i];
-      } else {
-        (*delta_q_d)[i] = delta_q_[i];
-        joint_motion_finished[i] = true;
-      }
-    }
+void MotionGenerator::plan(const std::array<double, 7>& q_start) {
+  q_start_ = Vector7d(q_start.data());
+  delta_q_ = q_goal_ - q_start_;
+  calculateSynchronizedValues();
+  calculatePhases();
+  planned_ = true;
+}
+
+void MotionGenerator::sample(double dt, Eigen::Matrix<double, 7, Eigen::Dynamic>* positions) const {
+  const auto count = static_cast<Eigen::Index>(std::ceil(duration_ / dt)) + 1;
+  positions->resize(7, count);
+  for (Eigen::Index k = 0; k < count; ++k) {
+    positions->col(k) = q_start_ + calculateDesiredValues(k * dt).head<7>().matrix();
+  }
+}
+
+MotionGenerator::Lanes MotionGenerator::calculateDesiredValues(double t) const {
+  Lanes delta_q_d = Lanes::Zero();
+  for (const Phase& phase : phases_) {
+    const Lanes tau = (t - phase.begin).max(0.0).min(phase.length);
+    delta_q_d += tau * (phase.c1 + tau.square() * (phase.c3 + tau * phase.c4));
   }
-  return std::all_of(joint_motion_finished.cbegin(), joint_motion_finished.cend(),
-                     [](bool x) { return x; });
+  return delta_q_d;
 }
 
 void MotionGenerator::calculateSynchronizedValues() {
@@ -66,6 +63,10 @@ void MotionGenerator::calculateSynchronizedValues() {
   Vector7d delta_t_2_sync = Vector7d::Zero();
   Vector7i sign_delta_q;
   sign_delta_q << delta_q_.cwiseSign().cast<int>();
+  dq_max_sync_.setZero();
+  t_1_sync_.setZero();
+  t_2_sync_.setZero();
+  t_f_sync_.setZero();
 
   for (size_t i = 0; i < 7; i++) {
     if (std::abs(delta_q_[i]) > kDeltaQMotionFinished) {
@@ -96,27 +97,64 @@ void MotionGenerator::calculateSynchronizedValues() {
       t_f_sync_[i] =
           (t_1_sync_)[i] / 2.0 + delta_t_2_sync[i] / 2.0 + std::abs(delta_q_[i] / dq_max_sync_[i]);
       t_2_sync_[i] = (t_f_sync_)[i] - delta_t_2_sync[i];
-      q_1_[i] = (dq_max_sync_)[i] * sign_delta_q[i] * (0.5 * (t_1_sync_)[i]);
     }
   }
 }
 
+void MotionGenerator::calculatePhases() {
+  Phase& accelerate = phases_[0];
+  Phase& cruise = phases_[1];
+  Phase& decelerate = phases_[2];
+  for (Phase& phase : phases_) {
+    phase.begin.setZero();
+    phase.length.setZero();
+    phase.c1.setZero();
+    phase.c3.setZero();
+    phase.c4.setZero();
+  }
+
+  for (size_t i = 0; i < 7; i++) {
+    if (std::abs(delta_q_[i]) > kDeltaQMotionFinished) {
+      const double dq = delta_q_[i] > 0.0 ? dq_max_sync_[i] : -dq_max_sync_[i];
+      const double t_1 = t_1_sync_[i];
+      const double delta_t_2 = t_f_sync_[i] - t_2_sync_[i];
+
+      accelerate.length[i] = t_1;
+      accelerate.c3[i] = dq / (t_1 * t_1);
+      accelerate.c4[i] = -0.5 * dq / (t_1 * t_1 * t_1);
+
+      cruise.begin[i] = t_1;
+      cruise.length[i] = std::max(t_2_sync_[i] - t_1, 0.0);
+      cruise.c1[i] = dq;
+
+      decelerate.begin[i] = t_2_sync_[i];
+      decelerate.length[i] = delta_t_2;
+      decelerate.c1[i] = dq;
+      decelerate.c3[i] = -dq / (delta_t_2 * delta_t_2);
+      decelerate.c4[i] = 0.5 * dq / (delta_t_2 * delta_t_2 * delta_t_2);
+    }
+  }
+  duration_ = t_f_sync_.maxCoeff();
+}
+
 franka::JointPositions MotionGenerator::operator()(const franka::RobotState& robot_state,
                                                    franka::Duration period) {
   time_ += period.toSec();
 
   if (time_ == 0.0) {
-    q_start_ = Vector7d(robot_state.q_d.data());
-    delta_q_ = q_goal_ - q_start_;
-    calculateSynchronizedValues();
+    // Planned ahead only if the robot is still where the plan starts
+    if (!planned_ ||
+        (Vector7d(robot_state.q_d.data()) - q_start_).cwiseAbs().maxCoeff() >
+            kDeltaQMotionFinished) {
+      plan(robot_state.q_d);
+    }
   }
 
-  Vector7d delta_q_d;
-  bool motion_finished = calculateDesiredValues(time_, &delta_q_d);
+  const Lanes delta_q_d = calculateDesiredValues(time_);
 
   std::array<double, 7> joint_positions;
-  Eigen::VectorXd::Map(&joint_positions[0], 7) = (q_start_ + delta_q_d);
+  Eigen::VectorXd::Map(&joint_positions[0], 7) = q_start_ + delta_q_d.head<7>().matrix();
   franka::JointPositions output(joint_positions);
-  output.motion_finished = motion_finished;
+  output.motion_finished = time_ >= duration_;
   return output;
 }
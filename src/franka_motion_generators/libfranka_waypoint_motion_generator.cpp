@@ -0,0 +1,303 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include <franka_motion_generators/libfranka_waypoint_motion_generator.h>
+
+namespace {
+
+// Iterations of the line duration fit (converges in a few)
+constexpr int kFitIterations = 50;
+// Attempts to move the first corner along its line until its blend starts in time
+constexpr int kShiftAttempts = 50;
+
+int64_t toSigned(uint64_t time_us) {
+  return static_cast<int64_t>(time_us);
+}
+
+}  // anonymous namespace
+
+constexpr uint64_t WaypointMotionGenerator::kTickUs;
+constexpr double WaypointMotionGenerator::kDeltaQMotionFinished;
+
+WaypointMotionGenerator::WaypointMotionGenerator(double speed_factor,
+                                                 const std::vector<JointGoal>& waypoints)
+    : waypoints_(waypoints) {
+  dq_max_ *= speed_factor;
+  ddq_max_start_ *= speed_factor;
+  ddq_max_goal_ *= speed_factor;
+  dddq_max_ *= speed_factor;
+  q_start_.setZero();
+}
+
+void WaypointMotionGenerator::plan(const JointGoal& q_start) {
+  q_start_ = Vector7d(q_start.data());
+  Via start;
+  start.q = q_start_;
+  start.dq_in.setZero();
+  start.dq_out.setZero();
+  start.c3.setZero();
+  start.c4.setZero();
+  vias_.assign(1, start);
+  cursor_ = 0;
+  // At rest only the time of the start moves, so its blend always starts in time
+  build(0, start, 0, waypoints_);
+}
+
+bool WaypointMotionGenerator::replan(uint64_t time_us, const std::vector<JointGoal>& waypoints) {
+  for (std::size_t k = 1; k < vias_.size(); ++k) {
+    if (vias_[k].begin_us >= time_us) {
+      // The new blend may be longer, but must not start inside the previous one
+      return build(k, vias_[k], std::max(time_us, vias_[k - 1].end_us), waypoints);
+    }
+  }
+  return false;
+}
+
+bool WaypointMotionGenerator::redirect(uint64_t time_us,
+                                       const std::vector<JointGoal>& waypoints) {
+  for (std::size_t k = 1; k < vias_.size(); ++k) {
+    if (vias_[k].begin_us >= time_us) {
+      // The line into via k runs from the end of the previous blend to the begin of its own
+      Via corner = vias_[k];
+      const uint64_t earliest_us = std::max(time_us, vias_[k - 1].end_us);
+      corner.q += corner.dq_in * ((toSigned(earliest_us) - toSigned(corner.center_us)) * 1e-6);
+      corner.center_us = earliest_us;
+      return build(k, corner, earliest_us, waypoints);
+    }
+  }
+  return false;
+}
+
+bool WaypointMotionGenerator::stop(uint64_t time_us) {
+  for (std::size_t k = 1; k < vias_.size(); ++k) {
+    Via& corner = vias_[k];
+    if (corner.begin_us < time_us) {
+      continue;
+    }
+    const uint64_t earliest_us = std::max(time_us, vias_[k - 1].end_us);
+    const auto blend_us = static_cast<uint64_t>(
+        std::llround(blendDuration(corner.dq_in, Vector7d::Zero()) * 1e6));
+    const uint64_t center_us = earliest_us + blend_us / 2;
+    if (center_us > corner.center_us) {
+      // Too late to stop short of this via point (never the case for the goal)
+      time_us = corner.end_us;
+      continue;
+    }
+    corner.q += corner.dq_in * ((toSigned(center_us) - toSigned(corner.center_us)) * 1e-6);
+    corner.center_us = center_us;
+    corner.dq_out.setZero();
+    setBlend(blend_us, &corner);
+    vias_.erase(vias_.begin() + k + 1, vias_.end());
+    return true;
+  }
+  return false;
+}
+
+std::size_t WaypointMotionGenerator::reachedWaypoints(uint64_t time_us) const {
+  std::size_t reached = 0;
+  for (std::size_t k = 1; k < vias_.size(); ++k) {
+    const bool goal = k + 1 == vias_.size();
+    if ((goal ? vias_[k].end_us : vias_[k].center_us) <= time_us) {
+      ++reached;
+    }
+  }
+  return reached;
+}
+
+void WaypointMotionGenerator::position(uint64_t time_us, Vector7d* q, Vector7d* dq) const {
+  if (vias_.empty()) {
+    *q = q_start_;
+    if (dq != nullptr) {
+      dq->setZero();
+    }
+    return;
+  }
+  evaluate(vias_[viaAt(time_us)], time_us, q, dq);
+}
+
+void WaypointMotionGenerator::sample(uint64_t dt_us,
+                                     Eigen::Matrix<double, 7, Eigen::Dynamic>* positions) const {
+  const auto count = static_cast<Eigen::Index>((duration() + dt_us - 1) / dt_us) + 1;
+  positions->resize(7, count);
+  Vector7d q;
+  for (Eigen::Index k = 0; k < count; ++k) {
+    position(k * dt_us, &q);
+    positions->col(k) = q;
+  }
+}
+
+franka::JointPositions WaypointMotionGenerator::operator()(const franka::RobotState& robot_state,
+                                                           franka::Duration period) {
+  time_us_ += period.toMSec() * kTickUs;
+
+  if (time_us_ == 0) {
+    // Planned ahead only if the robot is still where the plan starts
+    if (vias_.empty() ||
+        (Vector7d(robot_state.q_d.data()) - q_start_).cwiseAbs().maxCoeff() >
+            kDeltaQMotionFinished) {
+      plan(robot_state.q_d);
+    }
+    cursor_ = 0;
+  }
+
+  while (cursor_ + 1 < vias_.size() && time_us_ >= vias_[cursor_].end_us) {
+    ++cursor_;
+  }
+  Vector7d q;
+  evaluate(vias_[cursor_], time_us_, &q, nullptr);
+
+  std::array<double, 7> joint_positions;
+  Eigen::VectorXd::Map(&joint_positions[0], 7) = q;
+  franka::JointPositions output(joint_positions);
+  output.motion_finished = time_us_ >= duration();
+  return output;
+}
+
+bool WaypointMotionGenerator::build(std::size_t corner,
+                                    const Via& start,
+                                    uint64_t earliest_us,
+                                    const std::vector<JointGoal>& waypoints) {
+  // points[0] is the corner, lines[k] and velocities[k] belong to the line into points[k],
+  // blends[k] to the corner at points[k]
+  const std::size_t count = waypoints.size();
+  std::vector<Vector7d> points(count + 1);
+  points[0] = start.q;
+  for (std::size_t k = 0; k < count; ++k) {
+    points[k + 1] = Vector7d(waypoints[k].data());
+  }
+  std::vector<Vector7d> velocities(count + 2, Vector7d::Zero());
+  velocities[0] = start.dq_in;
+  std::vector<double> lines(count + 1, 0.0);
+  std::vector<uint64_t> line_us(count + 1, 0);
+  std::vector<uint64_t> blend_us(count + 1, 0);
+  uint64_t center_us = start.center_us;
+
+  bool in_time = false;
+  for (int attempt = 0; attempt < kShiftAttempts; ++attempt) {
+    // Shortest line durations for the velocity limit, then lengthened until neighbouring blends
+    // fit; the geometric mean step solves line = blend(velocity(line)) for blend ~ 1 / line.
+    std::vector<double> min_lines(count + 1, 0.0);
+    for (std::size_t k = 1; k <= count; ++k) {
+      min_lines[k] =
+          std::max((points[k] - points[k - 1]).cwiseAbs().cwiseQuotient(dq_max_).maxCoeff(), 1e-3);
+      lines[k] = min_lines[k];
+    }
+    for (int iteration = 0; iteration < kFitIterations; ++iteration) {
+      for (std::size_t k = 1; k <= count; ++k) {
+        velocities[k] = (points[k] - points[k - 1]) / lines[k];
+      }
+      for (std::size_t k = 1; k <= count; ++k) {
+        const double target =
+            std::max(min_lines[k], 0.5 * (blendDuration(velocities[k - 1], velocities[k]) +
+                                          blendDuration(velocities[k], velocities[k + 1])));
+        lines[k] = std::sqrt(lines[k] * target);
+      }
+    }
+
+    // Whole milliseconds, lengthened one by one until the rounded blends fit
+    for (std::size_t k = 1; k <= count; ++k) {
+      line_us[k] = static_cast<uint64_t>(std::ceil(lines[k] * 1e3 - 1e-6)) * kTickUs;
+    }
+    bool fits = false;
+    while (!fits) {
+      for (std::size_t k = 1; k <= count; ++k) {
+        velocities[k] = (points[k] - points[k - 1]) / (line_us[k] * 1e-6);
+      }
+      for (std::size_t k = 0; k <= count; ++k) {
+        blend_us[k] = static_cast<uint64_t>(
+            std::llround(blendDuration(velocities[k], velocities[k + 1]) * 1e6));
+      }
+      fits = true;
+      for (std::size_t k = 1; k <= count; ++k) {
+        if (line_us[k] < (blend_us[k - 1] + blend_us[k]) / 2) {
+          line_us[k] += kTickUs;
+          fits = false;
+        }
+      }
+    }
+
+    // The blend at the corner must not start before earliest_us; otherwise move the corner along
+    // the line into it (for the start, at rest, only its time moves)
+    if (toSigned(center_us) - toSigned(blend_us[0] / 2) >= toSigned(earliest_us)) {
+      in_time = true;
+      break;
+    }
+    const uint64_t shift_us = earliest_us + blend_us[0] / 2 - center_us + attempt * kTickUs;
+    center_us += shift_us;
+    points[0] += start.dq_in * (shift_us * 1e-6);
+  }
+  if (!in_time) {
+    return false;
+  }
+
+  vias_.erase(vias_.begin() + corner, vias_.end());
+  for (std::size_t k = 0; k <= count; ++k) {
+    Via via;
+    via.center_us = center_us;
+    via.q = points[k];
+    via.dq_in = velocities[k];
+    via.dq_out = velocities[k + 1];
+    setBlend(blend_us[k], &via);
+    vias_.push_back(via);
+    if (k < count) {
+      center_us += line_us[k + 1];
+    }
+  }
+  return true;
+}
+
+double WaypointMotionGenerator::blendDuration(const Vector7d& dq_in,
+                                              const Vector7d& dq_out) const {
+  // Smoothstep velocity ramp over T: peak acceleration 1.5 |delta_dq| / T, peak jerk
+  // 6 |delta_dq| / T^2
+  const Vector7d delta_dq = (dq_out - dq_in).cwiseAbs();
+  if (delta_dq.maxCoeff() < kDeltaQMotionFinished) {
+    return 0.0;
+  }
+  const Vector7d ddq_max = ddq_max_start_.cwiseMin(ddq_max_goal_);
+  const double blend =
+      std::max((1.5 * delta_dq.cwiseQuotient(ddq_max)).maxCoeff(),
+               std::sqrt((6.0 * delta_dq.cwiseQuotient(dddq_max_)).maxCoeff()));
+  return std::ceil(blend * 500.0 - 1e-9) * 2e-3;
+}
+
+void WaypointMotionGenerator::setBlend(uint64_t blend_us, Via* via) {
+  via->begin_us = via->center_us - blend_us / 2;
+  via->end_us = via->center_us + blend_us / 2;
+  via->c3.setZero();
+  via->c4.setZero();
+  if (blend_us > 0) {
+    const double blend = blend_us * 1e-6;
+    const Vector7d delta_dq = via->dq_out - via->dq_in;
+    via->c3 = delta_dq / (blend * blend);
+    via->c4 = -0.5 * delta_dq / (blend * blend * blend);
+  }
+}
+
+void WaypointMotionGenerator::evaluate(const Via& via, uint64_t time_us, Vector7d* q,
+                                       Vector7d* dq) {
+  if (time_us < via.begin_us || time_us >= via.end_us) {
+    const Vector7d& velocity = time_us < via.begin_us ? via.dq_in : via.dq_out;
+    *q = via.q + velocity * ((toSigned(time_us) - toSigned(via.center_us)) * 1e-6);
+    if (dq != nullptr) {
+      *dq = velocity;
+    }
+    return;
+  }
+  const double u = (time_us - via.begin_us) * 1e-6;
+  *q = via.q + via.dq_in * ((toSigned(via.begin_us) - toSigned(via.center_us)) * 1e-6) +
+       u * (via.dq_in + u * u * (via.c3 + u * via.c4));
+  if (dq != nullptr) {
+    *dq = via.dq_in + u * u * (3.0 * via.c3 + 4.0 * u * via.c4);
+  }
+}
+
+std::size_t WaypointMotionGenerator::viaAt(uint64_t time_us) const {
+  const auto via = std::upper_bound(
+      vias_.begin(), vias_.end(), time_us,
+      [](uint64_t time, const Via& candidate) { return time < candidate.end_us; });
+  return std::min<std::size_t>(via - vias_.begin(), vias_.size() - 1);
+}
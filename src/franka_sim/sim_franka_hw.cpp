@@ -0,0 +1,400 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+
+#include <sim_franka_hw.h>
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+
+#include <hardware_interface/internal/demangle_symbol.h>
+#include <ros/ros.h>
+
+#include <panda_kinematics.h>
+
+namespace franka_interactive_controllers {
+
+namespace {
+
+// Panda limits from the Franka Control Interface documentation
+const SimFrankaHW::Vector7d kJointPositionMin =
+    (SimFrankaHW::Vector7d() << -2.8973, -1.7628, -2.8973, -3.0718, -2.8973, -0.0175, -2.8973)
+        .finished();
+const SimFrankaHW::Vector7d kJointPositionMax =
+    (SimFrankaHW::Vector7d() << 2.8973, 1.7628, 2.8973, -0.0698, 2.8973, 3.7525, 2.8973)
+        .finished();
+const SimFrankaHW::Vector7d kJointVelocityMax =
+    (SimFrankaHW::Vector7d() << 2.175, 2.175, 2.175, 2.175, 2.61, 2.61, 2.61).finished();
+const SimFrankaHW::Vector7d kTorqueMax =
+    (SimFrankaHW::Vector7d() << 87.0, 87.0, 87.0, 87.0, 12.0, 12.0, 12.0).finished();
+
+const std::array<double, 3> kGravityEarth = {{0.0, 0.0, -9.81}};
+
+// Reads an optional list parameter of the given size; false if present with a wrong size.
+bool getOptionalVector(ros::NodeHandle& node_handle,
+                       const std::string& name,
+                       size_t size,
+                       std::vector<double>* values) {
+  std::vector<double> parameter;
+  if (!node_handle.getParam(name, parameter)) {
+    ROS_INFO_STREAM("SimFrankaHW: No parameter " << name << ", using the default");
+    return true;
+  }
+  if (parameter.size() != size) {
+    ROS_ERROR_STREAM("SimFrankaHW: " << name << " must have " << size << " elements");
+    return false;
+  }
+  *values = parameter;
+  return true;
+}
+
+const std::string& effortInterfaceName() {
+  static const std::string name =
+      hardware_interface::internal::demangledTypeName<hardware_interface::EffortJointInterface>();
+  return name;
+}
+
+const std::string& positionInterfaceName() {
+  static const std::string name =
+      hardware_interface::internal::demangledTypeName<hardware_interface::PositionJointInterface>();
+  return name;
+}
+
+const std::string& velocityInterfaceName() {
+  static const std::string name =
+      hardware_interface::internal::demangledTypeName<hardware_interface::VelocityJointInterface>();
+  return name;
+}
+
+const std::string& cartesianPoseInterfaceName() {
+  static const std::string name =
+      hardware_interface::internal::demangledTypeName<franka_hw::FrankaPoseCartesianInterface>();
+  return name;
+}
+
+const std::string& cartesianVelocityInterfaceName() {
+  static const std::string name = hardware_interface::internal::demangledTypeName<
+      franka_hw::FrankaVelocityCartesianInterface>();
+  return name;
+}
+
+bool isMotionInterface(const std::string& name) {
+  return name == positionInterfaceName() || name == velocityInterfaceName() ||
+         name == cartesianPoseInterfaceName() || name == cartesianVelocityInterfaceName();
+}
+
+}  // namespace
+
+bool SimFrankaHW::init(ros::NodeHandle& /*root_nh*/, ros::NodeHandle& robot_hw_nh) {
+  if (!robot_hw_nh.getParam("arm_id", arm_id_)) {
+    ROS_ERROR("SimFrankaHW: Could not read parameter arm_id");
+    return false;
+  }
+  if (!robot_hw_nh.getParam("joint_names", joint_names_) || joint_names_.size() != 7) {
+    ROS_ERROR("SimFrankaHW: Invalid or no joint_names parameters provided, aborting init!");
+    return false;
+  }
+
+  std::vector<double> initial_q = {0.0, -M_PI_4, 0.0, -3 * M_PI_4, 0.0, M_PI_2, M_PI_4};
+  std::vector<double> friction(7, 0.1);
+  // Franka Hand, see cfg/end-effector.json
+  double end_effector_mass = 0.73;
+  std::vector<double> end_effector_com = {-0.01, 0.0, 0.03};
+  std::vector<double> end_effector_inertia = {0.001, 0.0, 0.0, 0.0, 0.0025, 0.0, 0.0, 0.0, 0.0017};
+  std::vector<double> F_T_EE = {0.7071, -0.7071, 0.0, 0.0, 0.7071, 0.7071, 0.0, 0.0,
+                                0.0,    0.0,     1.0, 0.0, 0.0,    0.0,    0.1034, 1.0};
+  std::string end_effector_config;
+  if (robot_hw_nh.getParam("sim_end_effector_config", end_effector_config)) {
+    PandaDynamics::Load load;
+    Eigen::Matrix4d transformation;
+    std::string error;
+    if (!PandaDynamics::readEndEffectorConfig(end_effector_config, &load, &transformation,
+                                              &error)) {
+      ROS_ERROR_STREAM("SimFrankaHW: Invalid sim_end_effector_config: " << error);
+      return false;
+    }
+    end_effector_mass = load.mass;
+    end_effector_com.assign(load.center_of_mass.data(), load.center_of_mass.data() + 3);
+    end_effector_inertia.assign(load.inertia.data(), load.inertia.data() + 9);
+    F_T_EE.assign(transformation.data(), transformation.data() + 16);
+  }
+  if (!getOptionalVector(robot_hw_nh, "sim_initial_joint_positions", 7, &initial_q) ||
+      !getOptionalVector(robot_hw_nh, "sim_joint_friction", 7, &friction) ||
+      !getOptionalVector(robot_hw_nh, "sim_end_effector_center_of_mass", 3, &end_effector_com) ||
+      !getOptionalVector(robot_hw_nh, "sim_end_effector_inertia", 9, &end_effector_inertia) ||
+      !getOptionalVector(robot_hw_nh, "sim_F_T_EE", 16, &F_T_EE)) {
+    return false;
+  }
+  if (!robot_hw_nh.getParam("sim_end_effector_mass", end_effector_mass)) {
+    ROS_INFO_STREAM("SimFrankaHW: No parameter sim_end_effector_mass, defaulting to: "
+                    << end_effector_mass);
+  }
+  if (!robot_hw_nh.getParam("sim_substeps", substeps_)) {
+    ROS_INFO_STREAM("SimFrankaHW: No parameter sim_substeps, defaulting to: " << substeps_);
+  }
+  if (substeps_ < 1 || end_effector_mass < 0.0) {
+    ROS_ERROR("SimFrankaHW: sim_substeps must be >= 1 and sim_end_effector_mass >= 0");
+    return false;
+  }
+
+  friction_ = Eigen::Map<const Vector7d>(friction.data());
+  F_T_EE_ = Eigen::Map<const Eigen::Matrix4d>(F_T_EE.data());
+  PandaDynamics::Load load;
+  load.mass = end_effector_mass;
+  load.center_of_mass = Eigen::Map<const Eigen::Vector3d>(end_effector_com.data());
+  load.inertia = Eigen::Map<const Eigen::Matrix3d>(end_effector_inertia.data());
+  dynamics_.setLoad(load);
+
+  // Static parts of the robot state, as franka_control reports them for this end effector
+  std::copy(F_T_EE.begin(), F_T_EE.end(), robot_state_.F_T_EE.begin());
+  Eigen::Map<Eigen::Matrix4d>(robot_state_.EE_T_K.data()).setIdentity();
+  robot_state_.m_ee = end_effector_mass;
+  robot_state_.m_total = end_effector_mass;
+  std::copy(end_effector_com.begin(), end_effector_com.end(), robot_state_.F_x_Cee.begin());
+  robot_state_.F_x_Ctotal = robot_state_.F_x_Cee;
+  std::copy(end_effector_inertia.begin(), end_effector_inertia.end(),
+            robot_state_.I_ee.begin());
+  robot_state_.I_total = robot_state_.I_ee;
+  robot_state_.control_command_success_rate = 1.0;
+  robot_state_.robot_mode = franka::RobotMode::kMove;
+
+  for (size_t i = 0; i < 7; ++i) {
+    hardware_interface::JointStateHandle joint_state_handle(
+        joint_names_[i], &robot_state_.q[i], &robot_state_.dq[i], &robot_state_.tau_J[i]);
+    joint_state_interface_.registerHandle(joint_state_handle);
+    effort_joint_interface_.registerHandle(
+        hardware_interface::JointHandle(joint_state_handle, &effort_command_[i]));
+    position_joint_interface_.registerHandle(
+        hardware_interface::JointHandle(joint_state_handle, &position_command_[i]));
+    velocity_joint_interface_.registerHandle(
+        hardware_interface::JointHandle(joint_state_handle, &velocity_command_[i]));
+  }
+  franka_hw::FrankaStateHandle franka_state_handle(arm_id_ + "_robot", robot_state_);
+  franka_state_interface_.registerHandle(franka_state_handle);
+  franka_model_interface_.registerHandle(
+      franka_hw::FrankaModelHandle(arm_id_ + "_model", model_, robot_state_));
+  franka_pose_cartesian_interface_.registerHandle(
+      franka_hw::FrankaCartesianPoseHandle(franka_state_handle, pose_command_, elbow_command_));
+  franka_velocity_cartesian_interface_.registerHandle(franka_hw::FrankaCartesianVelocityHandle(
+      franka_state_handle, cartesian_velocity_command_, elbow_command_));
+
+  registerInterface(&joint_state_interface_);
+  registerInterface(&effort_joint_interface_);
+  registerInterface(&position_joint_interface_);
+  registerInterface(&velocity_joint_interface_);
+  registerInterface(&franka_state_interface_);
+  registerInterface(&franka_model_interface_);
+  registerInterface(&franka_pose_cartesian_interface_);
+  registerInterface(&franka_velocity_cartesian_interface_);
+
+  reset(Eigen::Map<const Vector7d>(initial_q.data()));
+  return true;
+}
+
+void SimFrankaHW::reset(const Vector7d& q) {
+  q_ = q;
+  dq_.setZero();
+  tau_d_.setZero();
+  read(ros::Time(0), ros::Duration(0));
+  holdCommands();
+}
+
+void SimFrankaHW::read(const ros::Time& /*time*/, const ros::Duration& period) {
+  Eigen::Map<Vector7d>(robot_state_.q.data()) = q_;
+  Eigen::Map<Vector7d>(robot_state_.dq.data()) = dq_;
+  robot_state_.theta = robot_state_.q;
+  robot_state_.dtheta = robot_state_.dq;
+
+  PandaKinematics<>::Result kinematics;
+  PandaKinematics<>::compute(q_, F_T_EE_, Eigen::Matrix4d::Identity(), &kinematics);
+  Eigen::Map<Eigen::Matrix4d>(robot_state_.O_T_EE.data()) = kinematics.O_T_EE;
+  robot_state_.elbow = {{q_(2), -1.0}};
+
+  // Desired values follow the active motion generator, or the measured state without one
+  robot_state_.q_d = motion_mode_ == MotionMode::kJointPosition ? position_command_
+                                                                 : robot_state_.q;
+  robot_state_.dq_d = motion_mode_ == MotionMode::kJointVelocity ? velocity_command_
+                                                                  : robot_state_.dq;
+  robot_state_.O_T_EE_d =
+      motion_mode_ == MotionMode::kCartesianPose ? pose_command_ : robot_state_.O_T_EE;
+  robot_state_.O_T_EE_c = robot_state_.O_T_EE_d;
+  robot_state_.O_dP_EE_c = motion_mode_ == MotionMode::kCartesianVelocity
+                               ? cartesian_velocity_command_
+                               : std::array<double, 6>{};
+  robot_state_.O_dP_EE_d = robot_state_.O_dP_EE_c;
+  robot_state_.elbow_d = robot_state_.elbow;
+  robot_state_.elbow_c = robot_state_.elbow;
+
+  // Measured torques include gravity, the commanded ones do not
+  Vector7d gravity;
+  dynamics_.gravityVector(q_, Eigen::Map<const Eigen::Vector3d>(kGravityEarth.data()), &gravity);
+  const Vector7d tau_J = tau_d_ + gravity;
+  const double dt = period.toSec();
+  Eigen::Map<Vector7d> dtau_J(robot_state_.dtau_J.data());
+  if (dt > 0.0) {
+    dtau_J = (tau_J - Eigen::Map<const Vector7d>(robot_state_.tau_J.data())) / dt;
+  } else {
+    dtau_J.setZero();
+  }
+  Eigen::Map<Vector7d>(robot_state_.tau_J.data()) = tau_J;
+  Eigen::Map<Vector7d>(robot_state_.tau_J_d.data()) = tau_d_;
+  robot_state_.time = franka::Duration(static_cast<uint64_t>(time_ * 1000.0 + 0.5));
+}
+
+void SimFrankaHW::write(const ros::Time& /*time*/, const ros::Duration& period) {
+  const double dt = period.toSec();
+  if (dt <= 0.0) {
+    return;
+  }
+  if (effort_active_) {
+    tau_d_ = Eigen::Map<const Vector7d>(effort_command_.data())
+                 .cwiseMax(-kTorqueMax)
+                 .cwiseMin(kTorqueMax);
+    integrateTorque(dt);
+  } else {
+    tau_d_.setZero();
+    trackMotion(dt);
+  }
+  time_ += dt;
+}
+
+void SimFrankaHW::integrateTorque(double dt) {
+  // Semi-implicit Euler on M(q) ddq + C(q, dq) dq = tau_d - friction, gravity being compensated
+  const double step = dt / substeps_;
+  for (int i = 0; i < substeps_; ++i) {
+    PandaDynamics::Matrix7d mass;
+    Vector7d coriolis;
+    dynamics_.massMatrix(q_, &mass);
+    dynamics_.coriolisVector(q_, dq_, &coriolis);
+    const Vector7d ddq = mass.ldlt().solve(tau_d_ - coriolis - friction_.cwiseProduct(dq_));
+    dq_ += step * ddq;
+    dq_ = dq_.cwiseMax(-kJointVelocityMax).cwiseMin(kJointVelocityMax);
+    q_ += step * dq_;
+    enforceLimits();
+  }
+}
+
+void SimFrankaHW::trackMotion(double dt) {
+  switch (motion_mode_) {
+    case MotionMode::kNone:
+      dq_.setZero();
+      return;
+    case MotionMode::kJointPosition:
+      dq_ = (Eigen::Map<const Vector7d>(position_command_.data()) - q_) / dt;
+      break;
+    case MotionMode::kJointVelocity:
+      dq_ = Eigen::Map<const Vector7d>(velocity_command_.data());
+      break;
+    case MotionMode::kCartesianVelocity:
+      dq_ = cartesianToJointVelocity(
+          Eigen::Map<const Eigen::Matrix<double, 6, 1>>(cartesian_velocity_command_.data()));
+      break;
+    case MotionMode::kCartesianPose: {
+      const Eigen::Affine3d current(Eigen::Matrix4d::Map(robot_state_.O_T_EE.data()));
+      const Eigen::Affine3d commanded(Eigen::Matrix4d::Map(pose_command_.data()));
+      const Eigen::AngleAxisd rotation(commanded.linear() * current.linear().transpose());
+      Eigen::Matrix<double, 6, 1> twist;
+      twist << (commanded.translation() - current.translation()) / dt,
+          rotation.axis() * rotation.angle() / dt;
+      dq_ = cartesianToJointVelocity(twist);
+      break;
+    }
+  }
+  dq_ = dq_.cwiseMax(-kJointVelocityMax).cwiseMin(kJointVelocityMax);
+  q_ += dt * dq_;
+  enforceLimits();
+}
+
+SimFrankaHW::Vector7d SimFrankaHW::cartesianToJointVelocity(
+    const Eigen::Matrix<double, 6, 1>& twist) const {
+  PandaKinematics<>::Result kinematics;
+  PandaKinematics<>::compute(q_, F_T_EE_, Eigen::Matrix4d::Identity(), &kinematics);
+  Eigen::Matrix<double, 7, 6> jacobian_pinv;
+  jacobian_pinv_solver_.compute(kinematics.zero_jacobian, jacobian_pinv);
+  return jacobian_pinv * twist;
+}
+
+void SimFrankaHW::enforceLimits() {
+  for (int i = 0; i < 7; ++i) {
+    if (q_(i) < kJointPositionMin(i)) {
+      q_(i) = kJointPositionMin(i);
+      dq_(i) = std::max(dq_(i), 0.0);
+    } else if (q_(i) > kJointPositionMax(i)) {
+      q_(i) = kJointPositionMax(i);
+      dq_(i) = std::min(dq_(i), 0.0);
+    }
+  }
+}
+
+bool SimFrankaHW::checkForConflict(
+    const std::list<hardware_interface::ControllerInfo>& info) const {
+  std::set<std::string> motion_interfaces;
+  std::map<std::string, int> claims;  // (interface, joint) -> number of controllers
+  for (const auto& controller : info) {
+    for (const auto& claimed : controller.claimed_resources) {
+      if (isMotionInterface(claimed.hardware_interface)) {
+        motion_interfaces.insert(claimed.hardware_interface);
+      }
+      for (const auto& resource : claimed.resources) {
+        if (++claims[claimed.hardware_interface + "/" + resource] > 1) {
+          ROS_ERROR_STREAM("SimFrankaHW: Resource " << resource << " of "
+                           << claimed.hardware_interface
+                           << " is claimed by more than one controller");
+          return true;
+        }
+      }
+    }
+  }
+  if (motion_interfaces.size() > 1) {
+    ROS_ERROR("SimFrankaHW: Only one motion generator interface can be claimed at a time");
+    return true;
+  }
+  return false;
+}
+
+void SimFrankaHW::doSwitch(const std::list<hardware_interface::ControllerInfo>& start_list,
+                           const std::list<hardware_interface::ControllerInfo>& stop_list) {
+  for (const auto& controller : stop_list) {
+    controller_interfaces_.erase(controller.name);
+  }
+  for (const auto& controller : start_list) {
+    std::vector<std::string>& interfaces = controller_interfaces_[controller.name];
+    for (const auto& claimed : controller.claimed_resources) {
+      interfaces.push_back(claimed.hardware_interface);
+    }
+  }
+  updateControlMode();
+  holdCommands();
+}
+
+void SimFrankaHW::updateControlMode() {
+  effort_active_ = false;
+  motion_mode_ = MotionMode::kNone;
+  for (const auto& controller : controller_interfaces_) {
+    for (const std::string& name : controller.second) {
+      if (name == effortInterfaceName()) {
+        effort_active_ = true;
+      } else if (name == positionInterfaceName()) {
+        motion_mode_ = MotionMode::kJointPosition;
+      } else if (name == velocityInterfaceName()) {
+        motion_mode_ = MotionMode::kJointVelocity;
+      } else if (name == cartesianPoseInterfaceName()) {
+        motion_mode_ = MotionMode::kCartesianPose;
+      } else if (name == cartesianVelocityInterfaceName()) {
+        motion_mode_ = MotionMode::kCartesianVelocity;
+      }
+    }
+  }
+}
+
+void SimFrankaHW::holdCommands() {
+  // Starting controllers find the commands at the current state, the arm at rest
+  effort_command_.fill(0.0);
+  position_command_ = robot_state_.q;
+  velocity_command_.fill(0.0);
+  pose_command_ = robot_state_.O_T_EE;
+  cartesian_velocity_command_.fill(0.0);
+  elbow_command_ = robot_state_.elbow;
+}
+
+}  // namespace franka_interactive_controllers
@@ -0,0 +1,152 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+
+#include <sim_panda_model.h>
+
+#include <algorithm>
+
+#include <panda_dynamics.h>
+#include <panda_kinematics.h>
+
+namespace franka_interactive_controllers {
+
+namespace {
+
+Eigen::Map<const Eigen::Matrix4d> toMatrix(const std::array<double, 16>& array) {
+  return Eigen::Map<const Eigen::Matrix4d>(array.data());
+}
+
+PandaDynamics::Load toLoad(const std::array<double, 9>& I_total,
+                           double m_total,
+                           const std::array<double, 3>& F_x_Ctotal) {
+  PandaDynamics::Load load;
+  load.mass = m_total;
+  load.center_of_mass = Eigen::Map<const Eigen::Vector3d>(F_x_Ctotal.data());
+  load.inertia = Eigen::Map<const Eigen::Matrix3d>(I_total.data());
+  return load;
+}
+
+}  // namespace
+
+void SimPandaModel::linkFrames(const Vector7d& q, Frames* frames) {
+  PandaKinematics<>::Result kinematics;
+  PandaKinematics<>::compute(q, Eigen::Matrix4d::Identity(), Eigen::Matrix4d::Identity(),
+                             &kinematics);
+  for (int i = 0; i <= kLinks; ++i) {
+    (*frames)[i] = Eigen::Isometry3d(kinematics.link_frames[i]);
+  }
+}
+
+Eigen::Isometry3d SimPandaModel::framePose(franka::Frame frame,
+                                           const Frames& frames,
+                                           const Eigen::Matrix4d& F_T_EE,
+                                           const Eigen::Matrix4d& EE_T_K) {
+  switch (frame) {
+    case franka::Frame::kEndEffector:
+      return frames[kLinks] * Eigen::Isometry3d(F_T_EE);
+    case franka::Frame::kStiffness:
+      return frames[kLinks] * Eigen::Isometry3d(F_T_EE) * Eigen::Isometry3d(EE_T_K);
+    default:
+      return frames[static_cast<int>(frame)];
+  }
+}
+
+SimPandaModel::Jacobian SimPandaModel::frameZeroJacobian(franka::Frame frame,
+                                                         const Frames& frames,
+                                                         const Eigen::Matrix4d& F_T_EE,
+                                                         const Eigen::Matrix4d& EE_T_K) {
+  const Eigen::Vector3d position = framePose(frame, frames, F_T_EE, EE_T_K).translation();
+  // joints after the frame's own link do not move it
+  const int last_joint = std::min(static_cast<int>(frame), kLinks - 1);
+  Jacobian jacobian = Jacobian::Zero();
+  for (int i = 0; i <= last_joint; ++i) {
+    const Eigen::Vector3d axis = frames[i].linear().col(2);
+    jacobian.block<3, 1>(0, i) = axis.cross(position - frames[i].translation());
+    jacobian.block<3, 1>(3, i) = axis;
+  }
+  return jacobian;
+}
+
+std::array<double, 16> SimPandaModel::pose(franka::Frame frame,
+                                           const std::array<double, 7>& q,
+                                           const std::array<double, 16>& F_T_EE,
+                                           const std::array<double, 16>& EE_T_K) const {
+  Frames frames;
+  linkFrames(Eigen::Map<const Vector7d>(q.data()), &frames);
+  std::array<double, 16> result;
+  Eigen::Map<Eigen::Matrix4d>(result.data()) =
+      framePose(frame, frames, toMatrix(F_T_EE), toMatrix(EE_T_K)).matrix();
+  return result;
+}
+
+std::array<double, 42> SimPandaModel::bodyJacobian(franka::Frame frame,
+                                                   const std::array<double, 7>& q,
+                                                   const std::array<double, 16>& F_T_EE,
+                                                   const std::array<double, 16>& EE_T_K) const {
+  Frames frames;
+  linkFrames(Eigen::Map<const Vector7d>(q.data()), &frames);
+  const Eigen::Matrix3d rotation_transpose =
+      framePose(frame, frames, toMatrix(F_T_EE), toMatrix(EE_T_K)).linear().transpose();
+  const Jacobian zero_jacobian =
+      frameZeroJacobian(frame, frames, toMatrix(F_T_EE), toMatrix(EE_T_K));
+  std::array<double, 42> result;
+  Eigen::Map<Jacobian> body_jacobian(result.data());
+  body_jacobian.topRows<3>() = rotation_transpose * zero_jacobian.topRows<3>();
+  body_jacobian.bottomRows<3>() = rotation_transpose * zero_jacobian.bottomRows<3>();
+  return result;
+}
+
+std::array<double, 42> SimPandaModel::zeroJacobian(franka::Frame frame,
+                                                   const std::array<double, 7>& q,
+                                                   const std::array<double, 16>& F_T_EE,
+                                                   const std::array<double, 16>& EE_T_K) const {
+  Frames frames;
+  linkFrames(Eigen::Map<const Vector7d>(q.data()), &frames);
+  std::array<double, 42> result;
+  Eigen::Map<Jacobian>(result.data()) =
+      frameZeroJacobian(frame, frames, toMatrix(F_T_EE), toMatrix(EE_T_K));
+  return result;
+}
+
+std::array<double, 49> SimPandaModel::mass(const std::array<double, 7>& q,
+                                           const std::array<double, 9>& I_total,
+                                           double m_total,
+                                           const std::array<double, 3>& F_x_Ctotal) const {
+  const PandaDynamics dynamics(toLoad(I_total, m_total, F_x_Ctotal));
+  Matrix7d mass_matrix;
+  dynamics.massMatrix(Eigen::Map<const Vector7d>(q.data()), &mass_matrix);
+  std::array<double, 49> result;
+  Eigen::Map<Matrix7d>(result.data()) = mass_matrix;
+  return result;
+}
+
+std::array<double, 7> SimPandaModel::coriolis(const std::array<double, 7>& q,
+                                              const std::array<double, 7>& dq,
+                                              const std::array<double, 9>& I_total,
+                                              double m_total,
+                                              const std::array<double, 3>& F_x_Ctotal) const {
+  const PandaDynamics dynamics(toLoad(I_total, m_total, F_x_Ctotal));
+  Vector7d coriolis_vector;
+  dynamics.coriolisVector(Eigen::Map<const Vector7d>(q.data()),
+                          Eigen::Map<const Vector7d>(dq.data()), &coriolis_vector);
+  std::array<double, 7> result;
+  Eigen::Map<Vector7d>(result.data()) = coriolis_vector;
+  return result;
+}
+
+std::array<double, 7> SimPandaModel::gravity(const std::array<double, 7>& q,
+                                             double m_total,
+                                             const std::array<double, 3>& F_x_Ctotal,
+                                             const std::array<double, 3>& gravity_earth) const {
+  // the inertia of the load does not enter the gravity torques
+  const PandaDynamics dynamics(toLoad(std::array<double, 9>{}, m_total, F_x_Ctotal));
+  Vector7d gravity_vector;
+  dynamics.gravityVector(Eigen::Map<const Vector7d>(q.data()),
+                         Eigen::Map<const Eigen::Vector3d>(gravity_earth.data()),
+                         &gravity_vector);
+  std::array<double, 7> result;
+  Eigen::Map<Vector7d>(result.data()) = gravity_vector;
+  return result;
+}
+
+}  // namespace franka_interactive_controllers
@@ -0,0 +1,95 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Drop-in replacement for franka_control_node running the controllers against SimFrankaHW, see
+// launch/franka_sim_bringup.launch. Parameters in the private namespace besides SimFrankaHW's:
+//   sim_rate      control rate [Hz], default 1000
+//   sim_batch     false: run in real time on the wall clock. true: run as fast as possible and
+//                 publish the simulated time on /clock (set /use_sim_time). Time only starts
+//                 racing once a controller commands the arm, so spawners can catch up.
+//   sim_duration  stop after this much simulated time with a controller commanding the arm
+//                 [s], default 0: run until shutdown
+#include <chrono>
+#include <thread>
+
+#include <controller_manager/controller_manager.h>
+#include <ros/ros.h>
+#include <rosgraph_msgs/Clock.h>
+#include <sim_franka_hw.h>
+
+int main(int argc, char** argv) {
+  ros::init(argc, argv, "franka_sim");
+  ros::NodeHandle public_node_handle;
+  ros::NodeHandle node_handle("~");
+
+  double rate = 1000.0;
+  if (!node_handle.getParam("sim_rate", rate)) {
+    ROS_INFO_STREAM("franka_sim_node: No parameter sim_rate, defaulting to: " << rate);
+  }
+  bool batch = false;
+  if (!node_handle.getParam("sim_batch", batch)) {
+    ROS_INFO_STREAM("franka_sim_node: No parameter sim_batch, defaulting to: " << batch);
+  }
+  double duration = 0.0;
+  if (!node_handle.getParam("sim_duration", duration)) {
+    ROS_INFO_STREAM("franka_sim_node: No parameter sim_duration, defaulting to: " << duration);
+  }
+  if (rate <= 0.0 || duration < 0.0) {
+    ROS_ERROR("franka_sim_node: sim_rate must be positive and sim_duration non-negative");
+    return 1;
+  }
+
+  franka_interactive_controllers::SimFrankaHW sim_hw;
+  if (!sim_hw.init(public_node_handle, node_handle)) {
+    ROS_ERROR("franka_sim_node: Could not initialize SimFrankaHW");
+    return 1;
+  }
+  controller_manager::ControllerManager control_manager(&sim_hw, public_node_handle);
+
+  ros::Publisher clock_publisher;
+  if (batch) {
+    clock_publisher = public_node_handle.advertise<rosgraph_msgs::Clock>("/clock", 1);
+  }
+
+  // Controller manager services and the controllers' subscribers
+  ros::AsyncSpinner spinner(4);
+  spinner.start();
+
+  const ros::Duration period(1.0 / rate);
+  const std::chrono::nanoseconds wall_period(period.toNSec());
+  ros::Time time = batch ? ros::Time(1.0) : ros::Time::now();
+  double commanded_time = 0.0;
+  std::chrono::steady_clock::time_point next_tick = std::chrono::steady_clock::now();
+  while (ros::ok()) {
+    sim_hw.read(time, period);
+    control_manager.update(time, period);
+    sim_hw.write(time, period);
+
+    if (sim_hw.commanded()) {
+      commanded_time += period.toSec();
+      if (duration > 0.0 && commanded_time >= duration) {
+        ROS_INFO_STREAM("franka_sim_node: Simulated " << commanded_time << "s, stopping");
+        break;
+      }
+    }
+
+    if (batch) {
+      time += period;
+      rosgraph_msgs::Clock clock;
+      clock.clock = time;
+      clock_publisher.publish(clock);
+      if (sim_hw.commanded()) {
+        next_tick = std::chrono::steady_clock::now();
+        continue;
+      }
+    }
+    next_tick += wall_period;
+    std::this_thread::sleep_until(next_tick);
+    if (!batch) {
+      time = ros::Time::now();
+    }
+  }
+
+  spinner.stop();
+  return 0;
+}
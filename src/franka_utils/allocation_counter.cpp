@@ -0,0 +1,98 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// malloc/free interposer counting heap allocations made by an "armed" thread. Meant to be
+// LD_PRELOADed into franka_control, see franka_utils/allocation_counter.h.
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+
+extern "C" {
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t count, std::size_t size);
+void* __libc_realloc(void* ptr, std::size_t size);
+void* __libc_memalign(std::size_t alignment, std::size_t size);
+void __libc_free(void* ptr);
+}
+
+namespace {
+
+std::atomic<std::size_t> g_allocation_count{0};
+// initial-exec TLS never allocates on access, so it is safe to use from inside malloc.
+__thread bool t_armed __attribute__((tls_model("initial-exec"))) = false;
+
+// FRANKA_ALLOCATION_COUNTER_ABORT set to a non-zero number. Neither getenv nor strtol allocate.
+bool abortRequested() {
+  const char* value = std::getenv("FRANKA_ALLOCATION_COUNTER_ABORT");
+  return value != nullptr && std::strtol(value, nullptr, 10) != 0;
+}
+
+void countAllocation() {
+  if (!t_armed) {
+    return;
+  }
+  g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+  static const bool kAbort = abortRequested();
+  if (kAbort) {
+    t_armed = false;
+    std::fputs("franka_allocation_counter: heap allocation on an armed real-time thread\n",
+               stderr);
+    std::abort();
+  }
+}
+
+}  // anonymous namespace
+
+extern "C" {
+
+void franka_allocation_counter_arm() {
+  t_armed = true;
+}
+
+void franka_allocation_counter_disarm() {
+  t_armed = false;
+}
+
+std::size_t franka_allocation_counter_count() {
+  return g_allocation_count.load(std::memory_order_relaxed);
+}
+
+void* malloc(std::size_t size) {
+  countAllocation();
+  return __libc_malloc(size);
+}
+
+void* calloc(std::size_t count, std::size_t size) {
+  countAllocation();
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, std::size_t size) {
+  countAllocation();
+  return __libc_realloc(ptr, size);
+}
+
+void* memalign(std::size_t alignment, std::size_t size) {
+  countAllocation();
+  return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(std::size_t alignment, std::size_t size) {
+  countAllocation();
+  return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, std::size_t alignment, std::size_t size) {
+  countAllocation();
+  *ptr = __libc_memalign(alignment, size);
+  return *ptr == nullptr ? ENOMEM : 0;
+}
+
+void free(void* ptr) {
+  __libc_free(ptr);
+}
+
+}  // extern "C"
@@ -0,0 +1,146 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+
+#include <cycle_timing.h>
+
+#include <cstdlib>
+
+#include <ros/ros.h>
+
+#include <model_cache.h>
+
+namespace franka_interactive_controllers {
+
+namespace {
+
+double toSeconds(uint64_t nanoseconds) {
+  return static_cast<double>(nanoseconds) * 1e-9;
+}
+
+}  // namespace
+
+bool CycleTimer::init(ros::NodeHandle& node_handle,
+                      const std::string& controller_name,
+                      ModelCache* model_cache) {
+  controller_name_ = controller_name;
+  model_cache_ = model_cache;
+
+  double budget = 0.0005;
+  if (!node_handle.getParam("cycle_timing_budget", budget)) {
+    ROS_INFO_STREAM(controller_name_ << ": No parameter cycle_timing_budget, defaulting to: "
+                    << budget);
+  }
+  double nominal_period = 0.001;
+  if (!node_handle.getParam("cycle_timing_nominal_period", nominal_period)) {
+    ROS_INFO_STREAM(controller_name_
+                    << ": No parameter cycle_timing_nominal_period, defaulting to: "
+                    << nominal_period);
+  }
+  double publish_rate = 1.0;
+  if (!node_handle.getParam("cycle_timing_publish_rate", publish_rate)) {
+    ROS_INFO_STREAM(controller_name_ << ": No parameter cycle_timing_publish_rate, defaulting to: "
+                    << publish_rate);
+  }
+  if (budget <= 0.0 || nominal_period <= 0.0 || publish_rate < 0.0) {
+    ROS_ERROR_STREAM(controller_name_ << ": Invalid cycle_timing parameters, aborting controller "
+                     "init!");
+    return false;
+  }
+  budget_ns_ = static_cast<int64_t>(budget * 1e9);
+  nominal_period_ns_ = static_cast<int64_t>(nominal_period * 1e9);
+
+  if (publish_rate > 0.0) {
+    publish_interval_ns_ = static_cast<int64_t>(1e9 / publish_rate);
+    publisher_ = std::make_unique<
+        realtime_tools::RealtimePublisher<franka_interactive_controllers::CycleTiming>>(
+        node_handle, "cycle_timing", 1);
+  }
+  reset_service_ =
+      node_handle.advertiseService("reset_cycle_timing", &CycleTimer::resetCallback, this);
+
+  compute_histogram_.clear();
+  jitter_histogram_.clear();
+  overruns_ = 0;
+  first_tick_ = true;
+  return true;
+}
+
+void CycleTimer::begin(const ros::Duration& period) {
+  tick_start_ = Clock::now();
+
+  if (reset_requested_.exchange(false, std::memory_order_acquire)) {
+    compute_histogram_.clear();
+    jitter_histogram_.clear();
+    overruns_ = 0;
+    first_tick_ = true;
+    if (model_cache_ != nullptr) {
+      model_cache_->resetEvaluations();
+    }
+  }
+
+  if (first_tick_) {
+    // period of the first tick after (re)starting is meaningless
+    first_tick_ = false;
+    last_publish_ = tick_start_;
+  } else {
+    jitter_histogram_.record(std::llabs(period.toNSec() - nominal_period_ns_));
+  }
+}
+
+void CycleTimer::end() {
+  const Clock::time_point tick_end = Clock::now();
+  const int64_t compute_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(tick_end - tick_start_).count();
+  compute_histogram_.record(compute_ns);
+  if (compute_ns > budget_ns_) {
+    ++overruns_;
+  }
+
+  if (publisher_ &&
+      std::chrono::duration_cast<std::chrono::nanoseconds>(tick_end - last_publish_).count() >=
+          publish_interval_ns_) {
+    last_publish_ = tick_end;
+    publish();
+  }
+}
+
+void CycleTimer::publish() {
+  // Skipped if the publisher thread still holds the previous message
+  if (!publisher_->trylock()) {
+    return;
+  }
+  franka_interactive_controllers::CycleTiming& msg = publisher_->msg_;
+  msg.header.stamp = ros::Time::now();
+  msg.ticks = compute_histogram_.count();
+  msg.overruns = overruns_;
+  msg.budget = toSeconds(budget_ns_);
+  msg.compute_p50 = toSeconds(compute_histogram_.percentile(0.5));
+  msg.compute_p99 = toSeconds(compute_histogram_.percentile(0.99));
+  msg.compute_p999 = toSeconds(compute_histogram_.percentile(0.999));
+  msg.compute_max = toSeconds(compute_histogram_.max());
+  msg.nominal_period = toSeconds(nominal_period_ns_);
+  msg.jitter_p50 = toSeconds(jitter_histogram_.percentile(0.5));
+  msg.jitter_p99 = toSeconds(jitter_histogram_.percentile(0.99));
+  msg.jitter_p999 = toSeconds(jitter_histogram_.percentile(0.999));
+  msg.jitter_max = toSeconds(jitter_histogram_.max());
+  static_assert(sizeof(msg.model_evaluations) / sizeof(msg.model_evaluations[0]) ==
+                    ModelCache::kQuantities,
+                "CycleTiming.model_evaluations does not match ModelCache::Quantity");
+  for (int i = 0; i < ModelCache::kQuantities; ++i) {
+    msg.model_evaluations[i] =
+        model_cache_ != nullptr
+            ? model_cache_->evaluations(static_cast<ModelCache::Quantity>(i))
+            : 0;
+  }
+  publisher_->unlockAndPublish();
+}
+
+bool CycleTimer::resetCallback(std_srvs::Trigger::Request& /*request*/,
+                               std_srvs::Trigger::Response& response) {
+  reset_requested_.store(true, std::memory_order_release);
+  response.success = true;
+  response.message = controller_name_ + ": cycle timing reset";
+  return true;
+}
+
+}  // namespace franka_interactive_controllers
@@ -0,0 +1,148 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <ee_state_publisher.h>
+
+#include <Eigen/Dense>
+#include <ros/ros.h>
+
+namespace franka_interactive_controllers {
+
+constexpr uint32_t EndEffectorStatePublisher::kStateFields;
+
+bool EndEffectorStatePublisher::init(ros::NodeHandle& node_handle,
+                                     const std::string& controller_name) {
+  if (!node_handle.getParam("ee_state_publish_decimation", decimation_)) {
+    ROS_INFO_STREAM(controller_name << ": No parameter ee_state_publish_decimation, defaulting "
+                    "to: " << decimation_ << " (disabled)");
+  }
+  if (decimation_ < 0) {
+    ROS_ERROR_STREAM(controller_name << ": ee_state_publish_decimation must be >= 0, aborting "
+                     "controller init!");
+    return false;
+  }
+  // Topics of scripts/franka_to_geometry_messages.py, for nodes that still subscribe to them
+  bool legacy_topics = false;
+  std::string legacy_topics_key;
+  if (node_handle.searchParam("ee_state_legacy_topics", legacy_topics_key)) {
+    node_handle.getParam(legacy_topics_key, legacy_topics);
+  }
+  // Nodes subscribed to the legacy topics expect them at the rate of franka_states
+  if (legacy_topics && decimation_ == 0) {
+    decimation_ = 1;
+    ROS_INFO_STREAM(controller_name << ": ee_state_legacy_topics is set, publishing the "
+                    "end-effector state every tick (ee_state_publish_decimation 1)");
+  }
+  if (decimation_ == 0) {
+    return true;
+  }
+  std::string frame_id("panda_link0");
+  node_handle.getParam("ee_state_frame_id", frame_id);
+
+  pose_publisher_ =
+      std::make_unique<realtime_tools::RealtimePublisher<geometry_msgs::PoseStamped>>(
+          node_handle, "ee_pose", 1);
+  twist_publisher_ =
+      std::make_unique<realtime_tools::RealtimePublisher<geometry_msgs::TwistStamped>>(
+          node_handle, "ee_twist", 1);
+  wrench_publisher_ =
+      std::make_unique<realtime_tools::RealtimePublisher<geometry_msgs::WrenchStamped>>(
+          node_handle, "ee_wrench", 1);
+  // frame_id is set once here so that the RT loop never assigns a std::string
+  pose_publisher_->lock();
+  pose_publisher_->msg_.header.frame_id = frame_id;
+  pose_publisher_->unlock();
+  twist_publisher_->lock();
+  twist_publisher_->msg_.header.frame_id = frame_id;
+  twist_publisher_->unlock();
+  wrench_publisher_->lock();
+  wrench_publisher_->msg_.header.frame_id = frame_id;
+  wrench_publisher_->unlock();
+
+  if (legacy_topics) {
+    legacy_pose_stamped_publisher_ =
+        std::make_unique<realtime_tools::RealtimePublisher<geometry_msgs::PoseStamped>>(
+            node_handle, "/franka_state_controller/O_T_EE", 1);
+    legacy_pose_publisher_ =
+        std::make_unique<realtime_tools::RealtimePublisher<geometry_msgs::Pose>>(
+            node_handle, "/franka_state_controller/ee_pose", 1);
+    legacy_pose_stamped_publisher_->lock();
+    legacy_pose_stamped_publisher_->msg_.header.frame_id = frame_id;
+    legacy_pose_stamped_publisher_->unlock();
+  }
+  ticks_ = 0;
+  return true;
+}
+
+void EndEffectorStatePublisher::publish(const ros::Time& time,
+                                        const RobotStateView& state,
+                                        ModelCache* model_cache) {
+  if (decimation_ == 0) {
+    return;
+  }
+  const bool due = ticks_ == 0;
+  if (++ticks_ >= decimation_) {
+    ticks_ = 0;
+  }
+  if (!due) {
+    return;
+  }
+
+  const Eigen::Affine3d transform(state.oTEE());
+  const Eigen::Vector3d position(transform.translation());
+  const Eigen::Quaterniond orientation(transform.linear());
+  const auto fill_pose = [&position, &orientation](geometry_msgs::Pose* pose) {
+    pose->position.x = position.x();
+    pose->position.y = position.y();
+    pose->position.z = position.z();
+    pose->orientation.x = orientation.x();
+    pose->orientation.y = orientation.y();
+    pose->orientation.z = orientation.z();
+    pose->orientation.w = orientation.w();
+  };
+
+  // Each message is skipped if its publisher thread still holds the previous one
+  if (pose_publisher_->trylock()) {
+    geometry_msgs::PoseStamped& msg = pose_publisher_->msg_;
+    msg.header.stamp = time;
+    fill_pose(&msg.pose);
+    pose_publisher_->unlockAndPublish();
+  }
+  if (legacy_pose_stamped_publisher_ && legacy_pose_stamped_publisher_->trylock()) {
+    geometry_msgs::PoseStamped& msg = legacy_pose_stamped_publisher_->msg_;
+    msg.header.stamp = time;
+    fill_pose(&msg.pose);
+    legacy_pose_stamped_publisher_->unlockAndPublish();
+  }
+  if (legacy_pose_publisher_ && legacy_pose_publisher_->trylock()) {
+    fill_pose(&legacy_pose_publisher_->msg_);
+    legacy_pose_publisher_->unlockAndPublish();
+  }
+
+  if (twist_publisher_->trylock()) {
+    const Eigen::Matrix<double, 6, 1> twist = model_cache->jacobian() * state.dq();
+    geometry_msgs::TwistStamped& msg = twist_publisher_->msg_;
+    msg.header.stamp = time;
+    msg.twist.linear.x = twist(0);
+    msg.twist.linear.y = twist(1);
+    msg.twist.linear.z = twist(2);
+    msg.twist.angular.x = twist(3);
+    msg.twist.angular.y = twist(4);
+    msg.twist.angular.z = twist(5);
+    twist_publisher_->unlockAndPublish();
+  }
+
+  if (wrench_publisher_->trylock()) {
+    const RobotStateView::Vector6dMap wrench = state.oFExtHatK();
+    geometry_msgs::WrenchStamped& msg = wrench_publisher_->msg_;
+    msg.header.stamp = time;
+    msg.wrench.force.x = wrench(0);
+    msg.wrench.force.y = wrench(1);
+    msg.wrench.force.z = wrench(2);
+    msg.wrench.torque.x = wrench(3);
+    msg.wrench.torque.y = wrench(4);
+    msg.wrench.torque.z = wrench(5);
+    wrench_publisher_->unlockAndPublish();
+  }
+}
+
+}  // namespace franka_interactive_controllers
@@ -0,0 +1,54 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <filter_bank.h>
+
+#include <ros/ros.h>
+
+namespace franka_interactive_controllers {
+
+namespace {
+
+bool filterModeFromString(const std::string& name, FilterMode* mode) {
+  if (name == "none") {
+    *mode = FilterMode::kNone;
+  } else if (name == "first_order") {
+    *mode = FilterMode::kFirstOrder;
+  } else if (name == "second_order") {
+    *mode = FilterMode::kSecondOrder;
+  } else if (name == "rate_limited") {
+    *mode = FilterMode::kRateLimited;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool filterConfigFromParam(const ros::NodeHandle& node_handle,
+                           const std::string& controller_name,
+                           const std::string& group,
+                           FilterConfig* config) {
+  const std::string prefix = "filters/" + group + "/";
+
+  std::string mode;
+  if (node_handle.getParam(prefix + "mode", mode) && !filterModeFromString(mode, &config->mode)) {
+    ROS_ERROR_STREAM(controller_name << ": Invalid " << prefix << "mode " << mode
+                     << " (expected none, first_order, second_order or rate_limited)");
+    return false;
+  }
+  node_handle.getParam(prefix + "time_constant", config->time_constant);
+  node_handle.getParam(prefix + "rate_limit", config->rate_limit);
+
+  if (config->time_constant < 0.0) {
+    ROS_ERROR_STREAM(controller_name << ": " << prefix << "time_constant must be >= 0");
+    return false;
+  }
+  if (config->mode == FilterMode::kRateLimited && config->rate_limit <= 0.0) {
+    ROS_ERROR_STREAM(controller_name << ": " << prefix << "rate_limit must be > 0");
+    return false;
+  }
+  return true;
+}
+
+}  // namespace franka_interactive_controllers
@@ -0,0 +1,105 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+#include <flight_log.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace franka_interactive_controllers {
+
+bool FlightLog::open(const std::string& path, std::string* error) {
+  close();
+  const int file = ::open(path.c_str(), O_RDONLY);
+  if (file < 0) {
+    *error = "Could not open " + path + ": " + std::strerror(errno);
+    return false;
+  }
+  struct stat status;
+  if (fstat(file, &status) != 0 ||
+      static_cast<std::size_t>(status.st_size) < sizeof(FlightLogHeader)) {
+    *error = path + " is not a flight log";
+    ::close(file);
+    return false;
+  }
+  void* data = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, file, 0);
+  ::close(file);
+  if (data == MAP_FAILED) {
+    *error = "Could not map " + path + ": " + std::strerror(errno);
+    return false;
+  }
+  data_ = static_cast<const char*>(data);
+  mapped_size_ = static_cast<std::size_t>(status.st_size);
+  path_ = path;
+
+  const FlightLogHeader& log_header = header();
+  bool valid = std::memcmp(log_header.magic, kFlightLogMagic, sizeof(log_header.magic)) == 0 &&
+               log_header.version == kFlightLogVersion &&
+               log_header.header_size >= sizeof(FlightLogHeader) &&
+               log_header.sample_size > 0 && log_header.sample_size % 8 == 0 &&
+               log_header.field_count <= kFlightLogMaxFields;
+  for (uint32_t f = 0; valid && f < log_header.field_count; ++f) {
+    const FlightLogField& log_field = log_header.fields[f];
+    valid = log_field.offset % 8 == 0 &&
+            log_field.offset + 8 * log_field.count <= log_header.sample_size;
+  }
+  if (!valid) {
+    *error = path + " is not a flight log of version " + std::to_string(kFlightLogVersion);
+    close();
+    return false;
+  }
+
+  // sample_count is updated as the samples land; trust the file size if it is shorter
+  const uint64_t on_disk =
+      mapped_size_ > log_header.header_size
+          ? (mapped_size_ - log_header.header_size) / log_header.sample_size
+          : 0;
+  size_ = std::min(log_header.sample_count, on_disk);
+  return true;
+}
+
+bool FlightLog::lock(std::string* error) {
+  if (data_ == nullptr) {
+    *error = "No flight log open";
+    return false;
+  }
+  void* data = const_cast<char*>(data_);
+  madvise(data, mapped_size_, MADV_WILLNEED);
+  if (mlock(data, mapped_size_) == 0) {
+    return true;
+  }
+  *error = "Could not lock " + path_ + " in memory: " + std::strerror(errno);
+  // Fault in every page at least
+  const std::size_t page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  volatile char sink = 0;
+  for (std::size_t offset = 0; offset < mapped_size_; offset += page_size) {
+    sink = sink + data_[offset];
+  }
+  return false;
+}
+
+void FlightLog::close() {
+  if (data_ != nullptr) {
+    munmap(const_cast<char*>(data_), mapped_size_);
+  }
+  data_ = nullptr;
+  mapped_size_ = 0;
+  size_ = 0;
+}
+
+const FlightLogField* FlightLog::field(const char* name) const {
+  const FlightLogHeader& log_header = header();
+  for (uint32_t f = 0; f < log_header.field_count; ++f) {
+    if (std::strncmp(log_header.fields[f].name, name, sizeof(log_header.fields[f].name)) == 0) {
+      return &log_header.fields[f];
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace franka_interactive_controllers
@@ -0,0 +1,361 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// SPSC ring drained by a writer thread into a chunked, memory-mapped flight log, see
+// flight_recorder.h.
+#include <flight_recorder.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include <Eigen/Core>
+
+#include <ros/ros.h>
+
+namespace franka_interactive_controllers {
+
+namespace {
+
+constexpr std::size_t kChunkBytes = 4 << 20;
+constexpr auto kWriteInterval = std::chrono::milliseconds(2);
+
+}  // namespace
+
+constexpr uint32_t FlightRecorder::kStateFields;
+constexpr std::size_t FlightRecorder::kCapacity;
+
+std::size_t flightSampleFields(std::array<FlightLogField, kFlightLogMaxFields>* fields) {
+  std::size_t count = 0;
+  auto add = [&](const char* name, FlightLogType type, std::size_t size, std::size_t offset) {
+    FlightLogField& field = (*fields)[count++];
+    std::memset(&field, 0, sizeof(field));
+    std::strncpy(field.name, name, sizeof(field.name) - 1);
+    field.type = type;
+    field.count = static_cast<uint32_t>(size);
+    field.offset = static_cast<uint32_t>(offset);
+  };
+#define FLIGHT_SAMPLE_FIELD_(name, type)                                                  \
+  add(#name, type, sizeof(FlightSample::name) / sizeof(double), offsetof(FlightSample, name))
+  FLIGHT_SAMPLE_FIELD_(sequence, FlightLogType::kUInt64);
+  FLIGHT_SAMPLE_FIELD_(time, FlightLogType::kFloat64);
+  FLIGHT_SAMPLE_FIELD_(period, FlightLogType::kFloat64);
+  FLIGHT_SAMPLE_FIELD_(q, FlightLogType::kFloat64);
+  FLIGHT_SAMPLE_FIELD_(dq, FlightLogType::kFloat64);
+  FLIGHT_SAMPLE_FIELD_(tau_J, FlightLogType::kFloat64);
+  FLIGHT_SAMPLE_FIELD_(tau_task, FlightLogType::kFloat64);
+  FLIGHT_SAMPLE_FIELD_(tau_coriolis, FlightLogType::kFloat64);
+  FLIGHT_SAMPLE_FIELD_(tau_d, FlightLogType::kFloat64);
+  FLIGHT_SAMPLE_FIELD_(O_T_EE, FlightLogType::kFloat64);
+  FLIGHT_SAMPLE_FIELD_(position_d, FlightLogType::kFloat64);
+  FLIGHT_SAMPLE_FIELD_(orientation_d, FlightLogType::kFloat64);
+  FLIGHT_SAMPLE_FIELD_(cartesian_stiffness, FlightLogType::kFloat64);
+  FLIGHT_SAMPLE_FIELD_(cartesian_damping, FlightLogType::kFloat64);
+  FLIGHT_SAMPLE_FIELD_(nullspace_stiffness, FlightLogType::kFloat64);
+  FLIGHT_SAMPLE_FIELD_(nullspace_damping, FlightLogType::kFloat64);
+#undef FLIGHT_SAMPLE_FIELD_
+  return count;
+}
+
+FlightRecorder::~FlightRecorder() {
+  recording_.store(false, std::memory_order_release);
+  running_.store(false, std::memory_order_release);
+  if (writer_thread_.joinable()) {
+    writer_thread_.join();
+  }
+  std::lock_guard<std::mutex> lock(file_mutex_);
+  if (file_ >= 0) {
+    drainRing();
+    closeFile();
+  }
+}
+
+bool FlightRecorder::init(ros::NodeHandle& node_handle, const std::string& controller_name) {
+  static_assert(sizeof(double) == sizeof(uint64_t), "FlightSample fields are 8 bytes each");
+  static_assert((kCapacity & (kCapacity - 1)) == 0, "kCapacity must be a power of two");
+  controller_name_ = controller_name;
+
+  bool enabled = false;
+  node_handle.getParam("flight_recorder/enabled", enabled);
+  if (!enabled) {
+    return true;
+  }
+  directory_ = "/tmp";
+  node_handle.getParam("flight_recorder/directory", directory_);
+  prefix_ = controller_name;
+  node_handle.getParam("flight_recorder/prefix", prefix_);
+  if (access(directory_.c_str(), W_OK) != 0) {
+    ROS_ERROR_STREAM(controller_name << ": flight_recorder/directory " << directory_
+                     << " is not writable, aborting controller init!");
+    return false;
+  }
+
+  ring_ = std::make_unique<FlightSample[]>(kCapacity);
+  head_.store(0, std::memory_order_relaxed);
+  tail_.store(0, std::memory_order_relaxed);
+
+  start_service_ = node_handle.advertiseService("flight_recorder/start",
+                                                &FlightRecorder::startCallback, this);
+  stop_service_ = node_handle.advertiseService("flight_recorder/stop",
+                                               &FlightRecorder::stopCallback, this);
+  segment_service_ = node_handle.advertiseService("flight_recorder/segment",
+                                                  &FlightRecorder::segmentCallback, this);
+
+  running_.store(true, std::memory_order_release);
+  writer_thread_ = std::thread(&FlightRecorder::writerLoop, this);
+  ROS_INFO_STREAM(controller_name << ": Flight recorder ready, logs go to " << directory_);
+  return true;
+}
+
+FlightSample* FlightRecorder::claim(const ros::Time& time, const ros::Duration& period,
+                                    const RobotStateView& state) {
+  const uint64_t sequence = ticks_++;
+  if (!recording_.load(std::memory_order_acquire)) {
+    return nullptr;
+  }
+  claimed_ = head_.load(std::memory_order_relaxed);
+  if (claimed_ - tail_.load(std::memory_order_acquire) >= kCapacity) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  FlightSample* sample = &ring_[claimed_ & (kCapacity - 1)];
+  std::memset(sample, 0, sizeof(FlightSample));
+  sample->sequence = sequence;
+  sample->time = time.toSec();
+  sample->period = period.toSec();
+  Eigen::Map<Eigen::Matrix<double, 7, 1>>(sample->q.data()) = state.q();
+  Eigen::Map<Eigen::Matrix<double, 7, 1>>(sample->dq.data()) = state.dq();
+  Eigen::Map<Eigen::Matrix<double, 7, 1>>(sample->tau_J.data()) = state.tauJ();
+  Eigen::Map<Eigen::Matrix4d>(sample->O_T_EE.data()) = state.oTEE();
+  return sample;
+}
+
+bool FlightRecorder::startCallback(std_srvs::Trigger::Request& /*request*/,
+                                   std_srvs::Trigger::Response& response) {
+  std::lock_guard<std::mutex> lock(file_mutex_);
+  if (file_ >= 0) {
+    response.success = false;
+    response.message = "Already recording to " + path_;
+    return true;
+  }
+
+  const auto now = std::chrono::system_clock::now();
+  start_time_ns_ =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+  const std::time_t now_c = std::chrono::system_clock::to_time_t(now);
+  std::tm local_time;
+  localtime_r(&now_c, &local_time);
+  char stamp[32];
+  std::strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", &local_time);
+  stamp_ = stamp;
+  segment_ = 0;
+
+  std::string error;
+  if (!openFile(&error)) {
+    response.success = false;
+    response.message = error;
+    return true;
+  }
+  // Drop samples a stopped recording left in the ring, then let the RT loop write again
+  tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+  dropped_at_start_ = dropped_.load(std::memory_order_relaxed);
+  recording_.store(true, std::memory_order_release);
+
+  response.success = true;
+  response.message = path_;
+  ROS_INFO_STREAM(controller_name_ << ": Flight recorder writing to " << path_);
+  return true;
+}
+
+bool FlightRecorder::stopCallback(std_srvs::Trigger::Request& /*request*/,
+                                  std_srvs::Trigger::Response& response) {
+  recording_.store(false, std::memory_order_release);
+  std::lock_guard<std::mutex> lock(file_mutex_);
+  if (file_ < 0) {
+    response.success = false;
+    response.message = "Not recording";
+    return true;
+  }
+  drainRing();
+  const std::string path = path_;
+  const uint64_t samples = sample_count_;
+  const uint64_t dropped = dropped_.load(std::memory_order_relaxed) - dropped_at_start_;
+  closeFile();
+
+  response.success = !write_failed_;
+  response.message = path + ": " + std::to_string(samples) + " samples, " +
+                     std::to_string(dropped) + " dropped";
+  ROS_INFO_STREAM(controller_name_ << ": Flight recorder closed " << response.message);
+  return true;
+}
+
+bool FlightRecorder::segmentCallback(std_srvs::Trigger::Request& /*request*/,
+                                     std_srvs::Trigger::Response& response) {
+  std::lock_guard<std::mutex> lock(file_mutex_);
+  if (file_ < 0) {
+    response.success = false;
+    response.message = "Not recording";
+    return true;
+  }
+  // The RT loop keeps filling the ring while the files are switched; nothing is lost
+  drainRing();
+  closeFile();
+  ++segment_;
+  std::string error;
+  if (!openFile(&error)) {
+    recording_.store(false, std::memory_order_release);
+    response.success = false;
+    response.message = error;
+    return true;
+  }
+  response.success = true;
+  response.message = path_;
+  ROS_INFO_STREAM(controller_name_ << ": Flight recorder continuing in " << path_);
+  return true;
+}
+
+bool FlightRecorder::openFile(std::string* error) {
+  char suffix[16];
+  std::snprintf(suffix, sizeof(suffix), "_%03u.flight", segment_);
+  path_ = directory_ + "/" + prefix_ + "_" + stamp_ + suffix;
+  file_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (file_ < 0) {
+    *error = "Could not open " + path_ + ": " + std::strerror(errno);
+    return false;
+  }
+
+  FlightLogHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kFlightLogMagic, sizeof(header.magic));
+  header.version = kFlightLogVersion;
+  header.header_size = kFlightLogHeaderSize;
+  header.sample_size = sizeof(FlightSample);
+  std::array<FlightLogField, kFlightLogMaxFields> fields;
+  header.field_count = static_cast<uint32_t>(flightSampleFields(&fields));
+  std::copy(fields.begin(), fields.end(), header.fields);
+  header.start_time_ns = start_time_ns_;
+  header.segment = segment_;
+  std::strncpy(header.controller, controller_name_.c_str(), sizeof(header.controller) - 1);
+
+  write_failed_ = false;
+  sample_count_ = 0;
+  write_offset_ = kFlightLogHeaderSize;
+  chunk_ = nullptr;
+  if (!mapChunk(0)) {
+    *error = "Could not map " + path_ + ": " + std::strerror(errno);
+    ::close(file_);
+    file_ = -1;
+    return false;
+  }
+  std::memcpy(chunk_, &header, sizeof(header));
+  return true;
+}
+
+void FlightRecorder::closeFile() {
+  writeSampleCount();
+  if (chunk_ != nullptr) {
+    munmap(chunk_, kChunkBytes);
+    chunk_ = nullptr;
+  }
+  // Cut the preallocated tail of the last chunk
+  if (ftruncate(file_, static_cast<off_t>(write_offset_)) != 0) {
+    write_failed_ = true;
+  }
+  ::close(file_);
+  file_ = -1;
+}
+
+bool FlightRecorder::mapChunk(std::size_t index) {
+  if (chunk_ != nullptr) {
+    munmap(chunk_, kChunkBytes);
+    chunk_ = nullptr;
+  }
+  const off_t offset = static_cast<off_t>(index * kChunkBytes);
+  if (ftruncate(file_, offset + static_cast<off_t>(kChunkBytes)) != 0) {
+    return false;
+  }
+  void* chunk = mmap(nullptr, kChunkBytes, PROT_READ | PROT_WRITE, MAP_SHARED, file_, offset);
+  if (chunk == MAP_FAILED) {
+    return false;
+  }
+  chunk_ = static_cast<char*>(chunk);
+  chunk_index_ = index;
+  return true;
+}
+
+bool FlightRecorder::appendBytes(const char* data, std::size_t size) {
+  while (size > 0) {
+    const std::size_t index = write_offset_ / kChunkBytes;
+    if (index != chunk_index_ && !mapChunk(index)) {
+      return false;
+    }
+    const std::size_t position = write_offset_ - index * kChunkBytes;
+    const std::size_t count = std::min(size, kChunkBytes - position);
+    std::memcpy(chunk_ + position, data, count);
+    write_offset_ += count;
+    data += count;
+    size -= count;
+  }
+  return true;
+}
+
+void FlightRecorder::drainRing() {
+  const uint64_t head = head_.load(std::memory_order_acquire);
+  uint64_t tail = tail_.load(std::memory_order_relaxed);
+  while (tail != head) {
+    // Contiguous run up to the end of the ring
+    const std::size_t index = tail & (kCapacity - 1);
+    const std::size_t count =
+        static_cast<std::size_t>(std::min<uint64_t>(head - tail, kCapacity - index));
+    if (!write_failed_ &&
+        !appendBytes(reinterpret_cast<const char*>(&ring_[index]), count * sizeof(FlightSample))) {
+      write_failed_ = true;
+      ROS_ERROR_STREAM(controller_name_ << ": Flight recorder could not write " << path_ << ": "
+                       << std::strerror(errno));
+    }
+    if (!write_failed_) {
+      sample_count_ += count;
+    }
+    tail += count;
+    tail_.store(tail, std::memory_order_release);
+  }
+  writeSampleCount();
+}
+
+void FlightRecorder::writeSampleCount() {
+  // The first chunk, holding the header, is unmapped once the log grows past it
+  const off_t offset = static_cast<off_t>(offsetof(FlightLogHeader, sample_count));
+  if (pwrite(file_, &sample_count_, sizeof(sample_count_), offset) !=
+      static_cast<ssize_t>(sizeof(sample_count_))) {
+    write_failed_ = true;
+  }
+}
+
+void FlightRecorder::writerLoop() {
+  while (running_.load(std::memory_order_acquire)) {
+    {
+      std::lock_guard<std::mutex> lock(file_mutex_);
+      if (file_ >= 0) {
+        drainRing();
+      }
+    }
+    const uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped != dropped_reported_) {
+      ROS_WARN_STREAM(controller_name_ << ": Flight recorder dropped "
+                      << dropped - dropped_reported_ << " samples, writer behind");
+      dropped_reported_ = dropped;
+    }
+    std::this_thread::sleep_for(kWriteInterval);
+  }
+}
+
+}  // namespace franka_interactive_controllers
@@ -0,0 +1,63 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+
+#include <joint_goals.h>
+
+#include <cmath>
+
+#include <xmlrpcpp/XmlRpcValue.h>
+
+namespace franka_interactive_controllers {
+
+bool withinJointLimits(const JointGoal& q, std::string* error) {
+  for (size_t i = 0; i < q.size(); ++i) {
+    if (!std::isfinite(q[i]) || q[i] < kJointPositionMin[i] || q[i] > kJointPositionMax[i]) {
+      *error = "Joint " + std::to_string(i + 1) + " at " + std::to_string(q[i]) +
+               " is outside its limits [" + std::to_string(kJointPositionMin[i]) + ", " +
+               std::to_string(kJointPositionMax[i]) + "]";
+      return false;
+    }
+  }
+  return true;
+}
+
+bool loadJointGoals(const ros::NodeHandle& node_handle,
+                    const std::string& param,
+                    std::map<std::string, JointGoal>* goals,
+                    std::string* error) {
+  XmlRpc::XmlRpcValue goal_list;
+  if (!node_handle.getParam(param, goal_list) ||
+      goal_list.getType() != XmlRpc::XmlRpcValue::TypeStruct) {
+    *error = "No joint goals in " + node_handle.resolveName(param);
+    return false;
+  }
+
+  std::map<std::string, JointGoal> loaded;
+  for (auto& entry : goal_list) {
+    XmlRpc::XmlRpcValue& values = entry.second;
+    if (values.getType() != XmlRpc::XmlRpcValue::TypeArray || values.size() != 7) {
+      *error = "Joint goal " + entry.first + " is not a list of 7 joint positions";
+      return false;
+    }
+    JointGoal& goal = loaded[entry.first];
+    for (int i = 0; i < 7; ++i) {
+      if (values[i].getType() == XmlRpc::XmlRpcValue::TypeDouble) {
+        goal[i] = static_cast<double>(values[i]);
+      } else if (values[i].getType() == XmlRpc::XmlRpcValue::TypeInt) {
+        goal[i] = static_cast<int>(values[i]);
+      } else {
+        *error = "Joint goal " + entry.first + " is not a list of 7 joint positions";
+        return false;
+      }
+    }
+    std::string limit_error;
+    if (!withinJointLimits(goal, &limit_error)) {
+      *error = "Joint goal " + entry.first + ": " + limit_error;
+      return false;
+    }
+  }
+  goals->swap(loaded);
+  return true;
+}
+
+}  // namespace franka_interactive_controllers
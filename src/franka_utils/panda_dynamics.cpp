@@ -0,0 +1,379 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+
+#include <panda_dynamics.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include <Eigen/Dense>
+
+#include <panda_kinematics.h>
+
+namespace franka_interactive_controllers {
+
+namespace {
+
+using Parameters = PandaKinematicParameters;
+using Vector6d = Eigen::Matrix<double, 6, 1>;
+using Matrix6d = Eigen::Matrix<double, 6, 6>;
+
+struct LinkInertia {
+  double mass;
+  double com[3];
+  double inertia[6];  // ixx, ixy, ixz, iyy, iyz, izz about the center of mass, link frame
+};
+
+constexpr LinkInertia kLinkInertia[PandaDynamics::kJoints] = {
+    {4.970684, {3.875e-03, 2.081e-03, -4.762e-02},
+     {7.0337e-01, -1.3900e-04, 6.7720e-03, 7.0661e-01, 1.9169e-02, 9.1170e-03}},
+    {0.646926, {-3.141e-03, -2.872e-02, 3.495e-03},
+     {7.9620e-03, -3.9250e-03, 1.0254e-02, 2.8110e-02, 7.0400e-04, 2.5995e-02}},
+    {3.228604, {2.7518e-02, 3.9252e-02, -6.6502e-02},
+     {3.7242e-02, -4.7610e-03, -1.1396e-02, 3.6155e-02, -1.2805e-02, 1.0830e-02}},
+    {3.587895, {-5.317e-02, 1.04419e-01, 2.7454e-02},
+     {2.5853e-02, 7.7960e-03, -1.3320e-03, 1.9552e-02, 8.6410e-03, 2.8323e-02}},
+    {1.225946, {-1.1953e-02, 4.1065e-02, -3.8437e-02},
+     {3.5549e-02, -2.1170e-03, -4.0370e-03, 2.9474e-02, 2.2900e-04, 8.6270e-03}},
+    {1.666555, {6.0149e-02, -1.4117e-02, -1.0517e-02},
+     {1.9640e-03, 1.0900e-04, -1.1580e-03, 4.3540e-03, 3.4100e-04, 5.4330e-03}},
+    {7.35522e-01, {1.0517e-02, -4.252e-03, 6.1597e-02},
+     {1.2516e-02, -4.2800e-04, -1.1960e-03, 1.0027e-02, -7.4100e-04, 4.8150e-03}}};
+
+// Rotation and origin of frame i in frame i-1 (modified DH) for joint angle theta. alpha is a
+// multiple of pi/2, so its cosine and sine are exact.
+void jointTransform(int i, double theta, Eigen::Matrix3d* rotation, Eigen::Vector3d* origin) {
+  const double ca = Parameters::alpha(i) == 0 ? 1.0 : 0.0;
+  const double sa = static_cast<double>(Parameters::alpha(i));
+  const double ct = std::cos(theta), st = std::sin(theta);
+  *rotation << ct, -st, 0.0,
+               st * ca, ct * ca, -sa,
+               st * sa, ct * sa, ca;
+  *origin << Parameters::a(i), -Parameters::d(i) * sa, Parameters::d(i) * ca;
+}
+
+Eigen::Matrix3d skew(const Eigen::Vector3d& v) {
+  Eigen::Matrix3d result;
+  result << 0.0, -v.z(), v.y(),
+            v.z(), 0.0, -v.x(),
+            -v.y(), v.x(), 0.0;
+  return result;
+}
+
+// Spatial algebra in the base frame, vectors ordered (angular, linear) and linear parts taken
+// at the base origin (Featherstone's conventions).
+Vector6d motionCross(const Vector6d& v, const Vector6d& m) {
+  Vector6d result;
+  result.head<3>() = v.head<3>().cross(m.head<3>());
+  result.tail<3>() = v.head<3>().cross(m.tail<3>()) + v.tail<3>().cross(m.head<3>());
+  return result;
+}
+
+// u x* f
+Vector6d forceCross(const Vector6d& u, const Vector6d& f) {
+  Vector6d result;
+  result.head<3>() = u.head<3>().cross(f.head<3>()) + u.tail<3>().cross(f.tail<3>());
+  result.tail<3>() = u.head<3>().cross(f.tail<3>());
+  return result;
+}
+
+// Values of "key": number or "key": [numbers] in a flat JSON object.
+bool readJsonNumbers(const std::string& text, const std::string& key, int count, double* values) {
+  size_t position = text.find("\"" + key + "\"");
+  if (position == std::string::npos) {
+    return false;
+  }
+  position = text.find(':', position);
+  if (position == std::string::npos) {
+    return false;
+  }
+  const char* cursor = text.c_str() + position + 1;
+  while (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r') {
+    ++cursor;
+  }
+  const bool array = *cursor == '[';
+  if (array) {
+    ++cursor;
+  }
+  for (int i = 0; i < count; ++i) {
+    char* end = nullptr;
+    values[i] = std::strtod(cursor, &end);
+    if (end == cursor) {
+      return false;
+    }
+    cursor = end;
+    while (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r' ||
+           (array && *cursor == ',' && i + 1 < count)) {
+      ++cursor;
+    }
+  }
+  return !array || *cursor == ']';
+}
+
+}  // namespace
+
+bool PandaDynamics::readEndEffectorConfig(const std::string& path,
+                                          Load* load,
+                                          Eigen::Matrix4d* F_T_EE,
+                                          std::string* error) {
+  std::ifstream file(path);
+  if (!file) {
+    if (error != nullptr) {
+      *error = "could not open " + path;
+    }
+    return false;
+  }
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  const std::string text = buffer.str();
+
+  Load result;
+  Eigen::Matrix4d transformation;
+  const char* missing = nullptr;
+  if (!readJsonNumbers(text, "mass", 1, &result.mass)) {
+    missing = "mass";
+  } else if (!readJsonNumbers(text, "centerOfMass", 3, result.center_of_mass.data())) {
+    missing = "centerOfMass";
+  } else if (!readJsonNumbers(text, "inertia", 9, result.inertia.data())) {
+    missing = "inertia";
+  } else if (!readJsonNumbers(text, "transformation", 16, transformation.data())) {
+    missing = "transformation";
+  }
+  if (missing != nullptr) {
+    if (error != nullptr) {
+      *error = path + ": missing or malformed field " + missing;
+    }
+    return false;
+  }
+  *load = result;
+  if (F_T_EE != nullptr) {
+    *F_T_EE = transformation;
+  }
+  return true;
+}
+
+PandaDynamics::PandaDynamics() {
+  setLoad(Load());
+}
+
+PandaDynamics::PandaDynamics(const Load& load) {
+  setLoad(load);
+}
+
+void PandaDynamics::setLoad(const Load& load) {
+  load_ = load;
+  for (int i = 0; i < kJoints; ++i) {
+    const LinkInertia& link = kLinkInertia[i];
+    Body& body = bodies_[i];
+    body.mass = link.mass;
+    body.com << link.com[0], link.com[1], link.com[2];
+    body.inertia << link.inertia[0], link.inertia[1], link.inertia[2],
+                    link.inertia[1], link.inertia[3], link.inertia[4],
+                    link.inertia[2], link.inertia[4], link.inertia[5];
+  }
+  if (load.mass <= 0.0) {
+    return;
+  }
+
+  // Link 7 combined with the load on the flange (parallel axis theorem)
+  Body& link = bodies_[kJoints - 1];
+  const Eigen::Vector3d load_com =
+      load.center_of_mass + Eigen::Vector3d(0.0, 0.0, Parameters::d(kJoints));
+  const double mass = link.mass + load.mass;
+  const Eigen::Vector3d com = (link.mass * link.com + load.mass * load_com) / mass;
+  const Eigen::Vector3d r_link = link.com - com;
+  const Eigen::Vector3d r_load = load_com - com;
+  link.inertia += -link.mass * skew(r_link) * skew(r_link) + load.inertia -
+                  load.mass * skew(r_load) * skew(r_load);
+  link.mass = mass;
+  link.com = com;
+}
+
+void PandaDynamics::inverseDynamics(const Vector7d& q,
+                                    const Vector7d& dq,
+                                    const Vector7d& ddq,
+                                    const Eigen::Vector3d& gravity_earth,
+                                    Vector7d* tau) const {
+  Eigen::Matrix3d rotations[kJoints];  // frame i in frame i-1
+  Eigen::Vector3d origins[kJoints];    // origin of frame i in frame i-1
+  Eigen::Vector3d forces[kJoints], moments[kJoints];
+
+  // Forward pass: velocities and accelerations in link frames. Gravity is applied as an
+  // acceleration of the base.
+  Eigen::Vector3d omega = Eigen::Vector3d::Zero();
+  Eigen::Vector3d domega = Eigen::Vector3d::Zero();
+  Eigen::Vector3d acceleration = -gravity_earth;
+  const Eigen::Vector3d z = Eigen::Vector3d::UnitZ();
+  for (int i = 0; i < kJoints; ++i) {
+    jointTransform(i, q(i), &rotations[i], &origins[i]);
+
+    const Eigen::Matrix3d R_T = rotations[i].transpose();
+    acceleration =
+        R_T * (acceleration + domega.cross(origins[i]) + omega.cross(omega.cross(origins[i])));
+    const Eigen::Vector3d omega_parent = R_T * omega;
+    omega = omega_parent + dq(i) * z;
+    domega = R_T * domega + omega_parent.cross(dq(i) * z) + ddq(i) * z;
+
+    const Body& body = bodies_[i];
+    const Eigen::Vector3d com_acceleration =
+        acceleration + domega.cross(body.com) + omega.cross(omega.cross(body.com));
+    forces[i] = body.mass * com_acceleration;
+    moments[i] = body.inertia * domega + omega.cross(body.inertia * omega);
+  }
+
+  // Backward pass: wrenches transmitted by each joint.
+  Eigen::Vector3d force = Eigen::Vector3d::Zero();
+  Eigen::Vector3d moment = Eigen::Vector3d::Zero();
+  for (int i = kJoints - 1; i >= 0; --i) {
+    Eigen::Vector3d child_force = Eigen::Vector3d::Zero();
+    Eigen::Vector3d child_moment = Eigen::Vector3d::Zero();
+    if (i < kJoints - 1) {
+      child_force = rotations[i + 1] * force;
+      child_moment = rotations[i + 1] * moment + origins[i + 1].cross(child_force);
+    }
+    force = forces[i] + child_force;
+    moment = moments[i] + child_moment + bodies_[i].com.cross(forces[i]);
+    (*tau)(i) = moment.z();
+  }
+}
+
+void PandaDynamics::massMatrix(const Vector7d& q, Matrix7d* mass) const {
+  Eigen::Matrix3d rotations[kJoints];
+  Eigen::Vector3d origins[kJoints];
+  for (int i = 0; i < kJoints; ++i) {
+    jointTransform(i, q(i), &rotations[i], &origins[i]);
+  }
+
+  // Composite bodies of links i..7 in frame i: mass, first moment of mass and inertia about the
+  // frame origin. The unit acceleration of joint i needs the wrench (n, f) = (I z, z x h) at its
+  // origin, which is carried down the chain to give the coupling with every joint below.
+  double composite_mass = 0.0;
+  Eigen::Vector3d composite_moment = Eigen::Vector3d::Zero();
+  Eigen::Matrix3d composite_inertia = Eigen::Matrix3d::Zero();
+  for (int i = kJoints - 1; i >= 0; --i) {
+    const Body& body = bodies_[i];
+    const Eigen::Matrix3d com_skew = skew(body.com);
+    composite_mass += body.mass;
+    composite_moment += body.mass * body.com;
+    composite_inertia += body.inertia - body.mass * com_skew * com_skew;
+
+    Eigen::Vector3d moment = composite_inertia.col(2);
+    Eigen::Vector3d force = Eigen::Vector3d::UnitZ().cross(composite_moment);
+    (*mass)(i, i) = moment.z();
+    for (int j = i; j > 0; --j) {
+      force = rotations[j] * force;
+      moment = rotations[j] * moment + origins[j].cross(force);
+      (*mass)(i, j - 1) = moment.z();
+      (*mass)(j - 1, i) = moment.z();
+    }
+
+    if (i > 0) {
+      // Move the composite body to frame i-1
+      const Eigen::Matrix3d& R = rotations[i];
+      const Eigen::Vector3d& p = origins[i];
+      const Eigen::Vector3d moment_parent = R * composite_moment;
+      const Eigen::Matrix3d p_skew = skew(p);
+      const Eigen::Matrix3d moment_skew = skew(moment_parent);
+      composite_inertia = R * composite_inertia * R.transpose() -
+                          composite_mass * p_skew * p_skew - p_skew * moment_skew -
+                          moment_skew * p_skew;
+      composite_moment = moment_parent + composite_mass * p;
+    }
+  }
+}
+
+void PandaDynamics::coriolisMatrix(const Vector7d& q,
+                                   const Vector7d& dq,
+                                   Matrix7d* coriolis) const {
+  // C = sum_i J_i^T (I_i dJ_i/dt + B_i J_i) with all quantities in the base frame, J_i the
+  // Jacobian of link i (columns S_j, j <= i), I_i its spatial inertia and
+  // B_i = 1/2 (V_i x* I_i - I_i V_i x + (I_i V_i) x-bar*). Then C dq = V x* I V summed over the
+  // links, the Coriolis/centrifugal torques, and dM/dt - 2 C is skew-symmetric since
+  // dI_i/dt = B_i + B_i^T. Summing over the links i..7 into composites gives
+  // C_jk = S_j^T (Ic_m dS_k/dt + Bc_m S_k) with m = max(j, k). As I_i is symmetric,
+  // B_i = 1/2 (X_i + X_i^T + (I_i V_i) x-bar*) with X_i = V_i x* I_i, so only X_i and the
+  // momenta I_i V_i are summed, in 3x3 blocks.
+  Vector6d axes[kJoints];        // S_j
+  Vector6d axis_rates[kJoints];  // dS_j/dt = V_j x S_j
+  Matrix6d composite_inertia[kJoints], composite_x[kJoints];
+  Vector6d composite_momentum[kJoints];
+
+  Eigen::Matrix3d rotation = Eigen::Matrix3d::Identity();
+  Eigen::Vector3d origin = Eigen::Vector3d::Zero();
+  Vector6d velocity = Vector6d::Zero();
+  for (int i = 0; i < kJoints; ++i) {
+    Eigen::Matrix3d joint_rotation;
+    Eigen::Vector3d joint_origin;
+    jointTransform(i, q(i), &joint_rotation, &joint_origin);
+    origin += rotation * joint_origin;
+    rotation = rotation * joint_rotation;
+
+    const Eigen::Vector3d axis = rotation.col(2);
+    axes[i] << axis, origin.cross(axis);
+    velocity += axes[i] * dq(i);
+    axis_rates[i] = motionCross(velocity, axes[i]);
+
+    // Spatial inertia about the base origin: rotational part, first moment of mass h and mass
+    const Body& body = bodies_[i];
+    const Eigen::Vector3d com = origin + rotation * body.com;
+    const Eigen::Vector3d first_moment = body.mass * com;
+    const Eigen::Matrix3d h_skew = skew(first_moment);
+    const Eigen::Matrix3d rotational =
+        rotation * body.inertia * rotation.transpose() - h_skew * skew(com);
+    Matrix6d& inertia = composite_inertia[i];
+    inertia.topLeftCorner<3, 3>() = rotational;
+    inertia.topRightCorner<3, 3>() = h_skew;
+    inertia.bottomLeftCorner<3, 3>() = -h_skew;
+    inertia.bottomRightCorner<3, 3>() = body.mass * Eigen::Matrix3d::Identity();
+
+    const Eigen::Vector3d omega = velocity.head<3>();
+    const Eigen::Vector3d linear = velocity.tail<3>();
+    const Eigen::Matrix3d omega_skew = skew(omega);
+    const Eigen::Matrix3d linear_skew = skew(linear);
+    Matrix6d& x = composite_x[i];
+    x.topLeftCorner<3, 3>() = omega_skew * rotational - linear_skew * h_skew;
+    x.topRightCorner<3, 3>() = omega_skew * h_skew + body.mass * linear_skew;
+    x.bottomLeftCorner<3, 3>() = -omega_skew * h_skew;
+    x.bottomRightCorner<3, 3>() = body.mass * omega_skew;
+    composite_momentum[i] << rotational * omega + first_moment.cross(linear),
+        body.mass * linear - first_moment.cross(omega);
+  }
+  for (int i = kJoints - 2; i >= 0; --i) {
+    composite_inertia[i] += composite_inertia[i + 1];
+    composite_x[i] += composite_x[i + 1];
+    composite_momentum[i] += composite_momentum[i + 1];
+  }
+
+  for (int k = 0; k < kJoints; ++k) {
+    const Vector6d x_axis = composite_x[k] * axes[k];
+    const Vector6d x_transpose_axis = composite_x[k].transpose() * axes[k];
+    const Vector6d momentum_cross = forceCross(axes[k], composite_momentum[k]);
+    // Ic_k dS_k/dt + Bc_k S_k for row j <= k, Ic_k S_k and Bc_k^T S_k for column j < k
+    const Vector6d column = composite_inertia[k] * axis_rates[k] +
+                            0.5 * (x_axis + x_transpose_axis + momentum_cross);
+    const Vector6d inertia_row = composite_inertia[k] * axes[k];
+    const Vector6d b_row = 0.5 * (x_transpose_axis + x_axis - momentum_cross);
+    for (int j = 0; j <= k; ++j) {
+      (*coriolis)(j, k) = axes[j].dot(column);
+    }
+    for (int j = 0; j < k; ++j) {
+      (*coriolis)(k, j) = inertia_row.dot(axis_rates[j]) + b_row.dot(axes[j]);
+    }
+  }
+}
+
+void PandaDynamics::coriolisVector(const Vector7d& q,
+                                   const Vector7d& dq,
+                                   Vector7d* coriolis) const {
+  inverseDynamics(q, dq, Vector7d::Zero(), Eigen::Vector3d::Zero(), coriolis);
+}
+
+void PandaDynamics::gravityVector(const Vector7d& q,
+                                  const Eigen::Vector3d& gravity_earth,
+                                  Vector7d* gravity) const {
+  inverseDynamics(q, Vector7d::Zero(), Vector7d::Zero(), gravity_earth, gravity);
+}
+
+}  // namespace franka_interactive_controllers
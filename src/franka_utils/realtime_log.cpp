@@ -0,0 +1,146 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Bounded multi-producer ring (Vyukov) drained by a single non-RT thread, see realtime_log.h.
+
+#include <realtime_log.h>
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+
+#include <ros/console.h>
+
+namespace franka_interactive_controllers {
+
+namespace {
+
+constexpr auto kDrainInterval = std::chrono::milliseconds(5);
+
+int64_t steadyNowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+RealtimeLogger& RealtimeLogger::instance() {
+  static RealtimeLogger logger;
+  return logger;
+}
+
+RealtimeLogger::RealtimeLogger() {
+  static_assert((kCapacity & (kCapacity - 1)) == 0, "kCapacity must be a power of two");
+  for (std::size_t i = 0; i < kCapacity; ++i) {
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  drain_thread_ = std::thread(&RealtimeLogger::drain, this);
+}
+
+RealtimeLogger::~RealtimeLogger() {
+  running_.store(false, std::memory_order_release);
+  if (drain_thread_.joinable()) {
+    drain_thread_.join();
+  }
+}
+
+bool RealtimeLogger::log(RealtimeLogSite* site, RealtimeLogLevel level, const char* format, ...) {
+  // Per site rate limit, decided before touching the ring
+  if (site->min_period > 0.0) {
+    const int64_t now = steadyNowNs();
+    int64_t next = site->next_ns.load(std::memory_order_relaxed);
+    if (now < next ||
+        !site->next_ns.compare_exchange_strong(next,
+                                               now + static_cast<int64_t>(site->min_period * 1e9),
+                                               std::memory_order_relaxed)) {
+      site->suppressed.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+  }
+
+  // Claim a slot, or drop the message if the drain thread is behind
+  std::size_t position = enqueue_position_.load(std::memory_order_relaxed);
+  Slot* slot;
+  for (;;) {
+    slot = &slots_[position & (kCapacity - 1)];
+    const std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    const auto difference =
+        static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+    if (difference == 0) {
+      if (enqueue_position_.compare_exchange_weak(position, position + 1,
+                                                  std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (difference < 0) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    } else {
+      position = enqueue_position_.load(std::memory_order_relaxed);
+    }
+  }
+
+  slot->level = level;
+  slot->suppressed = site->suppressed.exchange(0, std::memory_order_relaxed);
+  va_list arguments;
+  va_start(arguments, format);
+  std::vsnprintf(slot->message, kMessageSize, format, arguments);
+  va_end(arguments);
+  slot->sequence.store(position + 1, std::memory_order_release);
+  return true;
+}
+
+bool RealtimeLogger::forwardNext() {
+  Slot& slot = slots_[dequeue_position_ & (kCapacity - 1)];
+  if (slot.sequence.load(std::memory_order_acquire) != dequeue_position_ + 1) {
+    return false;
+  }
+
+  char text[kMessageSize + 48];
+  if (slot.suppressed > 0) {
+    std::snprintf(text, sizeof(text), "%s (%u similar messages suppressed)", slot.message,
+                  slot.suppressed);
+  } else {
+    std::snprintf(text, sizeof(text), "%s", slot.message);
+  }
+  const RealtimeLogLevel level = slot.level;
+  slot.sequence.store(dequeue_position_ + kCapacity, std::memory_order_release);
+  ++dequeue_position_;
+
+  switch (level) {
+    case RealtimeLogLevel::kDebug:
+      ROS_DEBUG("%s", text);
+      break;
+    case RealtimeLogLevel::kInfo:
+      ROS_INFO("%s", text);
+      break;
+    case RealtimeLogLevel::kWarn:
+      ROS_WARN("%s", text);
+      break;
+    case RealtimeLogLevel::kError:
+      ROS_ERROR("%s", text);
+      break;
+  }
+  return true;
+}
+
+void RealtimeLogger::drain() {
+  bool running = true;
+  while (running) {
+    running = running_.load(std::memory_order_acquire);
+    while (forwardNext()) {
+    }
+    const uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped != dropped_reported_) {
+      ROS_WARN("RealtimeLogger: %lu messages dropped, ring buffer full (%lu in total)",
+               static_cast<unsigned long>(dropped - dropped_reported_),
+               static_cast<unsigned long>(dropped));
+      dropped_reported_ = dropped;
+    }
+    if (running) {
+      std::this_thread::sleep_for(kDrainInterval);
+    }
+  }
+}
+
+}  // namespace franka_interactive_controllers
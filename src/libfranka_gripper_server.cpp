@@ -0,0 +1,472 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+
+// Long-lived libfranka gripper server: keeps one connection to the gripper open and executes
+// open, close, grasp, move and homing commands as they arrive, a newer command preempting the
+// running one through franka::Gripper::stop(), instead of one process (and action client wait or
+// gripper connection) per command as franka_gripper_run_node and libfranka_gripper_run do. The
+// gripper state is published at ~publish_rate. Caution: it replaces franka_gripper, do not run
+// both for one gripper (franka_control_interactive.launch gripper_server:=true starts this one
+// under the name franka_gripper instead).
+//
+// In the private namespace:
+//   command       GripperCommand (service)   runs a command, returns when it is done, failed or
+//                                            preempted
+//   width         std_msgs/Float64 (topic)   streams move targets [m]; a target further than
+//                                            ~width_tolerance from the running one preempts it
+//   stop          Trigger (service)          stops the running command, drops the pending one
+//   state         GripperState (topic)       width, grasp and temperature at ~publish_rate
+//   joint_states  sensor_msgs/JointState     finger joints, for joint_state_publisher
+//
+// Usage:
+//   rosrun franka_interactive_controllers libfranka_gripper_server _robot_ip:=172.16.0.2
+//   rosservice call /libfranka_gripper_server/command "{command: 1, force: 40.0}"
+//   rostopic pub /libfranka_gripper_server/width std_msgs/Float64 "data: 0.04"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <franka/exception.h>
+#include <franka/gripper.h>
+
+#include <ros/ros.h>
+#include <sensor_msgs/JointState.h>
+#include <std_msgs/Float64.h>
+#include <std_srvs/Trigger.h>
+
+#include <franka_interactive_controllers/GripperCommand.h>
+#include <franka_interactive_controllers/GripperState.h>
+
+namespace {
+
+using franka_interactive_controllers::GripperCommand;
+using franka_interactive_controllers::GripperState;
+
+// Epsilons of close, any width counts as grasped (as franka_gripper_run_node)
+constexpr double kCloseEpsilon = 0.2;
+
+// Interval at which a preempt repeats stop() until the preempted command has returned
+constexpr std::chrono::milliseconds kStopRetryInterval(10);
+
+class GripperServer {
+ public:
+  explicit GripperServer(ros::NodeHandle& node_handle);
+
+  // Runs the commands until shutdown() is called.
+  void execute();
+  // Publishes the gripper state until shutdown() is called.
+  void publishState();
+  void shutdown();
+
+ private:
+  // One command; a service caller waits on done, a streamed width does not.
+  struct Command {
+    uint8_t type{GripperCommand::Request::OPEN};
+    double width{0.0};
+    double speed{0.0};
+    double force{0.0};
+    double epsilon_inner{0.0};
+    double epsilon_outer{0.0};
+    bool streamed{false};
+    bool preempted{false};
+    bool done{false};
+    bool success{false};
+    std::string message;
+  };
+
+  // Connected gripper, nullptr if the connection cannot be made.
+  std::shared_ptr<franka::Gripper> connect(std::string* error);
+  void run(Command* command);
+  bool preempted(const Command& command);
+  // Queues command in place of the pending one and preempts the running one; under mutex_.
+  void submit(const std::shared_ptr<Command>& command, std::unique_lock<std::mutex>* lock);
+  // Stops the running command with message as its result and returns once run() has returned
+  // from it; releases lock for the network calls.
+  void preempt(const std::string& message, std::unique_lock<std::mutex>* lock);
+  // Under mutex_
+  void finish(Command* command, bool success, const std::string& message);
+
+  bool commandCallback(GripperCommand::Request& request, GripperCommand::Response& response);
+  void widthCallback(const std_msgs::Float64& message);
+  bool stopCallback(std_srvs::Trigger::Request& request, std_srvs::Trigger::Response& response);
+
+  ros::NodeHandle node_handle_;
+  std::string robot_ip_;
+  std::string arm_id_;
+  double publish_rate_{30.0};
+  double default_speed_{0.1};
+  double default_force_{50.0};
+  double open_width_{0.08};
+  double width_tolerance_{0.002};
+
+  // Shared with the state thread; reset after a network error so the next use reconnects
+  std::mutex connect_mutex_;
+  std::shared_ptr<franka::Gripper> gripper_;
+  std::atomic<double> max_width_{0.0};
+
+  std::mutex mutex_;
+  std::condition_variable pending_changed_;
+  std::condition_variable running_changed_;
+  std::condition_variable command_done_;
+  std::shared_ptr<Command> pending_;
+  std::shared_ptr<Command> running_;
+  int stopping_{0};
+  bool active_{true};
+
+  ros::ServiceServer command_service_;
+  ros::ServiceServer stop_service_;
+  ros::Subscriber width_subscriber_;
+  ros::Publisher state_publisher_;
+  ros::Publisher joint_state_publisher_;
+};
+
+GripperServer::GripperServer(ros::NodeHandle& node_handle) : node_handle_(node_handle) {
+  node_handle_.param<std::string>("robot_ip", robot_ip_, "172.16.0.2");
+  node_handle_.param<std::string>("arm_id", arm_id_, "panda");
+  node_handle_.param<double>("publish_rate", publish_rate_, 30.0);
+  node_handle_.param<double>("speed", default_speed_, 0.1);
+  node_handle_.param<double>("force", default_force_, 50.0);
+  node_handle_.param<double>("open_width", open_width_, 0.08);
+  node_handle_.param<double>("width_tolerance", width_tolerance_, 0.002);
+  if (publish_rate_ <= 0.0) {
+    ROS_WARN_STREAM("GripperServer: publish_rate must be positive, using 30.0");
+    publish_rate_ = 30.0;
+  }
+
+  state_publisher_ = node_handle_.advertise<GripperState>("state", 1);
+  joint_state_publisher_ = node_handle_.advertise<sensor_msgs::JointState>("joint_states", 1);
+  command_service_ =
+      node_handle_.advertiseService("command", &GripperServer::commandCallback, this);
+  stop_service_ = node_handle_.advertiseService("stop", &GripperServer::stopCallback, this);
+  width_subscriber_ = node_handle_.subscribe("width", 1, &GripperServer::widthCallback, this,
+                                             ros::TransportHints().tcpNoDelay());
+}
+
+std::shared_ptr<franka::Gripper> GripperServer::connect(std::string* error) {
+  std::lock_guard<std::mutex> lock(connect_mutex_);
+  if (!gripper_) {
+    try {
+      gripper_ = std::make_shared<franka::Gripper>(robot_ip_);
+      ROS_INFO_STREAM("GripperServer: connected to " << robot_ip_);
+    } catch (const franka::Exception& ex) {
+      *error = std::string("Could not connect to the gripper at ") + robot_ip_ + ": " + ex.what();
+    }
+  }
+  return gripper_;
+}
+
+void GripperServer::execute() {
+  while (true) {
+    std::shared_ptr<Command> command;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      // A stop() still on its way must not hit the next command
+      pending_changed_.wait(lock, [this] { return (pending_ && stopping_ == 0) || !active_; });
+      if (!active_) {
+        break;
+      }
+      command = pending_;
+      pending_.reset();
+      running_ = command;
+    }
+    run(command.get());
+  }
+}
+
+void GripperServer::run(Command* command) {
+  std::string error;
+  std::shared_ptr<franka::Gripper> gripper = connect(&error);
+  bool success = false;
+  std::string message;
+  if (!gripper) {
+    message = error;
+  } else if (!preempted(*command)) {
+    // A preempt from here on stops the call below, if need be repeatedly
+    try {
+      switch (command->type) {
+        case GripperCommand::Request::OPEN:
+          success = gripper->move(open_width_, command->speed);
+          message = success ? "Opened" : "Could not open";
+          break;
+        case GripperCommand::Request::CLOSE:
+          success = gripper->grasp(0.0, command->speed, command->force, kCloseEpsilon,
+                                   kCloseEpsilon);
+          message = success ? "Closed" : "Could not close";
+          break;
+        case GripperCommand::Request::GRASP:
+          success = gripper->grasp(command->width, command->speed, command->force,
+                                   command->epsilon_inner, command->epsilon_outer);
+          message = success ? "Grasped" : "No object grasped at " + std::to_string(command->width);
+          break;
+        case GripperCommand::Request::MOVE:
+          success = gripper->move(command->width, command->speed);
+          message = success ? "Moved to " + std::to_string(command->width)
+                            : "Could not move to " + std::to_string(command->width);
+          break;
+        case GripperCommand::Request::HOMING:
+          success = gripper->homing();
+          message = success ? "Homed" : "Homing failed";
+          break;
+      }
+    } catch (const franka::NetworkException& ex) {
+      std::lock_guard<std::mutex> lock(connect_mutex_);
+      if (gripper_ == gripper) {
+        gripper_.reset();
+      }
+      message = std::string("Lost the gripper: ") + ex.what();
+    } catch (const franka::Exception& ex) {
+      // Also how a move or grasp ends when stop() interrupts it
+      message = ex.what();
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  running_.reset();
+  running_changed_.notify_all();
+  if (!command->preempted) {
+    finish(command, success, message);
+  }
+}
+
+bool GripperServer::preempted(const Command& command) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return command.preempted;
+}
+
+void GripperServer::publishState() {
+  sensor_msgs::JointState joint_state;
+  joint_state.name = {arm_id_ + "_finger_joint1", arm_id_ + "_finger_joint2"};
+  joint_state.position.resize(2);
+  joint_state.velocity.assign(2, 0.0);
+  joint_state.effort.assign(2, 0.0);
+  GripperState state;
+
+  ros::Rate rate(publish_rate_);
+  while (ros::ok()) {
+    std::string error;
+    std::shared_ptr<franka::Gripper> gripper = connect(&error);
+    if (!gripper) {
+      ROS_ERROR_STREAM_THROTTLE(5.0, "GripperServer: " << error);
+      rate.sleep();
+      continue;
+    }
+    franka::GripperState gripper_state;
+    try {
+      gripper_state = gripper->readOnce();
+    } catch (const franka::Exception& ex) {
+      ROS_ERROR_STREAM_THROTTLE(5.0, "GripperServer: Could not read the gripper state: "
+                                         << ex.what());
+      std::lock_guard<std::mutex> lock(connect_mutex_);
+      if (gripper_ == gripper) {
+        gripper_.reset();
+      }
+      rate.sleep();
+      continue;
+    }
+    max_width_ = gripper_state.max_width;
+
+    state.header.stamp = ros::Time::now();
+    state.width = gripper_state.width;
+    state.max_width = gripper_state.max_width;
+    state.is_grasped = gripper_state.is_grasped;
+    state.temperature = gripper_state.temperature;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      state.busy = running_ != nullptr || pending_ != nullptr;
+    }
+    state_publisher_.publish(state);
+
+    joint_state.header.stamp = state.header.stamp;
+    joint_state.position[0] = 0.5 * gripper_state.width;
+    joint_state.position[1] = 0.5 * gripper_state.width;
+    joint_state_publisher_.publish(joint_state);
+    rate.sleep();
+  }
+}
+
+void GripperServer::shutdown() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  active_ = false;
+  if (pending_) {
+    finish(pending_.get(), false, "Gripper server shut down");
+    pending_.reset();
+  }
+  pending_changed_.notify_all();
+  preempt("Gripper server shut down", &lock);
+}
+
+void GripperServer::submit(const std::shared_ptr<Command>& command,
+                           std::unique_lock<std::mutex>* lock) {
+  if (pending_) {
+    finish(pending_.get(), false, "Preempted by a newer command");
+  }
+  pending_ = command;
+  pending_changed_.notify_all();
+  preempt("Preempted by a newer command", lock);
+}
+
+void GripperServer::preempt(const std::string& message, std::unique_lock<std::mutex>* lock) {
+  if (!running_ || running_->preempted) {
+    return;
+  }
+  running_->preempted = true;
+  finish(running_.get(), false, message);
+
+  // The running move or grasp returns once the gripper has stopped. A stop() that reaches the
+  // gripper before the command itself is lost, so stop again until run() has returned.
+  const std::shared_ptr<Command> command = running_;
+  ++stopping_;
+  while (running_ == command) {
+    std::shared_ptr<franka::Gripper> gripper;
+    {
+      std::lock_guard<std::mutex> connect_lock(connect_mutex_);
+      gripper = gripper_;
+    }
+    lock->unlock();
+    if (gripper) {
+      try {
+        gripper->stop();
+      } catch (const franka::Exception& ex) {
+        ROS_WARN_STREAM_THROTTLE(1.0, "GripperServer: Could not stop the gripper: " << ex.what());
+      }
+    }
+    lock->lock();
+    running_changed_.wait_for(*lock, kStopRetryInterval,
+                              [this, &command] { return running_ != command; });
+  }
+  --stopping_;
+  pending_changed_.notify_all();
+}
+
+void GripperServer::finish(Command* command, bool success, const std::string& message) {
+  if (!command->streamed) {
+    if (success) {
+      ROS_INFO_STREAM("GripperServer: " << message);
+    } else {
+      ROS_ERROR_STREAM("GripperServer: " << message);
+    }
+  } else if (!success && !command->preempted) {
+    ROS_WARN_STREAM("GripperServer: " << message);
+  }
+  command->success = success;
+  command->message = message;
+  command->done = true;
+  command_done_.notify_all();
+}
+
+bool GripperServer::commandCallback(GripperCommand::Request& request,
+                                    GripperCommand::Response& response) {
+  response.success = false;
+  if (request.command > GripperCommand::Request::HOMING) {
+    response.message = "Unknown command " + std::to_string(request.command);
+    return true;
+  }
+  const double max_width = max_width_;
+  const bool uses_width = request.command == GripperCommand::Request::GRASP ||
+                          request.command == GripperCommand::Request::MOVE;
+  if (uses_width && (!std::isfinite(request.width) || request.width < 0.0 ||
+                     (max_width > 0.0 && request.width > max_width))) {
+    response.message = "width must be in [0, " + std::to_string(max_width) + "]";
+    return true;
+  }
+  if (request.speed < 0.0 || request.force < 0.0 || request.epsilon_inner < 0.0 ||
+      request.epsilon_outer < 0.0) {
+    response.message = "speed, force and epsilons must not be negative";
+    return true;
+  }
+
+  auto command = std::make_shared<Command>();
+  command->type = request.command;
+  command->width = request.width;
+  command->speed = request.speed > 0.0 ? request.speed : default_speed_;
+  command->force = request.force > 0.0 ? request.force : default_force_;
+  command->epsilon_inner = request.epsilon_inner;
+  command->epsilon_outer = request.epsilon_outer;
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!active_) {
+    response.message = "Gripper server shut down";
+    return true;
+  }
+  submit(command, &lock);
+  command_done_.wait(lock, [&command] { return command->done; });
+
+  response.success = command->success;
+  response.message = command->message;
+  return true;
+}
+
+void GripperServer::widthCallback(const std_msgs::Float64& message) {
+  const double max_width = max_width_;
+  if (!std::isfinite(message.data) || message.data < 0.0 ||
+      (max_width > 0.0 && message.data > max_width)) {
+    ROS_WARN_STREAM_THROTTLE(1.0, "GripperServer: Ignoring width " << message.data
+                                                                   << " outside [0, "
+                                                                   << max_width << "]");
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!active_) {
+    return;
+  }
+  if (pending_ && pending_->streamed) {
+    // Not started yet, retarget it
+    pending_->width = message.data;
+    return;
+  }
+  if (!pending_ && running_ && running_->streamed && !running_->preempted &&
+      std::abs(running_->width - message.data) <= width_tolerance_) {
+    return;
+  }
+  auto command = std::make_shared<Command>();
+  command->type = GripperCommand::Request::MOVE;
+  command->width = message.data;
+  command->speed = default_speed_;
+  command->streamed = true;
+  submit(command, &lock);
+}
+
+bool GripperServer::stopCallback(std_srvs::Trigger::Request& /*request*/,
+                                 std_srvs::Trigger::Response& response) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (pending_) {
+    finish(pending_.get(), false, "Stopped");
+    pending_.reset();
+  }
+  const bool running = running_ != nullptr;
+  preempt("Stopped", &lock);
+  response.success = true;
+  response.message = running ? "Stopped" : "No command running";
+  return true;
+}
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+  ros::init(argc, argv, "libfranka_gripper_server");
+  ros::NodeHandle node_handle("~");
+
+  GripperServer server(node_handle);
+
+  // command blocks its service thread until the command is done, stop and newer commands must
+  // still get through
+  ros::AsyncSpinner spinner(4);
+  spinner.start();
+  std::thread state_publisher([&server] { server.publishState(); });
+  std::thread shutdown_watcher([&server] {
+    ros::waitForShutdown();
+    server.shutdown();
+  });
+
+  server.execute();
+  shutdown_watcher.join();
+  state_publisher.join();
+  return 0;
+}
@@ -0,0 +1,359 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+
+// Long-lived libfranka motion server: keeps the connection to the robot open and moves it through
+// queued sequences of named joint goals with WaypointMotionGenerator, without stopping at the
+// intermediate goals, instead of one process (connect, set the collision behavior, confirm,
+// move, disconnect) per goal as the libfranka_joint_goal_motion_generator* executables do. Goals
+// are read from ~joint_goals (config/joint_goals.yaml). Caution: like those executables it won't
+// work while franka_ros/franka_control is running!
+//
+// Services in the private namespace:
+//   move          MoveToJointGoals  queues the goals, returns once they are reached or it fails
+//   cancel        Trigger           drops the queued sequences, brakes the current one to a
+//                                   stop on its path, short of the goal it is heading for
+//   reload_goals  Trigger           re-reads ~joint_goals (e.g. after rosparam load)
+//
+// Usage:
+//   roslaunch franka_interactive_controllers libfranka_motion_server.launch
+//   rosservice call /libfranka_motion_server/move "{goals: [home, init_scoop], speed_factor: 0.0}"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <franka/exception.h>
+#include <franka/robot.h>
+
+#include <ros/callback_queue.h>
+#include <ros/ros.h>
+#include <std_srvs/Trigger.h>
+
+#include <franka_interactive_controllers/MoveToJointGoals.h>
+#include <joint_goals.h>
+#include <libfranka_waypoint_motion_generator.h>
+
+namespace {
+
+using franka_interactive_controllers::JointGoal;
+using franka_interactive_controllers::MoveToJointGoals;
+using franka_interactive_controllers::loadJointGoals;
+
+class MotionServer {
+ public:
+  explicit MotionServer(ros::NodeHandle& node_handle);
+
+  // Reads ~joint_goals, keeps the previous goals and returns false if any entry is invalid.
+  bool loadGoals(std::string* error);
+
+  // Runs the queued sequences until shutdown() is called.
+  void execute();
+  void shutdown();
+
+  // Queue of the cancel service, to be spun on its own
+  ros::CallbackQueue* cancelQueue() { return &cancel_queue_; }
+
+ private:
+  // One move request; the service thread waits on done while the executor moves the robot.
+  struct Sequence {
+    std::vector<std::string> names;
+    std::vector<JointGoal> goals;
+    double speed_factor{0.0};
+    bool done{false};
+    bool success{false};
+    std::string message;
+    uint32_t completed{0};
+  };
+
+  bool connect(std::string* error);
+  void run(Sequence* sequence);
+  void finish(Sequence* sequence, bool success, const std::string& message);
+
+  bool moveCallback(MoveToJointGoals::Request& request, MoveToJointGoals::Response& response);
+  bool cancelCallback(std_srvs::Trigger::Request& request, std_srvs::Trigger::Response& response);
+  bool reloadCallback(std_srvs::Trigger::Request& request, std_srvs::Trigger::Response& response);
+
+  ros::NodeHandle node_handle_;
+  std::string robot_ip_;
+  double default_speed_factor_{0.6};
+
+  // Owned by the executor; reset after a network error so the next goal reconnects
+  std::unique_ptr<franka::Robot> robot_;
+
+  std::mutex mutex_;
+  std::condition_variable queue_changed_;
+  std::condition_variable sequence_done_;
+  std::map<std::string, JointGoal> goals_;
+  std::deque<std::shared_ptr<Sequence>> queue_;
+  std::atomic<uint64_t> cancel_count_{0};
+  bool running_{true};
+
+  ros::CallbackQueue cancel_queue_;
+  ros::ServiceServer move_service_;
+  ros::ServiceServer cancel_service_;
+  ros::ServiceServer reload_service_;
+};
+
+MotionServer::MotionServer(ros::NodeHandle& node_handle) : node_handle_(node_handle) {
+  node_handle_.param<std::string>("robot_ip", robot_ip_, "172.16.0.2");
+  node_handle_.param<double>("speed_factor", default_speed_factor_, 0.6);
+  if (default_speed_factor_ <= 0.0 || default_speed_factor_ > 1.0) {
+    ROS_WARN_STREAM("MotionServer: speed_factor must be in (0, 1], using 0.6");
+    default_speed_factor_ = 0.6;
+  }
+
+  move_service_ = node_handle_.advertiseService("move", &MotionServer::moveCallback, this);
+  // Served apart from move, whose calls block their spinner threads until the sequence is done
+  ros::NodeHandle cancel_node_handle(node_handle_);
+  cancel_node_handle.setCallbackQueue(&cancel_queue_);
+  cancel_service_ =
+      cancel_node_handle.advertiseService("cancel", &MotionServer::cancelCallback, this);
+  reload_service_ =
+      node_handle_.advertiseService("reload_goals", &MotionServer::reloadCallback, this);
+}
+
+bool MotionServer::loadGoals(std::string* error) {
+  std::map<std::string, JointGoal> goals;
+  if (!loadJointGoals(node_handle_, "joint_goals", &goals, error)) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  goals_.swap(goals);
+  ROS_INFO_STREAM("MotionServer: loaded " << goals_.size() << " joint goals");
+  return true;
+}
+
+void MotionServer::execute() {
+  while (true) {
+    std::shared_ptr<Sequence> sequence;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      queue_changed_.wait(lock, [this] { return !queue_.empty() || !running_; });
+      if (!running_) {
+        break;
+      }
+      sequence = queue_.front();
+      queue_.pop_front();
+    }
+    run(sequence.get());
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const std::shared_ptr<Sequence>& sequence : queue_) {
+    sequence->done = true;
+    sequence->message = "Motion server shut down";
+  }
+  queue_.clear();
+  sequence_done_.notify_all();
+}
+
+void MotionServer::shutdown() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  running_ = false;
+  queue_changed_.notify_all();
+}
+
+bool MotionServer::connect(std::string* error) {
+  if (robot_) {
+    return true;
+  }
+  try {
+    robot_.reset(new franka::Robot(robot_ip_));
+    // Set additional parameters always before the control loop, NEVER in the control loop!
+    robot_->setCollisionBehavior(
+        {{20.0, 20.0, 20.0, 20.0, 20.0, 20.0, 20.0}}, {{20.0, 20.0, 20.0, 20.0, 20.0, 20.0, 20.0}},
+        {{10.0, 10.0, 10.0, 10.0, 10.0, 10.0, 10.0}}, {{10.0, 10.0, 10.0, 10.0, 10.0, 10.0, 10.0}},
+        {{20.0, 20.0, 20.0, 20.0, 20.0, 20.0}}, {{20.0, 20.0, 20.0, 20.0, 20.0, 20.0}},
+        {{10.0, 10.0, 10.0, 10.0, 10.0, 10.0}}, {{10.0, 10.0, 10.0, 10.0, 10.0, 10.0}});
+  } catch (const franka::Exception& ex) {
+    robot_.reset();
+    *error = std::string("Could not connect to ") + robot_ip_ + ": " + ex.what();
+    return false;
+  }
+  ROS_INFO_STREAM("MotionServer: connected to " << robot_ip_);
+  return true;
+}
+
+void MotionServer::run(Sequence* sequence) {
+  const uint64_t cancel_count = cancel_count_;
+  std::string error;
+  if (!connect(&error)) {
+    finish(sequence, false, error);
+    return;
+  }
+
+  // One control loop through all goals of the sequence, passing the intermediate ones without
+  // stopping
+  WaypointMotionGenerator motion_generator(sequence->speed_factor, sequence->goals);
+  bool cancelled = false;
+  bool stopped = false;
+  const std::string& goal = sequence->names.back();
+  ROS_INFO_STREAM("MotionServer: moving through " << sequence->goals.size() << " goals to "
+                                                  << goal);
+  try {
+    // Planned here rather than on the first tick of the control loop
+    motion_generator.plan(robot_->readOnce().q_d);
+    robot_->control([&](const franka::RobotState& robot_state, franka::Duration period) {
+      if (!cancelled && cancel_count_ != cancel_count) {
+        // Come to rest on the path instead, without allocating
+        cancelled = true;
+        stopped = motion_generator.stop(motion_generator.time());
+      }
+      return motion_generator(robot_state, period);
+    });
+  } catch (const franka::NetworkException& ex) {
+    robot_.reset();
+    sequence->completed = motion_generator.reachedWaypoints(motion_generator.time());
+    finish(sequence, false, "Lost the robot moving to " + goal + ": " + ex.what());
+    return;
+  } catch (const franka::ControlException& ex) {
+    sequence->completed = motion_generator.reachedWaypoints(motion_generator.time());
+    std::string message = "Aborted moving to " + goal + ": " + ex.what();
+    try {
+      robot_->automaticErrorRecovery();
+    } catch (const franka::Exception& recovery_ex) {
+      robot_.reset();
+      message += std::string(" (error recovery failed: ") + recovery_ex.what() + ")";
+    }
+    finish(sequence, false, message);
+    return;
+  } catch (const franka::Exception& ex) {
+    finish(sequence, false, "Could not move to " + goal + ": " + ex.what());
+    return;
+  }
+
+  if (stopped) {
+    // The last via point of the stopped motion is where it rests, not a goal
+    sequence->completed = motion_generator.reachedWaypoints(motion_generator.duration()) - 1;
+    Eigen::Matrix<double, 7, 1> q_rest;
+    motion_generator.position(motion_generator.duration(), &q_rest);
+    std::ostringstream message;
+    message << "Cancelled after "
+            << (sequence->completed > 0 ? sequence->names[sequence->completed - 1]
+                                        : std::string("the start"))
+            << ", stopped at [" << q_rest.transpose().format(Eigen::IOFormat(4, 0, ", "))
+            << "]";
+    finish(sequence, false, message.str());
+    return;
+  }
+  sequence->completed = motion_generator.reachedWaypoints(motion_generator.time());
+  finish(sequence, true, "Reached " + std::to_string(sequence->completed) + " goals");
+}
+
+void MotionServer::finish(Sequence* sequence, bool success, const std::string& message) {
+  if (success) {
+    ROS_INFO_STREAM("MotionServer: " << message);
+  } else {
+    ROS_ERROR_STREAM("MotionServer: " << message);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  sequence->success = success;
+  sequence->message = message;
+  sequence->done = true;
+  sequence_done_.notify_all();
+}
+
+bool MotionServer::moveCallback(MoveToJointGoals::Request& request,
+                                MoveToJointGoals::Response& response) {
+  response.success = false;
+  response.completed = 0;
+  if (request.goals.empty()) {
+    response.message = "No goals given";
+    return true;
+  }
+  if (request.speed_factor < 0.0 || request.speed_factor > 1.0) {
+    response.message = "speed_factor must be in (0, 1], or 0 for the default";
+    return true;
+  }
+
+  auto sequence = std::make_shared<Sequence>();
+  sequence->names = request.goals;
+  sequence->speed_factor =
+      request.speed_factor > 0.0 ? request.speed_factor : default_speed_factor_;
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (const std::string& name : request.goals) {
+    auto goal = goals_.find(name);
+    if (goal == goals_.end()) {
+      response.message = "Unknown joint goal " + name;
+      return true;
+    }
+    sequence->goals.push_back(goal->second);
+  }
+  if (!running_) {
+    response.message = "Motion server shut down";
+    return true;
+  }
+  queue_.push_back(sequence);
+  queue_changed_.notify_all();
+  sequence_done_.wait(lock, [&sequence] { return sequence->done; });
+
+  response.success = sequence->success;
+  response.message = sequence->message;
+  response.completed = sequence->completed;
+  return true;
+}
+
+bool MotionServer::cancelCallback(std_srvs::Trigger::Request& /*request*/,
+                                  std_srvs::Trigger::Response& response) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++cancel_count_;
+  for (const std::shared_ptr<Sequence>& sequence : queue_) {
+    sequence->done = true;
+    sequence->message = "Cancelled";
+  }
+  response.message = "Cancelled " + std::to_string(queue_.size()) + " queued sequences";
+  queue_.clear();
+  sequence_done_.notify_all();
+  response.success = true;
+  return true;
+}
+
+bool MotionServer::reloadCallback(std_srvs::Trigger::Request& /*request*/,
+                                  std_srvs::Trigger::Response& response) {
+  response.success = loadGoals(&response.message);
+  if (response.success) {
+    response.message = "Joint goals reloaded";
+  }
+  return true;
+}
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+  ros::init(argc, argv, "libfranka_motion_server");
+  ros::NodeHandle node_handle("~");
+
+  MotionServer server(node_handle);
+  std::string error;
+  if (!server.loadGoals(&error)) {
+    ROS_ERROR_STREAM("MotionServer: " << error);
+    return -1;
+  }
+  ROS_WARN_STREAM("MotionServer: move requests will move the robot! "
+                  << "Please make sure to have the user stop button at hand!");
+
+  // move blocks its service thread until the sequence is done; cancel has its own spinner, so it
+  // still gets through however many move calls are waiting
+  ros::AsyncSpinner spinner(4);
+  spinner.start();
+  ros::AsyncSpinner cancel_spinner(1, server.cancelQueue());
+  cancel_spinner.start();
+  std::thread shutdown_watcher([&server] {
+    ros::waitForShutdown();
+    server.shutdown();
+  });
+
+  server.execute();
+  shutdown_watcher.join();
+  return 0;
+}
@@ -0,0 +1,136 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Validates PandaDynamics against robot states recorded from franka_control, best in a torque
+// controller (e.g. joint_gravity_compensation_controller) while moving the arm by commands, not
+// by hand:
+//   rostopic echo -p /franka_state_controller/franka_states > franka_states.csv
+//   rosrun franka_interactive_controllers panda_dynamics_check franka_states.csv [tolerance_Nm]
+// The load is taken from the recording (m_total, F_x_Ctotal, I_total). Per joint it reports the
+// RMS and maximum of
+//   gravity:  tau_J - tau_J_d - g(q), the robot adding its gravity model to the command
+//   dynamics: tau_J - (M(q) ddq + c(q, dq) + g(q)), ddq by central differences of dq
+// tau_J being the measured link-side torques. Exits with 1 if the RMS of the dynamics residual
+// of a joint exceeds the tolerance (default 2 Nm).
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <Eigen/StdVector>
+
+#include <franka_states_csv.h>
+#include <panda_dynamics.h>
+
+namespace {
+
+using franka_interactive_controllers::PandaDynamics;
+using Vector7d = PandaDynamics::Vector7d;
+
+struct Sample {
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  double time;
+  Vector7d q, dq, tau_J, tau_J_d;
+};
+
+struct Residual {
+  Vector7d sum_squares{Vector7d::Zero()};
+  Vector7d max{Vector7d::Zero()};
+  size_t count{0};
+
+  void add(const Vector7d& residual) {
+    sum_squares += residual.cwiseAbs2();
+    max = max.cwiseMax(residual.cwiseAbs());
+    ++count;
+  }
+  Vector7d rms() const { return (sum_squares / std::max<size_t>(count, 1)).cwiseSqrt(); }
+};
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+  using franka_interactive_controllers::FrankaStatesCsv;
+
+  if (argc < 2 || argc > 3) {
+    std::cerr << "Usage: " << argv[0] << " <franka_states.csv> [tolerance_Nm]" << std::endl;
+    return -1;
+  }
+  const double tolerance = argc > 2 ? std::atof(argv[2]) : 2.0;
+
+  FrankaStatesCsv csv;
+  if (!csv.open(argv[1])) {
+    std::cerr << "Could not read " << argv[1] << std::endl;
+    return -1;
+  }
+  const std::vector<size_t> time_column = csv.columns("%time", 0);
+  const std::vector<size_t> q_columns = csv.columns("q", 7);
+  const std::vector<size_t> dq_columns = csv.columns("dq", 7);
+  const std::vector<size_t> tau_columns = csv.columns("tau_J", 7);
+  const std::vector<size_t> tau_d_columns = csv.columns("tau_J_d", 7);
+  const std::vector<size_t> mass_column = csv.columns("m_total", 0);
+  const std::vector<size_t> com_columns = csv.columns("F_x_Ctotal", 3);
+  const std::vector<size_t> inertia_columns = csv.columns("I_total", 9);
+  if (time_column.empty() || q_columns.empty() || dq_columns.empty() || tau_columns.empty() ||
+      tau_d_columns.empty() || mass_column.empty() || com_columns.empty() ||
+      inertia_columns.empty()) {
+    std::cerr << "Expected the columns %time, field.q*, field.dq*, field.tau_J*, field.tau_J_d*, "
+                 "field.m_total, field.F_x_Ctotal* and field.I_total* of a "
+                 "franka_msgs/FrankaState recording"
+              << std::endl;
+    return -1;
+  }
+
+  std::vector<Sample, Eigen::aligned_allocator<Sample>> samples;
+  PandaDynamics::Load load;
+  while (csv.next()) {
+    Sample sample;
+    sample.time = csv.value(time_column[0]) * 1e-9;
+    csv.values(q_columns, &sample.q);
+    csv.values(dq_columns, &sample.dq);
+    csv.values(tau_columns, &sample.tau_J);
+    csv.values(tau_d_columns, &sample.tau_J_d);
+    if (samples.empty()) {
+      load.mass = csv.value(mass_column[0]);
+      csv.values(com_columns, &load.center_of_mass);
+      csv.values(inertia_columns, &load.inertia);
+    }
+    samples.push_back(sample);
+  }
+  if (samples.size() < 3) {
+    std::cerr << "Need at least 3 samples in " << argv[1] << std::endl;
+    return -1;
+  }
+
+  const PandaDynamics dynamics(load);
+  const Eigen::Vector3d gravity_earth(0.0, 0.0, -9.81);
+  Residual gravity_residual, dynamics_residual;
+  for (size_t i = 1; i + 1 < samples.size(); ++i) {
+    const Sample& sample = samples[i];
+    const double dt = samples[i + 1].time - samples[i - 1].time;
+    if (dt <= 0.0) {
+      continue;
+    }
+    const Vector7d ddq = (samples[i + 1].dq - samples[i - 1].dq) / dt;
+    Vector7d gravity, tau;
+    dynamics.gravityVector(sample.q, gravity_earth, &gravity);
+    dynamics.inverseDynamics(sample.q, sample.dq, ddq, gravity_earth, &tau);
+    gravity_residual.add(sample.tau_J - sample.tau_J_d - gravity);
+    dynamics_residual.add(sample.tau_J - tau);
+  }
+
+  std::cout << dynamics_residual.count << " samples, load " << load.mass << " kg" << std::endl
+            << std::fixed << std::setprecision(3)
+            << "joint  gravity rms  gravity max  dynamics rms  dynamics max [Nm]" << std::endl;
+  bool passed = true;
+  for (int j = 0; j < PandaDynamics::kJoints; ++j) {
+    std::cout << std::setw(5) << j + 1 << std::setw(13) << gravity_residual.rms()(j)
+              << std::setw(13) << gravity_residual.max(j) << std::setw(14)
+              << dynamics_residual.rms()(j) << std::setw(14) << dynamics_residual.max(j)
+              << std::endl;
+    passed = passed && dynamics_residual.rms()(j) <= tolerance;
+  }
+  std::cout << (passed ? "OK" : "FAILED") << std::endl;
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+// Copyright (c) 2017 Franka Emika GmbH
+// Use of this source code is governed by the Apache-2.0 license, see LICENSE
+//
+// Validates PandaKinematics against robot states recorded from franka_control:
+//   rostopic echo -p /franka_state_controller/franka_states > franka_states.csv
+//   rosrun franka_interactive_controllers panda_kinematics_check franka_states.csv
+//         [position_tolerance_m] [orientation_tolerance_rad]
+// For every line, O_T_EE is recomputed from q and the recorded F_T_EE and compared with the
+// recorded O_T_EE. Exits with 1 if the worst error exceeds the tolerances (default 1e-5 m and
+// 1e-4 rad).
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+#include <Eigen/Geometry>
+
+#include <franka_states_csv.h>
+#include <panda_kinematics.h>
+
+int main(int argc, char** argv) {
+  using franka_interactive_controllers::FrankaStatesCsv;
+  using franka_interactive_controllers::PandaKinematics;
+
+  if (argc < 2 || argc > 4) {
+    std::cerr << "Usage: " << argv[0]
+              << " <franka_states.csv> [position_tolerance_m] [orientation_tolerance_rad]"
+              << std::endl;
+    return -1;
+  }
+  const double position_tolerance = argc > 2 ? std::atof(argv[2]) : 1e-5;
+  const double orientation_tolerance = argc > 3 ? std::atof(argv[3]) : 1e-4;
+
+  FrankaStatesCsv csv;
+  if (!csv.open(argv[1])) {
+    std::cerr << "Could not read " << argv[1] << std::endl;
+    return -1;
+  }
+  const std::vector<size_t> q_columns = csv.columns("q", 7);
+  const std::vector<size_t> pose_columns = csv.columns("O_T_EE", 16);
+  const std::vector<size_t> flange_columns = csv.columns("F_T_EE", 16);
+  if (q_columns.empty() || pose_columns.empty() || flange_columns.empty()) {
+    std::cerr << "Expected the columns field.q*, field.O_T_EE* and field.F_T_EE* of a "
+                 "franka_msgs/FrankaState recording"
+              << std::endl;
+    return -1;
+  }
+
+  size_t samples = 0;
+  double max_position_error = 0.0, max_orientation_error = 0.0;
+  double sum_position_error = 0.0;
+  PandaKinematics<>::Result kinematics;
+  while (csv.next()) {
+    PandaKinematics<>::JointVector q;
+    Eigen::Matrix4d recorded_pose, F_T_EE;
+    csv.values(q_columns, &q);
+    csv.values(pose_columns, &recorded_pose);
+    csv.values(flange_columns, &F_T_EE);
+    PandaKinematics<>::compute(q, F_T_EE, Eigen::Matrix4d::Identity(), &kinematics);
+
+    const double position_error =
+        (kinematics.O_T_EE.topRightCorner<3, 1>() - recorded_pose.topRightCorner<3, 1>()).norm();
+    const Eigen::AngleAxisd rotation_error(kinematics.O_T_EE.topLeftCorner<3, 3>() *
+                                           recorded_pose.topLeftCorner<3, 3>().transpose());
+    max_position_error = std::max(max_position_error, position_error);
+    max_orientation_error = std::max(max_orientation_error, std::abs(rotation_error.angle()));
+    sum_position_error += position_error;
+    ++samples;
+  }
+  if (samples == 0) {
+    std::cerr << "No samples in " << argv[1] << std::endl;
+    return -1;
+  }
+
+  std::cout << samples << " samples" << std::endl
+            << "position error:    max " << max_position_error << " m, mean "
+            << sum_position_error / samples << " m" << std::endl
+            << "orientation error: max " << max_orientation_error << " rad" << std::endl;
+  const bool passed =
+      max_position_error <= position_tolerance && max_orientation_error <= orientation_tolerance;
+  std::cout << (passed ? "OK" : "FAILED") << std::endl;
+  return passed ? 0 : 1;
+}